@@ -0,0 +1,666 @@
+#include "AK/Types.h"
+#include "Image.h"
+#include "Renderer/DistributedRender.h"
+#include "Renderer/EnvironmentLight.h"
+#include "Renderer/Framebuffer.h"
+#include "Renderer/IrradianceProbes.h"
+#include "Renderer/Raytracer.h"
+#include "Renderer/RaytracerScenes.h"
+#include "Renderer/RaytracerSerialization.h"
+#include "Renderer/RenderSequence.h"
+#include "Renderer/RenderServer.h"
+#include "Renderer/RotateYHittable.h"
+#include "Renderer/TranslateHittable.h"
+
+#include <glm/gtx/rotate_vector.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct Options
+{
+    std::string scene = {};
+    std::optional<i32> width = {};
+    std::optional<i32> height = {};
+    std::optional<i32> samples_per_pixel = {};
+    std::optional<i32> max_depth = {};
+    i32 threads = 0;
+    std::string output = "./output/image.ppm";
+    std::string export_path = {};
+    std::optional<std::string> bvh_cache_directory = {};
+    std::string image_cache_directory = "./cache/textures/";
+    i32 bake_resolution = 0;
+    u32 enabled_aovs = 0;
+    i32 seed = 0;
+    std::string checkpoint_path = {};
+    i32 checkpoint_interval = 60;
+    bool resume = false;
+    i32 workers = 0;
+    bool is_worker = false;
+    std::string serve_socket = {};
+    i32 frames = 0;
+    i32 frame_rate = 24;
+    i32 turntable_degrees = 0;
+    i32 spin_degrees = 0;
+    bool temporal = false;
+    float shutter = 0.0f;
+    std::optional<float> aperture = {};
+    std::optional<float> focus_distance = {};
+    PhotonMapSettings photon_map = {};
+    PathGuideSettings path_guide = {};
+    RenderBudget budget = {};
+    i32 hit_cache_strata = 0;
+    std::string environment_path = {};
+    std::string probes_path = {};
+    i32 probe_grid = 8;
+    i32 probe_rays = 256;
+};
+
+static void print_usage()
+{
+    std::cout << "Usage: raytrace <scene> [options]\n"
+              << "\n"
+              << "  <scene>                        Name of a built-in scene or path to a scene file (.txt, .yaml, .yml)\n"
+              << "  -w, --width <n>                Image width in pixels\n"
+              << "  -h, --height <n>               Image height in pixels, defaults to the aspect ratio of the scene\n"
+              << "  -s, --spp <n>                  Samples per pixel\n"
+              << "  -d, --depth <n>                Maximum number of bounces\n"
+              << "      --time <seconds>           Render passes until the time is up instead of a fixed number of samples\n"
+              << "      --target-error <e>         Render passes until the estimated relative RMSE is below e, --time limits it\n"
+              << "      --max-spp <n>              Most samples per pixel --time and --target-error take (default 65536)\n"
+              << "  -t, --threads <n>              Number of render threads, 0 uses every hardware thread (default)\n"
+              << "  -o, --output <path>            Output image, .ppm or .pfm (default ./output/image.ppm)\n"
+              << "      --aov <name>               Also write the given AOV layer next to the output, can be repeated\n"
+              << "      --export <path>            Write the scene with the applied options to a scene file instead of rendering it\n"
+              << "      --bvh-cache <dir>          Directory of the BVH cache, 'off' disables it (default ./cache/bvh/)\n"
+              << "      --tex-cache <dir>          Directory of converted images, 'off' disables it (default ./cache/textures/)\n"
+              << "      --bake <n>                 Bake noise textures into grids with n cells on the longest axis, 0 disables (default)\n"
+              << "      --seed <n>                 Seed of the random sequences, the same seed renders the same image (default 0)\n"
+              << "      --checkpoint <path>        Periodically save the progress of the render to the given file\n"
+              << "      --checkpoint-interval <s>  Seconds between checkpoints (default 60)\n"
+              << "      --resume                   Continue the render from the checkpoint file if it matches the scene\n"
+              << "      --workers <n>              Split the render across n worker processes and merge their rows\n"
+              << "      --serve <socket>           Run as a render server on the given Unix socket instead of rendering a scene\n"
+              << "      --frames <n>               Render an animation of n frames, numbered next to the output\n"
+              << "      --fps <n>                  Frame rate of the animation (default 24)\n"
+              << "      --turntable <degrees>      Orbit the camera around the scene by the given angle over the animation\n"
+              << "      --spin <degrees>           Rotate every rotated instance by the given angle over the animation\n"
+              << "      --temporal                 Reuse the samples of pixels nothing moved in from the previous frame\n"
+              << "      --shutter <fraction>       Part of every frame the shutter is open for, blurs moving instances (default 0)\n"
+              << "      --aperture <size>          Lens diameter in world units, blurs everything off the plane in focus\n"
+              << "      --focus-distance <d>       Distance of the plane in focus from the camera\n"
+              << "      --hit-cache <n>            Cache the first hits of n camera rays per pixel and reuse them, 0 disables (default)\n"
+              << "      --photons <n>              Trace n photons per pass for a caustics photon map, 0 disables (default)\n"
+              << "      --photon-passes <n>        Progressive photon map passes with shrinking radii (default 1)\n"
+              << "      --photon-radius <r>        Gather radius of the first pass, 0 picks one from the photons (default)\n"
+              << "      --guide <n>                Learn where the light comes from in n training passes and guide diffuse bounces there\n"
+              << "      --guide-bsdf <fraction>    Part of the guided bounces still sampled from the BSDF (default 0.5)\n"
+              << "      --environment <path>       Light the scene with an equirectangular HDR image instead of the background color\n"
+              << "      --bake-probes <path>       Bake an irradiance probe grid over the scene to the given file instead of rendering\n"
+              << "      --probe-grid <n>           Probes along the longest axis of the scene (default 8)\n"
+              << "      --probe-rays <n>           Rays traced from every probe (default 256)\n"
+              << "\n"
+              << "Scenes:";
+
+    for (auto const& name : RaytracerScenes::names())
+    {
+        std::cout << ' ' << name;
+    }
+
+    std::cout << "\nAOV layers:";
+
+    for (u32 i = 1; i < static_cast<u32>(AOVType::Count); ++i)
+    {
+        std::cout << ' ' << Framebuffer::aov_name(static_cast<AOVType>(i));
+    }
+
+    std::cout << '\n';
+}
+
+static std::optional<i32> parse_int(std::string_view const value)
+{
+    i32 result = 0;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if (error != std::errc() || end != value.data() + value.size())
+        return std::nullopt;
+
+    return result;
+}
+
+static std::optional<float> parse_float(std::string_view const value)
+{
+    float result = 0.0f;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if (error != std::errc() || end != value.data() + value.size())
+        return std::nullopt;
+
+    return result;
+}
+
+static std::optional<AOVType> parse_aov(std::string_view const value)
+{
+    for (u32 i = 0; i < static_cast<u32>(AOVType::Count); ++i)
+    {
+        if (Framebuffer::aov_name(static_cast<AOVType>(i)) == value)
+            return static_cast<AOVType>(i);
+    }
+
+    return std::nullopt;
+}
+
+// Workers get the same command line, so they load the same scene with the same settings, and render on a single thread each.
+static std::vector<std::string> worker_command(i32 const argc, char** argv)
+{
+    std::vector<std::string> command = {};
+
+    for (i32 i = 0; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--workers")
+        {
+            i += 1;
+            continue;
+        }
+
+        command.emplace_back(argv[i]);
+    }
+
+    command.emplace_back("--worker");
+    command.emplace_back("--threads");
+    command.emplace_back("1");
+
+    return command;
+}
+
+static bool parse_options(i32 const argc, char** argv, Options& options)
+{
+    for (i32 i = 1; i < argc; ++i)
+    {
+        std::string_view const argument = argv[i];
+
+        if (argument.empty() || argument[0] != '-')
+        {
+            if (!options.scene.empty())
+            {
+                std::cerr << "Only one scene can be rendered at a time, got '" << options.scene << "' and '" << argument << "'.\n";
+                return false;
+            }
+
+            options.scene = argument;
+            continue;
+        }
+
+        if (argument == "--resume")
+        {
+            options.resume = true;
+            continue;
+        }
+
+        if (argument == "--temporal")
+        {
+            options.temporal = true;
+            continue;
+        }
+
+        // Internal, set by the coordinator of --workers on the processes it starts.
+        if (argument == "--worker")
+        {
+            options.is_worker = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << argument << ".\n";
+            return false;
+        }
+
+        std::string_view const value = argv[++i];
+
+        if (argument == "-o" || argument == "--output")
+        {
+            options.output = value;
+            continue;
+        }
+
+        if (argument == "--bvh-cache")
+        {
+            options.bvh_cache_directory = value == "off" ? std::string() : std::string(value);
+            continue;
+        }
+
+        if (argument == "--tex-cache")
+        {
+            options.image_cache_directory = value == "off" ? std::string() : std::string(value);
+            continue;
+        }
+
+        if (argument == "--serve")
+        {
+            options.serve_socket = value;
+            continue;
+        }
+
+        if (argument == "--checkpoint")
+        {
+            options.checkpoint_path = value;
+            continue;
+        }
+
+        if (argument == "--environment")
+        {
+            options.environment_path = value;
+            continue;
+        }
+
+        if (argument == "--bake-probes")
+        {
+            options.probes_path = value;
+            continue;
+        }
+
+        if (argument == "--export")
+        {
+            options.export_path = value;
+            continue;
+        }
+
+        if (argument == "--aov")
+        {
+            auto const aov = parse_aov(value);
+
+            if (!aov.has_value())
+            {
+                std::cerr << "Unknown AOV layer '" << value << "'.\n";
+                return false;
+            }
+
+            options.enabled_aovs |= Framebuffer::aov_bit(*aov);
+            continue;
+        }
+
+        if (argument == "--shutter" || argument == "--aperture" || argument == "--focus-distance" || argument == "--photon-radius"
+            || argument == "--guide-bsdf" || argument == "--time" || argument == "--target-error")
+        {
+            auto const real = parse_float(value);
+
+            if (!real.has_value() || *real < 0.0f)
+            {
+                std::cerr << "Invalid value '" << value << "' for " << argument << ".\n";
+                return false;
+            }
+
+            if (argument == "--shutter")
+                options.shutter = *real;
+            else if (argument == "--aperture")
+                options.aperture = *real;
+            else if (argument == "--photon-radius")
+                options.photon_map.radius = *real;
+            else if (argument == "--guide-bsdf")
+                options.path_guide.bsdf_fraction = *real;
+            else if (argument == "--time")
+                options.budget.seconds = *real;
+            else if (argument == "--target-error")
+                options.budget.target_error = *real;
+            else
+                options.focus_distance = *real;
+
+            continue;
+        }
+
+        auto const number = parse_int(value);
+
+        if (!number.has_value() || *number < 0)
+        {
+            std::cerr << "Invalid value '" << value << "' for " << argument << ".\n";
+            return false;
+        }
+
+        if (argument == "-w" || argument == "--width")
+        {
+            options.width = *number;
+        }
+        else if (argument == "-h" || argument == "--height")
+        {
+            options.height = *number;
+        }
+        else if (argument == "-s" || argument == "--spp")
+        {
+            options.samples_per_pixel = *number;
+        }
+        else if (argument == "-d" || argument == "--depth")
+        {
+            options.max_depth = *number;
+        }
+        else if (argument == "--max-spp")
+        {
+            options.budget.max_samples_per_pixel = static_cast<u32>(*number);
+        }
+        else if (argument == "-t" || argument == "--threads")
+        {
+            options.threads = *number;
+        }
+        else if (argument == "--bake")
+        {
+            options.bake_resolution = *number;
+        }
+        else if (argument == "--seed")
+        {
+            options.seed = *number;
+        }
+        else if (argument == "--checkpoint-interval")
+        {
+            options.checkpoint_interval = *number;
+        }
+        else if (argument == "--hit-cache")
+        {
+            options.hit_cache_strata = *number;
+        }
+        else if (argument == "--photons")
+        {
+            options.photon_map.photon_count = *number;
+        }
+        else if (argument == "--photon-passes")
+        {
+            options.photon_map.pass_count = *number;
+        }
+        else if (argument == "--guide")
+        {
+            options.path_guide.iteration_count = *number;
+        }
+        else if (argument == "--workers")
+        {
+            options.workers = *number;
+        }
+        else if (argument == "--frames")
+        {
+            options.frames = *number;
+        }
+        else if (argument == "--fps")
+        {
+            options.frame_rate = *number;
+        }
+        else if (argument == "--turntable")
+        {
+            options.turntable_degrees = *number;
+        }
+        else if (argument == "--spin")
+        {
+            options.spin_degrees = *number;
+        }
+        else if (argument == "--probe-grid")
+        {
+            options.probe_grid = *number;
+        }
+        else if (argument == "--probe-rays")
+        {
+            options.probe_rays = *number;
+        }
+        else
+        {
+            std::cerr << "Unknown option " << argument << ".\n";
+            return false;
+        }
+    }
+
+    if (options.scene.empty() && options.serve_socket.empty())
+    {
+        std::cerr << "No scene given.\n";
+        return false;
+    }
+
+    if (options.resume && options.checkpoint_path.empty())
+    {
+        std::cerr << "--resume needs a --checkpoint file.\n";
+        return false;
+    }
+
+    if (options.frames > 0 && options.workers > 0)
+    {
+        std::cerr << "Animations cannot be split across --workers yet.\n";
+        return false;
+    }
+
+    if (options.budget.target_error > 0.0f)
+    {
+        options.budget.mode = RenderBudgetMode::Error;
+    }
+    else if (options.budget.seconds > 0.0)
+    {
+        options.budget.mode = RenderBudgetMode::Time;
+    }
+
+    if (options.budget.mode != RenderBudgetMode::Samples && (options.frames > 0 || options.workers > 0))
+    {
+        std::cerr << "--time and --target-error only work for single renders on this process.\n";
+        return false;
+    }
+
+    return true;
+}
+
+static AABB scene_bounds(Raytracer const& raytracer)
+{
+    AABB bounds = AABB::empty;
+
+    for (auto const& hittable : raytracer.get_hittables())
+    {
+        bounds = AABB(bounds, hittable->bounding_box());
+    }
+
+    return bounds;
+}
+
+// One camera keyframe per frame, orbiting around the point of the view axis closest to the center of the scene.
+static std::vector<Keyframe<RaytracerCamera>> turntable_track(Raytracer const& raytracer, float const degrees, i32 const frame_count,
+                                                              float const frame_rate)
+{
+    AABB const bounds = scene_bounds(raytracer);
+
+    RaytracerCamera const camera = raytracer.get_camera();
+    glm::vec3 const center = glm::vec3(bounds.x.min + bounds.x.max, bounds.y.min + bounds.y.max, bounds.z.min + bounds.z.max) * 0.5f;
+
+    // The camera looks along -front.
+    glm::vec3 const view = -camera.get_front();
+    glm::vec3 const pivot = camera.position + view * glm::dot(center - camera.position, view);
+
+    std::vector<Keyframe<RaytracerCamera>> keyframes = {};
+
+    for (i32 frame = 0; frame < frame_count; ++frame)
+    {
+        float const angle = degrees * static_cast<float>(frame) / static_cast<float>(frame_count);
+
+        RaytracerCamera key = camera;
+        key.position = pivot + glm::rotateY(camera.position - pivot, glm::radians(angle));
+        key.euler_angles.y += angle;
+
+        keyframes.emplace_back(static_cast<float>(frame) / frame_rate, key);
+    }
+
+    return keyframes;
+}
+
+static void add_spin_tracks(RenderSequence& sequence, Raytracer const& raytracer, float const degrees, i32 const frame_count,
+                            float const frame_rate)
+{
+    float const end_time = static_cast<float>(frame_count) / frame_rate;
+
+    for (auto const& hittable : raytracer.get_hittables())
+    {
+        auto const instance = std::dynamic_pointer_cast<TranslateHittable>(hittable);
+
+        if (instance == nullptr)
+            continue;
+
+        auto const rotated = std::dynamic_pointer_cast<RotateYHittable>(instance->hittable());
+
+        if (rotated == nullptr)
+            continue;
+
+        InstancePose const start = {instance->offset(), rotated->angle()};
+        InstancePose const end = {instance->offset(), rotated->angle() + degrees};
+
+        sequence.add_instance_track(instance, {{0.0f, start}, {end_time, end}});
+    }
+}
+
+i32 main(i32 const argc, char** argv)
+{
+    Options options = {};
+
+    if (!parse_options(argc, argv, options))
+    {
+        print_usage();
+        return 1;
+    }
+
+    // Images are loaded while the scene is built.
+    Image::set_cache_directory(options.image_cache_directory);
+
+    // Scenes come with the jobs, the options only set up the server.
+    if (!options.serve_socket.empty())
+        return RenderServer::create(options.threads)->run(options.serve_socket) ? 0 : 1;
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    auto const raytracer = Raytracer::create();
+
+    if (RaytracerSerialization::is_scene_file(options.scene))
+    {
+        if (!RaytracerSerialization::load(options.scene, *raytracer))
+            return 1;
+    }
+    else if (!RaytracerScenes::build(options.scene, *raytracer))
+    {
+        std::cerr << "Unknown scene '" << options.scene << "'.\n";
+        print_usage();
+        return 1;
+    }
+
+    // Command line options override the defaults of the scene.
+    if (options.width.has_value())
+        raytracer->set_image_width(*options.width);
+
+    if (options.height.has_value())
+        raytracer->set_aspect_ratio(static_cast<float>(raytracer->get_image_width()) / static_cast<float>(*options.height));
+
+    if (options.samples_per_pixel.has_value())
+        raytracer->set_samples_per_pixel(*options.samples_per_pixel);
+
+    if (options.max_depth.has_value())
+        raytracer->set_max_depth(*options.max_depth);
+
+    if (options.aperture.has_value() || options.focus_distance.has_value())
+    {
+        RaytracerCamera camera = raytracer->get_camera();
+        camera.aperture = options.aperture.value_or(camera.aperture);
+        camera.focus_distance = options.focus_distance.value_or(camera.focus_distance);
+        raytracer->set_camera(camera);
+    }
+
+    if (!options.environment_path.empty())
+    {
+        auto const environment = EnvironmentLight::create(options.environment_path);
+
+        if (environment == nullptr)
+            return 1;
+
+        raytracer->set_environment(environment);
+    }
+
+    raytracer->set_thread_count(options.threads);
+    raytracer->set_texture_bake_resolution(options.bake_resolution);
+    raytracer->set_primary_hit_cache(options.hit_cache_strata);
+    raytracer->set_photon_map_settings(options.photon_map);
+    raytracer->set_path_guide_settings(options.path_guide);
+    raytracer->set_render_budget(options.budget);
+    raytracer->set_output_path(options.output);
+    raytracer->set_enabled_aovs(options.enabled_aovs);
+    raytracer->set_seed(static_cast<u64>(options.seed));
+    raytracer->set_checkpoint(options.checkpoint_path, static_cast<double>(options.checkpoint_interval));
+    raytracer->set_resume(options.resume);
+
+    if (options.bvh_cache_directory.has_value())
+        raytracer->set_bvh_cache_directory(*options.bvh_cache_directory);
+
+    std::chrono::duration<double> const scene_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Scene setup time: " << scene_time.count() << " s\n";
+
+    if (!options.export_path.empty())
+    {
+        if (!RaytracerSerialization::save(options.export_path, *raytracer, std::filesystem::path(options.scene).stem().string()))
+            return 1;
+
+        std::clog << "Exported '" << options.scene << "' to " << options.export_path << "\n";
+        return 0;
+    }
+
+    raytracer->initialize();
+
+    if (options.is_worker)
+        return DistributedRender::serve(*raytracer) ? 0 : 1;
+
+    if (!options.probes_path.empty())
+    {
+        AABB const bounds = scene_bounds(*raytracer);
+        auto const probes = IrradianceProbes::create(bounds, IrradianceProbes::counts_for(bounds, options.probe_grid));
+        i32 const hardware_threads = static_cast<i32>(std::max(1u, std::thread::hardware_concurrency()));
+        i32 const thread_count = options.threads > 0 ? options.threads : hardware_threads;
+
+        probes->bake(*raytracer, std::max(1, options.probe_rays), thread_count, static_cast<u64>(options.seed));
+
+        if (!probes->save(options.probes_path))
+            return 1;
+
+        std::clog << "Baked irradiance probes of '" << options.scene << "' to " << options.probes_path << "\n";
+        return 0;
+    }
+
+    std::clog << "Rendering '" << options.scene << "' at " << raytracer->get_image_width() << "x" << raytracer->get_image_height()
+              << ", " << raytracer->get_samples_per_pixel() << " spp, depth " << raytracer->get_max_depth() << "\n";
+
+    if (options.frames > 0)
+    {
+        auto const sequence = RenderSequence::create(raytracer);
+        auto const frame_rate = static_cast<float>(options.frame_rate);
+
+        sequence->set_frame_rate(frame_rate);
+        sequence->set_temporal_accumulation(options.temporal);
+        sequence->set_shutter(options.shutter);
+
+        if (options.turntable_degrees != 0)
+        {
+            auto const degrees = static_cast<float>(options.turntable_degrees);
+            sequence->set_camera_track(turntable_track(*raytracer, degrees, options.frames, frame_rate));
+        }
+
+        if (options.spin_degrees != 0)
+            add_spin_tracks(*sequence, *raytracer, static_cast<float>(options.spin_degrees), options.frames, frame_rate);
+
+        if (!sequence->render(options.frames, options.output))
+            return 1;
+    }
+    else if (options.workers > 0)
+    {
+        if (!DistributedRender::coordinate(*raytracer, worker_command(argc, argv), options.workers))
+            return 1;
+    }
+    else
+    {
+        raytracer->render();
+    }
+
+    std::chrono::duration<double> const total_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Total time: " << total_time.count() << " s\n";
+
+    return 0;
+}
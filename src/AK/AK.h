@@ -16,7 +16,14 @@ namespace AK
 {
 
 static std::random_device random_device;
-static std::default_random_engine random_engine(random_device());
+
+// One engine per thread, so workers never share state. Threads that need reproducible sequences reseed it with seed_random().
+inline thread_local std::default_random_engine random_engine(std::random_device {}());
+
+inline void seed_random(u64 const seed)
+{
+    random_engine.seed(static_cast<u32>(seed ^ (seed >> 32)));
+}
 
 #pragma region GUID_creation
 
@@ -297,4 +304,18 @@ void erase(std::vector<std::weak_ptr<T>>& vector, std::shared_ptr<T> element)
 
 #pragma endregion
 
+u64 constexpr HASH_OFFSET_BASIS = 0xcbf29ce484222325ull;
+
+// FNV-1a, for cache keys that only have to tell inputs apart, not resist tampering. Start from HASH_OFFSET_BASIS.
+inline void hash_bytes(u64& hash, void const* data, size_t const size)
+{
+    auto const* bytes = static_cast<u8 const*>(data);
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+}
+
 }
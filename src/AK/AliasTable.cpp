@@ -0,0 +1,96 @@
+#include "AliasTable.h"
+
+#include <algorithm>
+
+namespace AK
+{
+
+AliasTable::AliasTable(std::span<float const> const weights) : m_entries(weights.size())
+{
+    if (weights.empty())
+        return;
+
+    double total = 0.0;
+
+    for (float const weight : weights)
+    {
+        total += std::max(weight, 0.0f);
+    }
+
+    size_t const count = weights.size();
+
+    // Vose's variant, every slot holds count times the probability of its index on average. Slots under 1 are
+    // topped up from one over 1, which then moves to the other list if it drops under 1 itself.
+    std::vector<double> scaled(count);
+    std::vector<u32> small = {};
+    std::vector<u32> large = {};
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        double const probability = total > 0.0 ? std::max(weights[i], 0.0f) / total : 1.0 / static_cast<double>(count);
+
+        m_entries[i].probability = static_cast<float>(probability);
+        m_entries[i].alias = static_cast<u32>(i);
+        scaled[i] = probability * static_cast<double>(count);
+
+        if (scaled[i] < 1.0)
+            small.emplace_back(static_cast<u32>(i));
+        else
+            large.emplace_back(static_cast<u32>(i));
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        u32 const less = small.back();
+        small.pop_back();
+        u32 const more = large.back();
+
+        m_entries[less].threshold = static_cast<float>(scaled[less]);
+        m_entries[less].alias = more;
+
+        scaled[more] -= 1.0 - scaled[less];
+
+        if (scaled[more] < 1.0)
+        {
+            large.pop_back();
+            small.emplace_back(more);
+        }
+    }
+
+    // Whatever is left is 1 up to rounding errors.
+    for (u32 const index : small)
+    {
+        m_entries[index].threshold = 1.0f;
+    }
+
+    for (u32 const index : large)
+    {
+        m_entries[index].threshold = 1.0f;
+    }
+}
+
+u32 AliasTable::sample(float const random) const
+{
+    float const scaled = random * static_cast<float>(m_entries.size());
+    u32 const index = std::min(static_cast<u32>(scaled), static_cast<u32>(m_entries.size() - 1));
+    Entry const& entry = m_entries[index];
+
+    return scaled - static_cast<float>(index) < entry.threshold ? index : entry.alias;
+}
+
+float AliasTable::probability(u32 const index) const
+{
+    return m_entries[index].probability;
+}
+
+size_t AliasTable::size() const
+{
+    return m_entries.size();
+}
+
+bool AliasTable::is_empty() const
+{
+    return m_entries.empty();
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Types.h"
+
+#include <span>
+#include <vector>
+
+namespace AK
+{
+
+// Walker's alias method. Picks index i with a probability proportional to weights[i] from a single random number,
+// in constant time no matter how many weights there are.
+class AliasTable
+{
+public:
+    AliasTable() = default;
+
+    // Negative weights count as 0. If every weight is 0 the indices are picked uniformly.
+    explicit AliasTable(std::span<float const> const weights);
+
+    // random is uniformly distributed in [0, 1).
+    [[nodiscard]] u32 sample(float const random) const;
+
+    [[nodiscard]] float probability(u32 const index) const;
+
+    [[nodiscard]] size_t size() const;
+    [[nodiscard]] bool is_empty() const;
+
+private:
+    struct Entry
+    {
+        // Part of the slot that keeps its own index, the rest goes to the alias.
+        float threshold = 1.0f;
+        u32 alias = 0;
+        float probability = 0.0f;
+    };
+
+    std::vector<Entry> m_entries = {};
+};
+
+}
@@ -0,0 +1,115 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace AK
+{
+
+Arena::Arena(size_t const chunk_size) : m_chunk_size(chunk_size)
+{
+}
+
+void* Arena::allocate(size_t const size, size_t const alignment)
+{
+    if (m_current_chunk < m_chunks.size())
+    {
+        Chunk const& chunk = m_chunks[m_current_chunk];
+        auto const address = reinterpret_cast<uintptr_t>(chunk.data.get()) + m_offset;
+        size_t const padding = (alignment - address % alignment) % alignment;
+
+        if (m_offset + padding + size <= chunk.size)
+        {
+            m_offset += padding + size;
+            m_used += padding + size;
+            m_peak_used = std::max(m_peak_used, m_used);
+            m_peak_job_used = std::max(m_peak_job_used, m_used);
+            return chunk.data.get() + m_offset - size;
+        }
+    }
+
+    // Move on to the next chunk that is large enough, allocating one if there is none.
+    for (m_current_chunk += 1; m_current_chunk < m_chunks.size(); ++m_current_chunk)
+    {
+        if (m_chunks[m_current_chunk].size >= size + alignment)
+            break;
+    }
+
+    if (m_current_chunk >= m_chunks.size())
+        add_chunk(size + alignment);
+
+    m_offset = 0;
+    return allocate(size, alignment);
+}
+
+Arena::Checkpoint Arena::checkpoint() const
+{
+    return {m_current_chunk, m_offset, m_used};
+}
+
+void Arena::rewind(Checkpoint const& checkpoint)
+{
+    m_current_chunk = checkpoint.chunk;
+    m_offset = checkpoint.offset;
+    m_used = checkpoint.used;
+}
+
+void Arena::reset()
+{
+    if (m_chunks.size() > 1)
+    {
+        // Some headroom, so a slightly larger next job still fits.
+        size_t const size = m_peak_job_used + m_peak_job_used / 8;
+        m_chunks.clear();
+        add_chunk(size);
+    }
+
+    m_current_chunk = 0;
+    m_offset = 0;
+    m_used = 0;
+    m_peak_job_used = 0;
+}
+
+size_t Arena::used() const
+{
+    return m_used;
+}
+
+size_t Arena::peak_used() const
+{
+    return m_peak_used;
+}
+
+size_t Arena::capacity() const
+{
+    size_t result = 0;
+
+    for (auto const& chunk : m_chunks)
+    {
+        result += chunk.size;
+    }
+
+    return result;
+}
+
+void Arena::add_chunk(size_t const minimum_size)
+{
+    // Chunks grow with the arena, so large jobs end up in a few chunks.
+    size_t const size = std::max({minimum_size, m_chunk_size, capacity()});
+
+    m_chunks.emplace_back(std::make_unique_for_overwrite<u8[]>(size), size);
+    m_current_chunk = m_chunks.size() - 1;
+}
+
+ArenaScope::ArenaScope(Arena* const arena) : m_arena(arena)
+{
+    if (m_arena != nullptr)
+        m_checkpoint = m_arena->checkpoint();
+}
+
+ArenaScope::~ArenaScope()
+{
+    if (m_arena != nullptr)
+        m_arena->rewind(m_checkpoint);
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Types.h"
+
+#include <memory>
+#include <vector>
+
+namespace AK
+{
+
+// Monotonic allocator. Allocations bump an offset inside large chunks and are only freed all at once by reset(),
+// destructors are not run. The chunks are kept across resets, so a sequence of similar jobs stops allocating
+// from the heap after the first one.
+class Arena
+{
+public:
+    Arena() = default;
+    explicit Arena(size_t const chunk_size);
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    // Position of the arena, everything allocated after it can be freed with rewind().
+    struct Checkpoint
+    {
+        size_t chunk = 0;
+        size_t offset = 0;
+        size_t used = 0;
+    };
+
+    [[nodiscard]] void* allocate(size_t const size, size_t const alignment);
+
+    [[nodiscard]] Checkpoint checkpoint() const;
+    void rewind(Checkpoint const& checkpoint);
+
+    // Frees every allocation. If the last job needed more than one chunk, they are replaced with a single one
+    // that fits what the job used.
+    void reset();
+
+    // Bytes handed out since the last reset, alignment padding included.
+    [[nodiscard]] size_t used() const;
+
+    // Largest used() since the arena was created.
+    [[nodiscard]] size_t peak_used() const;
+
+    // Bytes held in chunks.
+    [[nodiscard]] size_t capacity() const;
+
+    static size_t constexpr default_chunk_size = 1024 * 1024;
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<u8[]> data = {};
+        size_t size = 0;
+    };
+
+    void add_chunk(size_t const minimum_size);
+
+    size_t m_chunk_size = default_chunk_size;
+
+    std::vector<Chunk> m_chunks = {};
+    size_t m_current_chunk = 0;
+    size_t m_offset = 0;
+
+    size_t m_used = 0;
+    size_t m_peak_used = 0;
+
+    // Largest used() since the last reset.
+    size_t m_peak_job_used = 0;
+};
+
+// Standard allocator on top of an arena, for containers whose memory should go away with Arena::reset().
+// Deallocation is a no-op. Without an arena it falls back to the heap, so the same container type works
+// outside of the raytracer.
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() = default;
+
+    explicit ArenaAllocator(Arena* const arena) : m_arena(arena)
+    {
+    }
+
+    template<typename U>
+    ArenaAllocator(ArenaAllocator<U> const& other) : m_arena(other.arena())
+    {
+    }
+
+    [[nodiscard]] T* allocate(size_t const count)
+    {
+        if (m_arena == nullptr)
+            return std::allocator<T>().allocate(count);
+
+        return static_cast<T*>(m_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* const data, size_t const count)
+    {
+        if (m_arena == nullptr)
+            std::allocator<T>().deallocate(data, count);
+    }
+
+    [[nodiscard]] Arena* arena() const
+    {
+        return m_arena;
+    }
+
+    template<typename U>
+    bool operator==(ArenaAllocator<U> const& other) const
+    {
+        return m_arena == other.arena();
+    }
+
+private:
+    Arena* m_arena = nullptr;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Frees everything allocated from the arena while it is alive, e.g. temporary arrays of a single function.
+// Does nothing without an arena.
+class ArenaScope
+{
+public:
+    explicit ArenaScope(Arena* const arena);
+    ~ArenaScope();
+
+    ArenaScope(ArenaScope const&) = delete;
+    ArenaScope& operator=(ArenaScope const&) = delete;
+
+private:
+    Arena* m_arena = nullptr;
+    Arena::Checkpoint m_checkpoint = {};
+};
+
+}
@@ -0,0 +1,112 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace AK
+{
+
+std::shared_ptr<MappedFile> MappedFile::create(std::string const& path)
+{
+    auto file = std::make_shared<MappedFile>(Badge<MappedFile> {});
+
+    if (!file->map(path))
+        return nullptr;
+
+    return file;
+}
+
+MappedFile::MappedFile(Badge<MappedFile>)
+{
+}
+
+#ifdef _WIN32
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+
+    if (m_file != nullptr && m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+}
+
+bool MappedFile::map(std::string const& path)
+{
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size = {};
+
+    if (!GetFileSizeEx(m_file, &file_size) || file_size.QuadPart == 0)
+        return false;
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (m_mapping == nullptr)
+        return false;
+
+    m_data = static_cast<u8 const*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    m_size = static_cast<size_t>(file_size.QuadPart);
+
+    return m_data != nullptr;
+}
+
+#else
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<u8*>(m_data), m_size);
+
+    if (m_file != -1)
+        close(m_file);
+}
+
+bool MappedFile::map(std::string const& path)
+{
+    m_file = open(path.c_str(), O_RDONLY);
+
+    if (m_file == -1)
+        return false;
+
+    struct stat file_stat = {};
+
+    if (fstat(m_file, &file_stat) != 0 || file_stat.st_size == 0)
+        return false;
+
+    void* const data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, m_file, 0);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<u8 const*>(data);
+    m_size = static_cast<size_t>(file_stat.st_size);
+
+    return true;
+}
+
+#endif
+
+u8 const* MappedFile::data() const
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const
+{
+    return m_size;
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Badge.h"
+#include "Types.h"
+
+#include <memory>
+#include <string>
+
+namespace AK
+{
+
+// Read-only memory mapping of a whole file. The contents stay valid for the lifetime of the object.
+class MappedFile
+{
+public:
+    // Returns nullptr if the file does not exist, is empty or cannot be mapped.
+    static std::shared_ptr<MappedFile> create(std::string const& path);
+
+    explicit MappedFile(Badge<MappedFile>);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    [[nodiscard]] u8 const* data() const;
+    [[nodiscard]] size_t size() const;
+
+private:
+    bool map(std::string const& path);
+
+    u8 const* m_data = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#else
+    i32 m_file = -1;
+#endif
+};
+
+}
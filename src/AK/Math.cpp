@@ -1,10 +1,15 @@
 #include "Math.h"
 
+#include "AK.h"
+
+#ifdef _WIN32
 #include <corecrt_math_defines.h>
+#else
+#include <cmath>
+#endif
 
 #include <glm/ext/quaternion_geometric.hpp>
 #include <glm/gtc/epsilon.hpp>
-#include <glm/gtc/random.hpp>
 #include <glm/gtx/norm.hpp>
 
 namespace AK
@@ -60,7 +65,8 @@ glm::vec3 Math::random_in_unit_sphere()
 {
     while (true)
     {
-        glm::vec3 point = glm::linearRand(glm::vec3(-1.0f, -1.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+        // The thread local engine, std::rand() behind glm::linearRand() is shared between the render threads.
+        glm::vec3 point = {random_float_fast(-1.0f, 1.0f), random_float_fast(-1.0f, 1.0f), random_float_fast(-1.0f, 1.0f)};
 
         if (glm::length2(point) < 1.0f)
         {
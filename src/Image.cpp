@@ -1,15 +1,64 @@
 #include "Image.h"
 
+#include "AK/AK.h"
+
+#include <glm/common.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <stb_image.h>
 
+struct ImageCacheHeader
+{
+    u32 magic = 0;
+    u32 version = 0;
+    u32 format = 0;
+    i32 width = 0;
+    i32 height = 0;
+    u32 padding = 0;
+    u64 texels_size = 0;
+};
+
+// Same curve stbi_loadf() linearizes LDR files with, so 8-bit images decode to exactly what it would have returned.
+static float constexpr file_gamma = 2.2f;
+
+static std::array<float, 256> const& gamma_to_linear_table()
+{
+    static std::array<float, 256> const table = [] {
+        std::array<float, 256> values = {};
+
+        for (i32 i = 0; i < 256; ++i)
+        {
+            values[i] = std::pow(static_cast<float>(i) / 255.0f, file_gamma);
+        }
+
+        return values;
+    }();
+
+    return table;
+}
+
 std::shared_ptr<Image> Image::create(std::string const& path)
 {
-    return std::make_shared<Image>(AK::Badge<Image> {}, path);
+    ImageFormat const format = stbi_is_hdr(path.c_str()) != 0 ? ImageFormat::Half : ImageFormat::Gamma8;
+    return create(path, format);
+}
+
+std::shared_ptr<Image> Image::create(std::string const& path, ImageFormat const format)
+{
+    return std::make_shared<Image>(AK::Badge<Image> {}, path, format);
 }
 
-Image::Image(AK::Badge<Image>, std::string const& path)
+Image::Image(AK::Badge<Image>, std::string const& path, ImageFormat const format) : m_path(path), m_format(format)
 {
     bool const result = load(path);
 
@@ -19,56 +68,226 @@ Image::Image(AK::Badge<Image>, std::string const& path)
     }
 }
 
-Image::~Image()
+void Image::set_cache_directory(std::string const& directory)
 {
-    delete[] m_byte_data;
-
-    stbi_image_free(m_float_data);
+    m_cache_directory = directory;
 }
 
 bool Image::load(std::string const& path)
 {
-    // Loads the linear (gamma=1) image data from the given file name. Returns true if the
-    // load succeeded. The resulting data buffer contains the three [0.0, 1.0]
-    // floating-point values for the first pixel (red, then green, then blue). Pixels are
-    // contiguous, going left to right for the width of the image, followed by the next row
-    // below, for the full height of the image.
+    std::string const cache_path = get_cache_path();
+
+    if (!cache_path.empty() && load_from_cache(cache_path))
+        return true;
+
+    // Only the decoded file data is converted, it is released as soon as the mip levels are built.
+    i32 width = 0;
+    i32 height = 0;
+    i32 channels = 0;
+    std::vector<float> linear_data = {};
 
-    auto n = bytes_per_pixel;
-    m_float_data = stbi_loadf(path.c_str(), &m_image_width, &m_image_height, &n, bytes_per_pixel);
+    if (stbi_is_hdr(path.c_str()) != 0)
+    {
+        float* float_data = stbi_loadf(path.c_str(), &width, &height, &channels, bytes_per_pixel);
+
+        if (float_data == nullptr)
+            return false;
+
+        linear_data.assign(float_data, float_data + static_cast<size_t>(width) * height * bytes_per_pixel);
+        stbi_image_free(float_data);
 
-    if (m_float_data == nullptr)
+        m_owned_texels.resize(set_mip_levels(width, height));
+        build_mip_levels(std::move(linear_data), nullptr);
+    }
+    else
     {
+        u8* byte_data = stbi_load(path.c_str(), &width, &height, &channels, bytes_per_pixel);
+
+        if (byte_data == nullptr)
+            return false;
+
+        size_t const component_count = static_cast<size_t>(width) * height * bytes_per_pixel;
+        linear_data.resize(component_count);
+
+        for (size_t i = 0; i < component_count; ++i)
+        {
+            linear_data[i] = gamma_to_linear_table()[byte_data[i]];
+        }
+
+        // The full resolution level of an 8-bit image is the file data itself, it does not need to be re-encoded.
+        m_owned_texels.resize(set_mip_levels(width, height));
+        build_mip_levels(std::move(linear_data), m_format == ImageFormat::Gamma8 ? byte_data : nullptr);
+        stbi_image_free(byte_data);
+    }
+
+    m_image_width = width;
+    m_image_height = height;
+    m_texels = m_owned_texels;
+
+    if (!cache_path.empty())
+        store_to_cache(cache_path);
+
+    return true;
+}
+
+bool Image::load_from_cache(std::string const& cache_path)
+{
+    auto const file = AK::MappedFile::create(cache_path);
+
+    if (file == nullptr || file->size() < sizeof(ImageCacheHeader))
+        return false;
+
+    ImageCacheHeader header = {};
+    std::memcpy(&header, file->data(), sizeof(ImageCacheHeader));
+
+    if (header.magic != cache_magic || header.version != cache_version || header.format != static_cast<u32>(m_format)
+        || header.width <= 0 || header.height <= 0)
+    {
+        return false;
+    }
+
+    size_t const texels_size = set_mip_levels(header.width, header.height);
+
+    if (header.texels_size != texels_size || file->size() != sizeof(ImageCacheHeader) + texels_size)
+    {
+        std::clog << "Ignoring invalid image cache entry: " << cache_path << "\n";
+        m_mip_levels.clear();
         return false;
     }
 
-    m_bytes_per_scanline = m_image_width * bytes_per_pixel;
-    convert_to_bytes();
+    m_image_width = header.width;
+    m_image_height = header.height;
+    m_mapped_file = file;
+    m_texels = {file->data() + sizeof(ImageCacheHeader), texels_size};
+
     return true;
 }
 
+void Image::store_to_cache(std::string const& cache_path) const
+{
+    std::error_code error = {};
+    std::filesystem::create_directories(m_cache_directory, error);
+
+    ImageCacheHeader header = {};
+    header.magic = cache_magic;
+    header.version = cache_version;
+    header.format = static_cast<u32>(m_format);
+    header.width = m_image_width;
+    header.height = m_image_height;
+    header.texels_size = m_texels.size();
+
+    // Written under a temporary name and renamed, so a concurrent load never maps a half written entry. The name is
+    // random, so processes converting the same image at the same time do not write into the same file.
+    std::string const temporary_path = cache_path + "." + AK::generate_hex(8) + ".tmp";
+
+    std::ofstream output(temporary_path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        std::clog << "Could not write an image cache entry: " << cache_path << "\n";
+        return;
+    }
+
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    output.write(reinterpret_cast<char const*>(m_texels.data()), static_cast<std::streamsize>(m_texels.size()));
+    output.close();
+
+    std::filesystem::rename(temporary_path, cache_path, error);
+
+    if (error)
+        std::filesystem::remove(temporary_path, error);
+}
+
+std::string Image::get_cache_path() const
+{
+    if (m_cache_directory.empty())
+        return {};
+
+    // Keyed by the source file and its modification, so an edited image is converted again. Entries of old
+    // versions of a file are left behind, clearing the directory is always safe.
+    std::error_code error = {};
+    u64 const file_size = std::filesystem::file_size(m_path, error);
+    auto const write_time = std::filesystem::last_write_time(m_path, error).time_since_epoch().count();
+
+    if (error)
+        return {};
+
+    u64 hash = AK::HASH_OFFSET_BASIS;
+    u32 const layout[] = {cache_version, static_cast<u32>(m_format)};
+    AK::hash_bytes(hash, layout, sizeof(layout));
+    AK::hash_bytes(hash, m_path.data(), m_path.size());
+    AK::hash_bytes(hash, &file_size, sizeof(file_size));
+    AK::hash_bytes(hash, &write_time, sizeof(write_time));
+
+    std::ostringstream file_name;
+    file_name << std::hex << std::setw(16) << std::setfill('0') << hash << ".image";
+
+    return (std::filesystem::path(m_cache_directory) / file_name.str()).string();
+}
+
 i32 Image::width() const
 {
-    return (m_float_data == nullptr) ? 0 : m_image_width;
+    return m_image_width;
 }
 
 i32 Image::height() const
 {
-    return (m_float_data == nullptr) ? 0 : m_image_height;
+    return m_image_height;
+}
+
+std::string const& Image::path() const
+{
+    return m_path;
 }
 
-u8 const* Image::pixel_data(i32 x, i32 y) const
+ImageFormat Image::format() const
 {
-    // Return the address of the three RGB bytes of the pixel at x,y. If there is no image
-    // data, returns magenta.
-    static u8 magenta[] = {255, 0, 255};
-    if (m_byte_data == nullptr)
-        return magenta;
+    return m_format;
+}
+
+glm::vec3 Image::texel(i32 const level, i32 const x, i32 const y) const
+{
+    // If there is no image data, returns magenta.
+    if (m_mip_levels.empty())
+        return {1.0f, 0.0f, 1.0f};
+
+    MipLevel const& mip_level = m_mip_levels[clamp(level, 0, static_cast<i32>(m_mip_levels.size()))];
+
+    return decode(texel_offset(mip_level, clamp(x, 0, mip_level.width), clamp(y, 0, mip_level.height)));
+}
+
+glm::vec3 Image::sample(float const u, float const v, float const footprint) const
+{
+    if (m_mip_levels.empty())
+        return {1.0f, 0.0f, 1.0f};
+
+    // Number of texels of the full resolution image the footprint covers, as a power of two.
+    float const level = std::log2(std::max(footprint * static_cast<float>(std::max(m_image_width, m_image_height)), 0.0001f));
 
-    x = clamp(x, 0, m_image_width);
-    y = clamp(y, 0, m_image_height);
+    if (level <= 0.0f)
+        return bilinear(m_mip_levels[0], u, v);
+
+    float const clamped_level = std::min(level, static_cast<float>(m_mip_levels.size() - 1));
+    auto const lower_level = static_cast<size_t>(clamped_level);
+    size_t const upper_level = std::min(lower_level + 1, m_mip_levels.size() - 1);
+
+    return glm::mix(bilinear(m_mip_levels[lower_level], u, v), bilinear(m_mip_levels[upper_level], u, v),
+                    clamped_level - static_cast<float>(lower_level));
+}
+
+i32 Image::mip_level_count() const
+{
+    return static_cast<i32>(m_mip_levels.size());
+}
+
+glm::ivec2 Image::level_size(i32 const level) const
+{
+    return {m_mip_levels[level].width, m_mip_levels[level].height};
+}
 
-    return m_byte_data + y * m_bytes_per_scanline + x * bytes_per_pixel;
+size_t Image::memory_size() const
+{
+    return m_texels.size();
 }
 
 i32 Image::clamp(i32 const x, i32 const low, i32 const high)
@@ -86,30 +305,191 @@ i32 Image::clamp(i32 const x, i32 const low, i32 const high)
 u8 Image::float_to_byte(float const value)
 {
     if (value <= 0.0f)
-        return 0.0f;
+        return 0;
 
     if (1.0f <= value)
         return 255;
 
-    return static_cast<u8>(256.0f * value);
+    // Rounded to nearest, so decoding with the gamma table gives back the closest representable value.
+    return static_cast<u8>(std::pow(value, 1.0f / file_gamma) * 255.0f + 0.5f);
 }
 
-void Image::convert_to_bytes()
+size_t Image::set_mip_levels(i32 const width, i32 const height)
 {
-    // Convert the linear floating point pixel data to bytes, storing the resulting byte
-    // data in the `bdata` member.
+    m_mip_levels.clear();
 
-    i32 const total_bytes = m_image_width * m_image_height * bytes_per_pixel;
-    m_byte_data = new u8[total_bytes];
+    size_t offset = 0;
+    i32 level_width = width;
+    i32 level_height = height;
 
-    // Iterate through all pixel components, converting from [0.0, 1.0] float values to
-    // unsigned [0, 255] byte values.
+    while (true)
+    {
+        MipLevel& level = m_mip_levels.emplace_back();
+        level.width = level_width;
+        level.height = level_height;
+        level.tiles_per_row = (level_width + tile_size - 1) / tile_size;
+        level.offset = offset;
 
-    u8* byte_ptr = m_byte_data;
-    float* float_ptr = m_float_data;
+        i32 const tile_rows = (level_height + tile_size - 1) / tile_size;
+        offset += static_cast<size_t>(level.tiles_per_row) * tile_rows * tile_size * tile_size * bytes_per_texel();
 
-    for (auto i = 0; i < total_bytes; i++, float_ptr++, byte_ptr++)
+        if (level_width == 1 && level_height == 1)
+            break;
+
+        level_width = std::max(level_width / 2, 1);
+        level_height = std::max(level_height / 2, 1);
+    }
+
+    return offset;
+}
+
+void Image::build_mip_levels(std::vector<float> level_data, u8 const* gamma_encoded_data)
+{
+    // Every level is box filtered from the linear data of the previous one and only then encoded,
+    // so the rounding errors do not add up over the levels.
+    for (size_t level_index = 0; level_index < m_mip_levels.size(); ++level_index)
     {
-        *byte_ptr = float_to_byte(*float_ptr);
+        MipLevel const& level = m_mip_levels[level_index];
+        encode_level(level, level_data.data(), level_index == 0 ? gamma_encoded_data : nullptr);
+
+        if (level_index + 1 == m_mip_levels.size())
+            break;
+
+        MipLevel const& next_level = m_mip_levels[level_index + 1];
+        std::vector<float> next_data(static_cast<size_t>(next_level.width) * next_level.height * bytes_per_pixel);
+
+        for (i32 y = 0; y < next_level.height; ++y)
+        {
+            for (i32 x = 0; x < next_level.width; ++x)
+            {
+                i32 const x0 = std::min(x * 2, level.width - 1);
+                i32 const x1 = std::min(x * 2 + 1, level.width - 1);
+                i32 const y0 = std::min(y * 2, level.height - 1);
+                i32 const y1 = std::min(y * 2 + 1, level.height - 1);
+
+                for (i32 channel = 0; channel < bytes_per_pixel; ++channel)
+                {
+                    auto const at = [&](i32 const source_x, i32 const source_y) {
+                        return level_data[(static_cast<size_t>(source_y) * level.width + source_x) * bytes_per_pixel + channel];
+                    };
+
+                    next_data[(static_cast<size_t>(y) * next_level.width + x) * bytes_per_pixel + channel] =
+                        0.25f * (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1));
+                }
+            }
+        }
+
+        level_data = std::move(next_data);
     }
 }
+
+void Image::encode_level(MipLevel const& level, float const* linear_data, u8 const* gamma_encoded_data)
+{
+    for (i32 y = 0; y < level.height; ++y)
+    {
+        for (i32 x = 0; x < level.width; ++x)
+        {
+            u8* destination = m_owned_texels.data() + texel_offset(level, x, y);
+            size_t const source_index = (static_cast<size_t>(y) * level.width + x) * bytes_per_pixel;
+
+            for (i32 channel = 0; channel < bytes_per_pixel; ++channel)
+            {
+                float const value = linear_data[source_index + channel];
+
+                switch (m_format)
+                {
+                case ImageFormat::Gamma8:
+                    destination[channel] =
+                        gamma_encoded_data != nullptr ? gamma_encoded_data[source_index + channel] : float_to_byte(value);
+                    break;
+
+                case ImageFormat::Half:
+                {
+                    u16 const half = glm::packHalf1x16(value);
+                    std::memcpy(destination + channel * sizeof(u16), &half, sizeof(u16));
+                    break;
+                }
+
+                case ImageFormat::Float:
+                    std::memcpy(destination + channel * sizeof(float), &value, sizeof(float));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+size_t Image::texel_offset(MipLevel const& level, i32 const x, i32 const y) const
+{
+    i32 const tile_index = (y / tile_size) * level.tiles_per_row + x / tile_size;
+    i32 const index_in_tile = (y % tile_size) * tile_size + x % tile_size;
+
+    return level.offset + (static_cast<size_t>(tile_index) * tile_size * tile_size + index_in_tile) * bytes_per_texel();
+}
+
+glm::vec3 Image::decode(size_t const offset) const
+{
+    u8 const* texel_data = m_texels.data() + offset;
+    glm::vec3 color = {};
+
+    for (i32 channel = 0; channel < bytes_per_pixel; ++channel)
+    {
+        switch (m_format)
+        {
+        case ImageFormat::Gamma8:
+            color[channel] = gamma_to_linear_table()[texel_data[channel]];
+            break;
+
+        case ImageFormat::Half:
+        {
+            u16 half = 0;
+            std::memcpy(&half, texel_data + channel * sizeof(u16), sizeof(u16));
+            color[channel] = glm::unpackHalf1x16(half);
+            break;
+        }
+
+        case ImageFormat::Float:
+            std::memcpy(&color[channel], texel_data + channel * sizeof(float), sizeof(float));
+            break;
+        }
+    }
+
+    return color;
+}
+
+glm::vec3 Image::bilinear(MipLevel const& level, float const u, float const v) const
+{
+    // Texel centers are at half integer coordinates. Like the unfiltered lookup, coordinates are clamped to the edges.
+    float const x = glm::clamp(u, 0.0f, 1.0f) * static_cast<float>(level.width) - 0.5f;
+    float const y = glm::clamp(v, 0.0f, 1.0f) * static_cast<float>(level.height) - 0.5f;
+
+    float const x_floor = std::floor(x);
+    float const y_floor = std::floor(y);
+    float const tx = x - x_floor;
+    float const ty = y - y_floor;
+
+    i32 const x0 = clamp(static_cast<i32>(x_floor), 0, level.width);
+    i32 const x1 = clamp(static_cast<i32>(x_floor) + 1, 0, level.width);
+    i32 const y0 = clamp(static_cast<i32>(y_floor), 0, level.height);
+    i32 const y1 = clamp(static_cast<i32>(y_floor) + 1, 0, level.height);
+
+    glm::vec3 const top = glm::mix(decode(texel_offset(level, x0, y0)), decode(texel_offset(level, x1, y0)), tx);
+    glm::vec3 const bottom = glm::mix(decode(texel_offset(level, x0, y1)), decode(texel_offset(level, x1, y1)), tx);
+
+    return glm::mix(top, bottom, ty);
+}
+
+size_t Image::bytes_per_texel() const
+{
+    switch (m_format)
+    {
+    case ImageFormat::Gamma8:
+        return bytes_per_pixel;
+    case ImageFormat::Half:
+        return bytes_per_pixel * sizeof(u16);
+    case ImageFormat::Float:
+        return bytes_per_pixel * sizeof(float);
+    }
+
+    return bytes_per_pixel;
+}
@@ -1,37 +1,109 @@
 #pragma once
 
 #include "AK/Badge.h"
+#include "AK/MappedFile.h"
 #include "AK/Types.h"
 
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
+enum class ImageFormat : u8
+{
+    Gamma8, // 8-bit, gamma 2.2 encoded like the LDR files themselves. Default for LDR files.
+    Half, // 16-bit float, linear. Default for HDR files.
+    Float, // 32-bit float, linear
+};
+
+// Image with its mip levels in a single storage format. Texels are converted to linear floats when they are read,
+// the decoded file data is dropped after loading.
 class Image
 {
 public:
+    // Uses the default format of the file type.
     static std::shared_ptr<Image> create(std::string const& path);
+    static std::shared_ptr<Image> create(std::string const& path, ImageFormat const format);
 
-    explicit Image(AK::Badge<Image>, std::string const& path);
+    explicit Image(AK::Badge<Image>, std::string const& path, ImageFormat const format);
 
-    ~Image();
+    // Converted images are written to this directory and memory mapped from there by later loads, as long as
+    // the source file does not change. Empty (the default) disables it.
+    static void set_cache_directory(std::string const& directory);
 
     [[nodiscard]] i32 width() const;
     [[nodiscard]] i32 height() const;
 
-    [[nodiscard]] u8 const* pixel_data(i32 const x, i32 const y) const;
+    [[nodiscard]] std::string const& path() const;
+    [[nodiscard]] ImageFormat format() const;
+
+    // Linear color of a single texel, coordinates are clamped to the level.
+    [[nodiscard]] glm::vec3 texel(i32 const level, i32 const x, i32 const y) const;
+
+    // Filtered lookup, footprint is the size of the sampled area in UV units. Areas up to a texel are sampled
+    // bilinearly from the full resolution image, larger ones trilinearly from the two closest mip levels.
+    [[nodiscard]] glm::vec3 sample(float const u, float const v, float const footprint) const;
+
+    [[nodiscard]] i32 mip_level_count() const;
+    [[nodiscard]] glm::ivec2 level_size(i32 const level) const;
+
+    // Resident size of the texels of every level.
+    [[nodiscard]] size_t memory_size() const;
 
 private:
+    // Texels are stored in square tiles that are contiguous in memory, so a filtered lookup touches
+    // a few cache lines instead of one per row.
+    struct MipLevel
+    {
+        i32 width = 0;
+        i32 height = 0;
+        i32 tiles_per_row = 0;
+
+        // Byte offset of the level in the texel storage.
+        size_t offset = 0;
+    };
+
     static i32 clamp(i32 const x, i32 const low, i32 const high);
     static u8 float_to_byte(float const value);
 
     bool load(std::string const& path);
-    void convert_to_bytes();
+    bool load_from_cache(std::string const& cache_path);
+    void store_to_cache(std::string const& cache_path) const;
+    [[nodiscard]] std::string get_cache_path() const;
+
+    // Lays out the levels of an image of the given size, returns the size of their texels.
+    size_t set_mip_levels(i32 const width, i32 const height);
+    void build_mip_levels(std::vector<float> level_data, u8 const* gamma_encoded_data);
+    void encode_level(MipLevel const& level, float const* linear_data, u8 const* gamma_encoded_data);
+
+    [[nodiscard]] size_t texel_offset(MipLevel const& level, i32 const x, i32 const y) const;
+    [[nodiscard]] glm::vec3 decode(size_t const offset) const;
+    [[nodiscard]] glm::vec3 bilinear(MipLevel const& level, float const u, float const v) const;
+
+    [[nodiscard]] size_t bytes_per_texel() const;
 
     inline static i32 bytes_per_pixel = 3;
+    static i32 constexpr tile_size = 8;
 
-    float* m_float_data = nullptr;
-    u8* m_byte_data = nullptr;
+    // Bump whenever the cached layout or the conversion changes.
+    static u32 constexpr cache_version = 1;
+    static u32 constexpr cache_magic = 0x474d4952; // "RIMG"
+
+    inline static std::string m_cache_directory = {};
+
+    std::string m_path = {};
+    ImageFormat m_format = ImageFormat::Gamma8;
     i32 m_image_width = 0;
     i32 m_image_height = 0;
-    i32 m_bytes_per_scanline = 0;
+
+    // Level 0 is the full resolution image, every next one halves both dimensions down to 1x1.
+    std::vector<MipLevel> m_mip_levels = {};
+
+    // Texels of all levels, either owned or pointing into the mapped cache file.
+    std::vector<u8> m_owned_texels = {};
+    std::shared_ptr<AK::MappedFile> m_mapped_file = {};
+    std::span<u8 const> m_texels = {};
 };
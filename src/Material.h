@@ -9,14 +9,12 @@
 #include "AK/Badge.h"
 #include "AK/Types.h"
 #include "Bounds.h"
+#include "Renderer/MaterialCPU.h"
 #include "Shader.h"
 
 class Drawable;
-class TextureCPU;
-class Ray;
-struct HitRecord;
 
-class Material
+class Material : public MaterialCPU
 {
 public:
     static std::shared_ptr<Material> create(std::shared_ptr<Shader> const& shader, i32 const render_order = 0,
@@ -35,28 +33,14 @@ public:
 
     [[nodiscard]] i32 get_render_order() const;
 
-    bool scatter(Ray const& ray_in, HitRecord const& hit_record, glm::vec3& attenuation, Ray& scattered) const;
-    glm::vec3 emit(float const u, float const v, glm::vec3 const& point) const;
-
     std::shared_ptr<Shader> shader;
 
     // TODO: Expose properties directly from the shader, somehow.
-    glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    std::shared_ptr<TextureCPU> texture = {};
+    // NOTE: color and texture are shared with the raytracer, they live in MaterialCPU.
 
     float specular = 1.0f;
     float shininess = 128.0f;
 
-    bool metal = false;
-    bool dielectric = false;
-    bool emissive = false;
-    bool isotropic = false;
-
-    // Should be in 0.0 - 1.0 range
-    float fuzz = 0.0f;
-
-    float refraction_index = 0.0f;
-
     u32 sector_count = 5;
     u32 stack_count = 5;
     float radius_multiplier = 2.0f;
@@ -84,8 +68,6 @@ public:
     std::vector<std::shared_ptr<Drawable>> drawables = {};
 
 private:
-    static float reflectance(float cosine, float refraction_index);
-
     // TODO: Negative render order is currently not supported
     i32 m_render_order = 0;
 };
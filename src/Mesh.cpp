@@ -57,6 +57,21 @@ BoundingBox Mesh::get_adjusted_bounding_box(glm::mat4 const& model_matrix) const
     return calculate_adjusted_bounding_box(model_matrix);
 }
 
+std::vector<Vertex> const& Mesh::get_vertices() const
+{
+    return m_vertices;
+}
+
+std::vector<u32> const& Mesh::get_indices() const
+{
+    return m_indices;
+}
+
+DrawType Mesh::get_draw_type() const
+{
+    return m_draw_type;
+}
+
 BoundingBox Mesh::calculate_adjusted_bounding_box(glm::mat4 const& model_matrix) const
 {
     // OPTIMIZATION: For uniformly scaled objects we can perform only 2 multiplications instead of a full matrix one
@@ -25,8 +25,15 @@ public:
     void adjust_bounding_box(glm::mat4 const& model_matrix);
     [[nodiscard]] BoundingBox get_adjusted_bounding_box(glm::mat4 const& model_matrix) const;
 
+    [[nodiscard]] std::vector<Vertex> const& get_vertices() const;
+    [[nodiscard]] std::vector<u32> const& get_indices() const;
+    [[nodiscard]] DrawType get_draw_type() const;
+
     BoundingBox bounds = {};
 
+    // One value per vertex, 1 is unoccluded. Filled by Model::bake_ambient_occlusion(), empty if the mesh was not baked.
+    std::vector<float> baked_ambient_occlusion = {};
+
     std::shared_ptr<Material> material;
 
 protected:
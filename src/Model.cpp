@@ -117,6 +117,31 @@ Model::Model(std::shared_ptr<Material> const& material) : Drawable(material)
 {
 }
 
+void Model::bake_ambient_occlusion(AmbientOcclusionSettings const& settings)
+{
+    std::vector<std::shared_ptr<Mesh>> baked_meshes = {};
+    std::vector<AmbientOcclusionMesh> meshes = {};
+
+    for (auto const& mesh : m_meshes)
+    {
+        if (mesh->get_draw_type() != DrawType::Triangles || mesh->get_indices().empty())
+            continue;
+
+        baked_meshes.emplace_back(mesh);
+        meshes.emplace_back(mesh->get_vertices(), mesh->get_indices(), entity->transform->get_model_matrix());
+    }
+
+    if (meshes.empty())
+        return;
+
+    auto const baker = AmbientOcclusionBaker::create(meshes);
+
+    for (size_t i = 0; i < baked_meshes.size(); ++i)
+    {
+        baked_meshes[i]->baked_ambient_occlusion = baker->bake_vertices(i, settings);
+    }
+}
+
 void Model::draw() const
 {
     if (m_rasterizer_draw_type == RasterizerDrawType::None)
@@ -6,6 +6,7 @@
 
 #include "AK/Badge.h"
 #include "Mesh.h"
+#include "Renderer/AmbientOcclusionBaker.h"
 #include "Texture.h"
 
 struct aiMaterial;
@@ -40,6 +41,10 @@ public:
     virtual void adjust_bounding_box() override;
     virtual BoundingBox get_adjusted_bounding_box(glm::mat4 const& model_matrix) const override;
 
+    // Bakes ambient occlusion into Mesh::baked_ambient_occlusion of every indexed triangle mesh, at the current placement
+    // of the entity. The meshes of the model occlude each other, the rest of the scene is not taken into account.
+    void bake_ambient_occlusion(AmbientOcclusionSettings const& settings);
+
     std::string model_path = "";
 
 protected:
@@ -0,0 +1,294 @@
+#include "AmbientOcclusionBaker.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "BVH.h"
+#include "TriangleRaytraced.h"
+
+#include <glm/geometric.hpp>
+#include <glm/mat3x3.hpp>
+#include <glm/matrix.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+// Cosine weighted, so every ray counts the same and the result is the usual cosine weighted ambient occlusion.
+static glm::vec3 cosine_direction(glm::vec3 const& normal)
+{
+    glm::vec3 const helper = std::fabs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    glm::vec3 const tangent = glm::normalize(glm::cross(helper, normal));
+    glm::vec3 const bitangent = glm::cross(normal, tangent);
+
+    float const phi = 2.0f * AK::PI_F * AK::random_float_fast();
+    float const r2 = AK::random_float_fast();
+    float const r = glm::sqrt(r2);
+
+    return tangent * (glm::cos(phi) * r) + bitangent * (glm::sin(phi) * r) + normal * glm::sqrt(1.0f - r2);
+}
+
+std::shared_ptr<AmbientOcclusionBaker> AmbientOcclusionBaker::create(std::vector<AmbientOcclusionMesh> const& meshes)
+{
+    return std::make_shared<AmbientOcclusionBaker>(AK::Badge<AmbientOcclusionBaker> {}, meshes);
+}
+
+AmbientOcclusionBaker::AmbientOcclusionBaker(AK::Badge<AmbientOcclusionBaker>, std::vector<AmbientOcclusionMesh> const& meshes)
+    : m_meshes(meshes)
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    AABB bounds = AABB::empty;
+
+    for (auto const& mesh : m_meshes)
+    {
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            glm::vec3 const a = mesh.transform * glm::vec4(mesh.vertices[mesh.indices[i]].position, 1.0f);
+            glm::vec3 const b = mesh.transform * glm::vec4(mesh.vertices[mesh.indices[i + 1]].position, 1.0f);
+            glm::vec3 const c = mesh.transform * glm::vec4(mesh.vertices[mesh.indices[i + 2]].position, 1.0f);
+
+            m_triangles.emplace_back(TriangleRaytraced::create(a, b, c, nullptr));
+            bounds = AABB(bounds, m_triangles.back()->bounding_box());
+        }
+    }
+
+    m_bvh = BVH::build(m_triangles);
+
+    glm::vec3 const extent = {bounds.x.size(), bounds.y.size(), bounds.z.size()};
+    m_bias = 0.0001f * glm::length(extent);
+
+    std::chrono::duration<double> const build_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "AO BVH build time: " << build_time.count() << " s (" << m_triangles.size() << " triangles)\n";
+}
+
+std::vector<float> AmbientOcclusionBaker::bake_vertices(size_t const mesh_index, AmbientOcclusionSettings const& settings) const
+{
+    AmbientOcclusionMesh const& mesh = m_meshes[mesh_index];
+    glm::mat3 const normal_matrix = glm::transpose(glm::inverse(glm::mat3(mesh.transform)));
+
+    std::vector<BakePoint> points(mesh.vertices.size());
+
+    for (size_t i = 0; i < mesh.vertices.size(); ++i)
+    {
+        points[i].position = mesh.transform * glm::vec4(mesh.vertices[i].position, 1.0f);
+        points[i].normal = normal_matrix * mesh.vertices[i].normal;
+    }
+
+    return bake_points(points, settings);
+}
+
+std::vector<float> AmbientOcclusionBaker::bake_lightmap(size_t const mesh_index, i32 const resolution,
+                                                        AmbientOcclusionSettings const& settings) const
+{
+    AmbientOcclusionMesh const& mesh = m_meshes[mesh_index];
+    glm::mat3 const normal_matrix = glm::transpose(glm::inverse(glm::mat3(mesh.transform)));
+
+    size_t const texel_count = static_cast<size_t>(resolution) * static_cast<size_t>(resolution);
+
+    // Index into points of the texel, -1 if no triangle covers its center.
+    std::vector<i32> texel_points(texel_count, -1);
+    std::vector<BakePoint> points = {};
+
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        Vertex const& a = mesh.vertices[mesh.indices[i]];
+        Vertex const& b = mesh.vertices[mesh.indices[i + 1]];
+        Vertex const& c = mesh.vertices[mesh.indices[i + 2]];
+
+        // In texel units, texel centers sit at half numbers.
+        glm::vec2 const uv_a = a.texture_coordinates * static_cast<float>(resolution);
+        glm::vec2 const uv_b = b.texture_coordinates * static_cast<float>(resolution);
+        glm::vec2 const uv_c = c.texture_coordinates * static_cast<float>(resolution);
+
+        float const area = (uv_b.x - uv_a.x) * (uv_c.y - uv_a.y) - (uv_c.x - uv_a.x) * (uv_b.y - uv_a.y);
+
+        if (std::fabs(area) < 1e-12f)
+            continue;
+
+        i32 const min_x = std::max(0, static_cast<i32>(std::floor(std::min({uv_a.x, uv_b.x, uv_c.x}))));
+        i32 const min_y = std::max(0, static_cast<i32>(std::floor(std::min({uv_a.y, uv_b.y, uv_c.y}))));
+        i32 const max_x = std::min(resolution - 1, static_cast<i32>(std::ceil(std::max({uv_a.x, uv_b.x, uv_c.x}))));
+        i32 const max_y = std::min(resolution - 1, static_cast<i32>(std::ceil(std::max({uv_a.y, uv_b.y, uv_c.y}))));
+
+        for (i32 y = min_y; y <= max_y; ++y)
+        {
+            for (i32 x = min_x; x <= max_x; ++x)
+            {
+                glm::vec2 const p = {static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f};
+
+                // Barycentric coordinates of b and c, the same for either winding.
+                float const weight_b = ((p.x - uv_a.x) * (uv_c.y - uv_a.y) - (uv_c.x - uv_a.x) * (p.y - uv_a.y)) / area;
+                float const weight_c = ((uv_b.x - uv_a.x) * (p.y - uv_a.y) - (p.x - uv_a.x) * (uv_b.y - uv_a.y)) / area;
+                float const weight_a = 1.0f - weight_b - weight_c;
+
+                if (weight_a < 0.0f || weight_b < 0.0f || weight_c < 0.0f)
+                    continue;
+
+                glm::vec3 const position = weight_a * a.position + weight_b * b.position + weight_c * c.position;
+                glm::vec3 const normal = weight_a * a.normal + weight_b * b.normal + weight_c * c.normal;
+
+                texel_points[y * resolution + x] = static_cast<i32>(points.size());
+                points.emplace_back(mesh.transform * glm::vec4(position, 1.0f), normal_matrix * normal);
+            }
+        }
+    }
+
+    std::vector<float> const values = bake_points(points, settings);
+    std::vector<float> lightmap(texel_count, 1.0f);
+    std::vector<bool> is_covered(texel_count, false);
+
+    for (size_t texel = 0; texel < texel_count; ++texel)
+    {
+        if (texel_points[texel] < 0)
+            continue;
+
+        lightmap[texel] = values[texel_points[texel]];
+        is_covered[texel] = true;
+    }
+
+    // Grows the covered texels a few texels into the gaps between the UV islands.
+    i32 constexpr dilation_passes = 4;
+
+    for (i32 pass = 0; pass < dilation_passes; ++pass)
+    {
+        std::vector<bool> was_covered = is_covered;
+
+        for (i32 y = 0; y < resolution; ++y)
+        {
+            for (i32 x = 0; x < resolution; ++x)
+            {
+                i32 const texel = y * resolution + x;
+
+                if (was_covered[texel])
+                    continue;
+
+                float sum = 0.0f;
+                i32 count = 0;
+
+                for (auto const& [dx, dy] : {std::pair {-1, 0}, std::pair {1, 0}, std::pair {0, -1}, std::pair {0, 1}})
+                {
+                    i32 const nx = x + dx;
+                    i32 const ny = y + dy;
+
+                    if (nx < 0 || ny < 0 || nx >= resolution || ny >= resolution || !was_covered[ny * resolution + nx])
+                        continue;
+
+                    sum += lightmap[ny * resolution + nx];
+                    count += 1;
+                }
+
+                if (count == 0)
+                    continue;
+
+                lightmap[texel] = sum / static_cast<float>(count);
+                is_covered[texel] = true;
+            }
+        }
+    }
+
+    return lightmap;
+}
+
+bool AmbientOcclusionBaker::save_lightmap(std::string const& path, std::vector<float> const& lightmap, i32 const resolution)
+{
+    std::error_code error = {};
+    std::filesystem::path const parent = std::filesystem::path(path).parent_path();
+
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+
+    std::ofstream output(path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        std::cout << "Could not write the AO lightmap: " << path << "\n";
+        return false;
+    }
+
+    output << "P5\n" << resolution << ' ' << resolution << "\n255\n";
+
+    for (float const value : lightmap)
+    {
+        output.put(static_cast<char>(static_cast<u8>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 255.0f))));
+    }
+
+    return static_cast<bool>(output);
+}
+
+std::vector<float> AmbientOcclusionBaker::bake_points(std::vector<BakePoint> const& points, AmbientOcclusionSettings const& settings) const
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    std::vector<float> values(points.size(), 1.0f);
+
+    // Points are handed out in chunks, a single point is too little work to be worth the atomic.
+    size_t constexpr chunk_size = 64;
+    std::atomic<size_t> next_point = 0;
+
+    auto const bake_chunks = [&] {
+        for (size_t first = next_point.fetch_add(chunk_size); first < points.size(); first = next_point.fetch_add(chunk_size))
+        {
+            for (size_t i = first; i < std::min(first + chunk_size, points.size()); ++i)
+            {
+                float const normal_length = glm::length(points[i].normal);
+
+                // Vertices without a normal have no hemisphere to test.
+                if (normal_length <= 0.0f)
+                    continue;
+
+                // Seeded by the point, so the result does not depend on the thread count.
+                u64 hash = AK::HASH_OFFSET_BASIS;
+                AK::hash_bytes(hash, &settings.seed, sizeof(settings.seed));
+                AK::hash_bytes(hash, &i, sizeof(i));
+                AK::seed_random(hash);
+
+                glm::vec3 const normal = points[i].normal / normal_length;
+                glm::vec3 const origin = points[i].position + normal * m_bias;
+
+                i32 occluded_count = 0;
+
+                for (i32 ray = 0; ray < settings.ray_count; ++ray)
+                {
+                    HitRecord hit_record = {};
+
+                    bool const is_hit = m_bvh->hit(Ray(origin, cosine_direction(normal)), Interval(0.0f, settings.radius), hit_record);
+
+                    // Surfaces the point lies on, like the floor under the bottom edge of a wall, only block the rays going into them.
+                    if (is_hit && (hit_record.t > m_bias || hit_record.front_face))
+                        occluded_count += 1;
+                }
+
+                values[i] = 1.0f - static_cast<float>(occluded_count) / static_cast<float>(std::max(1, settings.ray_count));
+            }
+        }
+    };
+
+    i32 const thread_count = settings.thread_count > 0 ? settings.thread_count
+                                                       : static_cast<i32>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(thread_count - 1);
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(bake_chunks);
+    }
+
+    bake_chunks();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::chrono::duration<double> const bake_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "AO bake time: " << bake_time.count() << " s (" << points.size() << " points, " << settings.ray_count << " rays each, "
+              << thread_count << " threads)\n";
+
+    return values;
+}
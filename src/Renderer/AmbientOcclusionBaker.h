@@ -0,0 +1,77 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "AK/Types.h"
+#include "Vertex.h"
+
+#include <glm/mat4x4.hpp>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class BVH;
+class Hittable;
+
+// Triangle list of a mesh, e.g. the vertices and indices of a Mesh of a Model, with the matrix placing it in the world.
+struct AmbientOcclusionMesh
+{
+    std::span<Vertex const> vertices = {};
+    std::span<u32 const> indices = {};
+    glm::mat4 transform = glm::mat4(1.0f);
+};
+
+struct AmbientOcclusionSettings
+{
+    i32 ray_count = 64;
+
+    // Geometry further away than this does not occlude, in world units.
+    float radius = 1.0f;
+
+    // 0 uses every hardware thread.
+    i32 thread_count = 0;
+
+    u64 seed = 0;
+};
+
+// Bakes ambient occlusion of static meshes with the raytracer BVH, so SSAO can be turned off for them. Every mesh
+// given to create() occludes every other one. Values are 1 for unoccluded and 0 for fully occluded points,
+// averaged over cosine weighted occlusion rays.
+class AmbientOcclusionBaker
+{
+public:
+    static std::shared_ptr<AmbientOcclusionBaker> create(std::vector<AmbientOcclusionMesh> const& meshes);
+
+    explicit AmbientOcclusionBaker(AK::Badge<AmbientOcclusionBaker>, std::vector<AmbientOcclusionMesh> const& meshes);
+
+    // One value per vertex of the mesh, meant to be stored next to the vertex data.
+    [[nodiscard]] std::vector<float> bake_vertices(size_t const mesh_index, AmbientOcclusionSettings const& settings) const;
+
+    // resolution x resolution texels over the texture coordinates of the mesh, rows from v = 0 down. The texture coordinates
+    // must not overlap. Texels no triangle covers take the value of a covered neighbour, so filtering does not bleed
+    // dark borders into the seams.
+    [[nodiscard]] std::vector<float> bake_lightmap(size_t const mesh_index, i32 const resolution,
+                                                   AmbientOcclusionSettings const& settings) const;
+
+    // 8-bit grayscale binary PGM, readable by the texture loader.
+    static bool save_lightmap(std::string const& path, std::vector<float> const& lightmap, i32 const resolution);
+
+private:
+    struct BakePoint
+    {
+        glm::vec3 position = {};
+        glm::vec3 normal = {};
+    };
+
+    [[nodiscard]] std::vector<float> bake_points(std::vector<BakePoint> const& points, AmbientOcclusionSettings const& settings) const;
+
+    std::vector<AmbientOcclusionMesh> m_meshes = {};
+
+    // Not owned by the BVH.
+    std::vector<std::shared_ptr<Hittable>> m_triangles = {};
+    std::shared_ptr<BVH> m_bvh = {};
+
+    // Offset of the ray origins from the surface, relative to the size of the scene.
+    float m_bias = 0.0f;
+};
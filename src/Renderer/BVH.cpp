@@ -0,0 +1,749 @@
+#include "BVH.h"
+
+#include "AK/Math.h"
+#include "QuadRaytraced.h"
+#include "RaytracerStatistics.h"
+#include "RotateYHittable.h"
+#include "SphereRaytraced.h"
+#include "TranslateHittable.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// World space geometry of a sphere or a quad, with the rotations and translations wrapping it applied.
+struct FlatPrimitive
+{
+    enum class Kind : u8
+    {
+        Other,
+        Sphere,
+        Quad,
+    };
+
+    Kind kind = Kind::Other;
+
+    glm::vec3 center = {};
+    float radius = 0.0f;
+
+    glm::vec3 q = {};
+    glm::vec3 u = {};
+    glm::vec3 v = {};
+};
+
+static bool flatten(Hittable const* hittable, FlatPrimitive& primitive)
+{
+    if (auto const sphere = dynamic_cast<SphereRaytraced const*>(hittable); sphere != nullptr)
+    {
+        primitive.kind = FlatPrimitive::Kind::Sphere;
+        primitive.center = sphere->center();
+        primitive.radius = sphere->radius();
+        return true;
+    }
+
+    if (auto const quad = dynamic_cast<QuadRaytraced const*>(hittable); quad != nullptr)
+    {
+        primitive.kind = FlatPrimitive::Kind::Quad;
+        primitive.q = quad->q();
+        primitive.u = quad->u();
+        primitive.v = quad->v();
+        return true;
+    }
+
+    // Moving hittables have no single world space geometry, they are tested one by one at the time of the ray.
+    if (auto const rotate = dynamic_cast<RotateYHittable const*>(hittable); rotate != nullptr)
+    {
+        if (rotate->motion() != 0.0f || !flatten(rotate->hittable().get(), primitive))
+            return false;
+
+        primitive.center = rotate->to_world(primitive.center);
+        primitive.q = rotate->to_world(primitive.q);
+        primitive.u = rotate->to_world(primitive.u);
+        primitive.v = rotate->to_world(primitive.v);
+        return true;
+    }
+
+    if (auto const translate = dynamic_cast<TranslateHittable const*>(hittable); translate != nullptr)
+    {
+        if (translate->motion() != glm::vec3(0.0f) || !flatten(translate->hittable().get(), primitive))
+            return false;
+
+        primitive.center += translate->offset();
+        primitive.q += translate->offset();
+        return true;
+    }
+
+    return false;
+}
+
+std::shared_ptr<BVH> BVH::build(std::vector<std::shared_ptr<Hittable>> const& hittables, AK::Arena* const arena,
+                                AK::Arena* const scratch_arena)
+{
+    auto bvh = std::make_shared<BVH>(AK::Badge<BVH> {}, arena);
+
+    bvh->m_owned_primitive_order.resize(hittables.size());
+    std::iota(bvh->m_owned_primitive_order.begin(), bvh->m_owned_primitive_order.end(), 0);
+
+    if (!hittables.empty())
+    {
+        // The bounds are read by every sort comparison, so they are gathered once instead of going through the hittables.
+        AK::ArenaScope const scratch_scope(scratch_arena);
+        auto bounds = AK::ArenaVector<AABB>(AK::ArenaAllocator<AABB>(scratch_arena));
+        bounds.reserve(hittables.size());
+
+        for (auto const& hittable : hittables)
+        {
+            bounds.emplace_back(hittable->bounding_box());
+        }
+
+        // Exact size, growing a vector in an arena would leave every outgrown buffer behind.
+        bvh->m_owned_nodes.reserve(node_count(hittables.size()));
+        build_recursive(bounds, bvh->m_owned_primitive_order, 0, hittables.size(), bvh->m_owned_nodes);
+    }
+
+    bvh->m_nodes = bvh->m_owned_nodes;
+    bvh->m_primitive_order = bvh->m_owned_primitive_order;
+    bvh->set_primitives(hittables);
+    bvh->set_leaf_blocks(scratch_arena);
+    bvh->set_motion_bounds();
+
+    return bvh;
+}
+
+std::shared_ptr<BVH> BVH::create(std::vector<std::shared_ptr<Hittable>> const& hittables, std::span<BVHNode const> const nodes,
+                                 std::span<u32 const> const primitive_order, std::shared_ptr<AK::MappedFile> const& storage,
+                                 AK::Arena* const arena, AK::Arena* const scratch_arena)
+{
+    auto bvh = std::make_shared<BVH>(AK::Badge<BVH> {}, arena);
+
+    bvh->m_storage = storage;
+    bvh->m_nodes = nodes;
+    bvh->m_primitive_order = primitive_order;
+    bvh->set_primitives(hittables);
+    bvh->set_leaf_blocks(scratch_arena);
+    bvh->set_motion_bounds();
+
+    return bvh;
+}
+
+BVH::BVH(AK::Badge<BVH>, AK::Arena* const arena)
+    : m_owned_nodes(AK::ArenaAllocator<BVHNode>(arena)), m_owned_primitive_order(AK::ArenaAllocator<u32>(arena)),
+      m_primitives(AK::ArenaAllocator<Hittable const*>(arena)), m_leaf_blocks(AK::ArenaAllocator<LeafBlocks>(arena)),
+      m_sphere_blocks(AK::ArenaAllocator<SphereBlock>(arena)), m_quad_blocks(AK::ArenaAllocator<QuadBlock>(arena)),
+      m_other_primitives(AK::ArenaAllocator<u32>(arena)), m_motion_bounds(AK::ArenaAllocator<MotionBounds>(arena))
+{
+}
+
+bool BVH::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    // Deeper than any tree built with median splits over 2^32 primitives can get.
+    std::array<u32, 64> stack = {};
+    u32 stack_size = 0;
+    stack[stack_size++] = 0;
+
+    float closest = ray_t.max;
+    bool hit_anything = false;
+
+    while (stack_size > 0)
+    {
+        BVHNode const& node = m_nodes[stack[--stack_size]];
+
+        visited_nodes += 1;
+
+        RAYTRACER_STAT_ADD(bvh_nodes_visited, 1);
+        RAYTRACER_STAT_ADD(aabb_tests, 1);
+
+        u32 const node_index = static_cast<u32>(&node - m_nodes.data());
+        Interval const node_t = Interval(ray_t.min, closest);
+        bool const is_node_hit = m_motion_bounds.empty() ? node.bbox.hit(ray, node_t)
+                                                         : m_motion_bounds[node_index].at(ray.time()).hit(ray, node_t);
+
+        if (!is_node_hit)
+            continue;
+
+        if (node.primitive_count > 0)
+        {
+            if (hit_leaf(node_index, ray, ray_t.min, closest, hit_record))
+                hit_anything = true;
+
+            continue;
+        }
+
+        // Right child is pushed first, so the left one is visited first like in the recursive traversal.
+        stack[stack_size++] = node.offset;
+        stack[stack_size++] = node_index + 1;
+    }
+
+    return hit_anything;
+}
+
+void BVH::refit(AK::Arena* const scratch_arena)
+{
+    // Nodes mapped from the cache are read only, they are copied on the first refit.
+    if (m_owned_nodes.data() != m_nodes.data())
+    {
+        m_owned_nodes.assign(m_nodes.begin(), m_nodes.end());
+        m_nodes = m_owned_nodes;
+    }
+
+    // Children are stored after their parent, so walking the array backwards visits them first.
+    for (size_t i = m_owned_nodes.size(); i-- > 0;)
+    {
+        BVHNode& node = m_owned_nodes[i];
+        AABB bbox = AABB::empty;
+
+        if (node.primitive_count > 0)
+        {
+            for (u32 primitive = node.offset; primitive < node.offset + node.primitive_count; ++primitive)
+            {
+                bbox = AABB(bbox, m_primitives[primitive]->bounding_box());
+            }
+        }
+        else
+        {
+            bbox = AABB(m_owned_nodes[i + 1].bbox, m_owned_nodes[node.offset].bbox);
+        }
+
+        node.bbox = bbox;
+    }
+
+    set_leaf_blocks(scratch_arena);
+    set_motion_bounds();
+}
+
+AABB BVH::bounding_box() const
+{
+    if (m_nodes.empty())
+        return AABB::empty;
+
+    return m_nodes[0].bbox;
+}
+
+bool BVH::has_motion() const
+{
+    return !m_motion_bounds.empty();
+}
+
+std::span<BVHNode const> BVH::nodes() const
+{
+    return m_nodes;
+}
+
+std::span<u32 const> BVH::primitive_order() const
+{
+    return m_primitive_order;
+}
+
+size_t BVH::node_count(size_t const primitive_count)
+{
+    // Mirrors the splits of build_recursive().
+    if (primitive_count <= max_leaf_size)
+        return 1;
+
+    return 1 + node_count(primitive_count / 2) + node_count(primitive_count - primitive_count / 2);
+}
+
+u32 BVH::build_recursive(std::span<AABB const> const bounds, AK::ArenaVector<u32>& primitive_order, size_t const start,
+                         size_t const end, AK::ArenaVector<BVHNode>& nodes)
+{
+    // Build the bounding box of the span of source hittables.
+    AABB bbox = AABB::empty;
+
+    for (size_t index = start; index < end; ++index)
+    {
+        bbox = AABB(bbox, bounds[primitive_order[index]]);
+    }
+
+    auto const node_index = static_cast<u32>(nodes.size());
+    nodes.emplace_back();
+    nodes[node_index].bbox = bbox;
+
+    size_t const hittables_span = end - start;
+
+    if (hittables_span <= max_leaf_size)
+    {
+        nodes[node_index].offset = static_cast<u32>(start);
+        nodes[node_index].primitive_count = static_cast<u32>(hittables_span);
+        return node_index;
+    }
+
+    i32 const axis = bbox.longest_axis();
+
+    std::sort(primitive_order.begin() + static_cast<i64>(start), primitive_order.begin() + static_cast<i64>(end),
+              [&](u32 const a, u32 const b) { return bounds[a].axis_interval(axis).min < bounds[b].axis_interval(axis).min; });
+
+    size_t const mid = start + hittables_span / 2;
+
+    build_recursive(bounds, primitive_order, start, mid, nodes);
+    u32 const right = build_recursive(bounds, primitive_order, mid, end, nodes);
+
+    nodes[node_index].offset = right;
+
+    return node_index;
+}
+
+void BVH::set_primitives(std::vector<std::shared_ptr<Hittable>> const& hittables)
+{
+    m_primitives.clear();
+    m_primitives.reserve(m_primitive_order.size());
+
+    for (u32 const index : m_primitive_order)
+    {
+        m_primitives.emplace_back(hittables[index].get());
+    }
+}
+
+void BVH::set_leaf_blocks(AK::Arena* const scratch_arena)
+{
+    // First pass flattens every primitive and counts the blocks, so the arrays are allocated once at their final size.
+    AK::ArenaScope const scratch_scope(scratch_arena);
+    AK::ArenaVector<FlatPrimitive> primitives(m_primitives.size(), AK::ArenaAllocator<FlatPrimitive>(scratch_arena));
+
+    for (size_t i = 0; i < m_primitives.size(); ++i)
+    {
+        if (!flatten(m_primitives[i], primitives[i]))
+            primitives[i].kind = FlatPrimitive::Kind::Other;
+    }
+
+    size_t sphere_block_count = 0;
+    size_t quad_block_count = 0;
+    size_t other_count = 0;
+
+    for (BVHNode const& node : m_nodes)
+    {
+        size_t sphere_count = 0;
+        size_t quad_count = 0;
+
+        for (u32 i = node.offset; i < node.offset + node.primitive_count; ++i)
+        {
+            sphere_count += primitives[i].kind == FlatPrimitive::Kind::Sphere ? 1 : 0;
+            quad_count += primitives[i].kind == FlatPrimitive::Kind::Quad ? 1 : 0;
+            other_count += primitives[i].kind == FlatPrimitive::Kind::Other ? 1 : 0;
+        }
+
+        sphere_block_count += (sphere_count + block_size - 1) / block_size;
+        quad_block_count += (quad_count + block_size - 1) / block_size;
+    }
+
+    m_leaf_blocks.assign(m_nodes.size(), {});
+    m_sphere_blocks.clear();
+    m_sphere_blocks.reserve(sphere_block_count);
+    m_quad_blocks.clear();
+    m_quad_blocks.reserve(quad_block_count);
+    m_other_primitives.clear();
+    m_other_primitives.reserve(other_count);
+
+    for (u32 node_index = 0; node_index < m_nodes.size(); ++node_index)
+    {
+        BVHNode const& node = m_nodes[node_index];
+
+        if (node.primitive_count == 0)
+            continue;
+
+        LeafBlocks& leaf = m_leaf_blocks[node_index];
+        leaf.first_sphere_block = static_cast<u32>(m_sphere_blocks.size());
+        leaf.first_quad_block = static_cast<u32>(m_quad_blocks.size());
+        leaf.first_other = static_cast<u32>(m_other_primitives.size());
+
+        // Start with full blocks, so the first primitive of each kind opens a new one.
+        u32 sphere_lane = block_size;
+        u32 quad_lane = block_size;
+
+        for (u32 i = node.offset; i < node.offset + node.primitive_count; ++i)
+        {
+            FlatPrimitive const& primitive = primitives[i];
+
+            if (primitive.kind == FlatPrimitive::Kind::Other)
+            {
+                m_other_primitives.emplace_back(i);
+                continue;
+            }
+
+            if (primitive.kind == FlatPrimitive::Kind::Sphere)
+            {
+                if (sphere_lane == block_size)
+                {
+                    // NaN centers make every test of an unused lane fail.
+                    SphereBlock& new_block = m_sphere_blocks.emplace_back();
+                    std::ranges::fill(new_block.center_x, std::numeric_limits<float>::quiet_NaN());
+                    sphere_lane = 0;
+                }
+
+                SphereBlock& block = m_sphere_blocks.back();
+                block.center_x[sphere_lane] = primitive.center.x;
+                block.center_y[sphere_lane] = primitive.center.y;
+                block.center_z[sphere_lane] = primitive.center.z;
+                block.radius_squared[sphere_lane] = primitive.radius * primitive.radius;
+                block.primitive[sphere_lane] = i;
+                sphere_lane += 1;
+                continue;
+            }
+
+            // Unused lanes keep a zero normal, so they fail the parallel ray test.
+            if (quad_lane == block_size)
+            {
+                m_quad_blocks.emplace_back();
+                quad_lane = 0;
+            }
+
+            // Same plane setup as QuadRaytraced. The planar coordinates dot(w, cross(p, v)) and dot(w, cross(u, p))
+            // are rewritten as dot(p, cross(v, w)) and dot(p, cross(w, u)).
+            glm::vec3 const n = glm::cross(primitive.u, primitive.v);
+            glm::vec3 const normal = glm::normalize(n);
+            glm::vec3 const w = n / glm::dot(n, n);
+            glm::vec3 const alpha = glm::cross(primitive.v, w);
+            glm::vec3 const beta = glm::cross(w, primitive.u);
+
+            QuadBlock& block = m_quad_blocks.back();
+            block.q_x[quad_lane] = primitive.q.x;
+            block.q_y[quad_lane] = primitive.q.y;
+            block.q_z[quad_lane] = primitive.q.z;
+            block.normal_x[quad_lane] = normal.x;
+            block.normal_y[quad_lane] = normal.y;
+            block.normal_z[quad_lane] = normal.z;
+            block.d[quad_lane] = glm::dot(normal, primitive.q);
+            block.alpha_x[quad_lane] = alpha.x;
+            block.alpha_y[quad_lane] = alpha.y;
+            block.alpha_z[quad_lane] = alpha.z;
+            block.beta_x[quad_lane] = beta.x;
+            block.beta_y[quad_lane] = beta.y;
+            block.beta_z[quad_lane] = beta.z;
+            block.primitive[quad_lane] = i;
+            quad_lane += 1;
+        }
+
+        leaf.sphere_block_count = static_cast<u32>(m_sphere_blocks.size()) - leaf.first_sphere_block;
+        leaf.quad_block_count = static_cast<u32>(m_quad_blocks.size()) - leaf.first_quad_block;
+        leaf.other_count = static_cast<u32>(m_other_primitives.size()) - leaf.first_other;
+    }
+}
+
+void BVH::set_motion_bounds()
+{
+    bool const has_motion = std::ranges::any_of(m_primitives, [](Hittable const* primitive) {
+        AABB const open = primitive->bounding_box_at(0.0f);
+        AABB const close = primitive->bounding_box_at(1.0f);
+
+        return open.x.min != close.x.min || open.x.max != close.x.max || open.y.min != close.y.min || open.y.max != close.y.max
+            || open.z.min != close.z.min || open.z.max != close.z.max;
+    });
+
+    // Static scenes keep testing the node bounds directly.
+    if (!has_motion)
+    {
+        m_motion_bounds.clear();
+        return;
+    }
+
+    m_motion_bounds.resize(m_nodes.size());
+
+    // Same bottom-up walk as refit().
+    for (size_t i = m_nodes.size(); i-- > 0;)
+    {
+        BVHNode const& node = m_nodes[i];
+        MotionBounds& bounds = m_motion_bounds[i];
+
+        if (node.primitive_count > 0)
+        {
+            bounds = {AABB::empty, AABB::empty};
+
+            for (u32 primitive = node.offset; primitive < node.offset + node.primitive_count; ++primitive)
+            {
+                bounds.open = AABB(bounds.open, m_primitives[primitive]->bounding_box_at(0.0f));
+                bounds.close = AABB(bounds.close, m_primitives[primitive]->bounding_box_at(1.0f));
+            }
+        }
+        else
+        {
+            bounds.open = AABB(m_motion_bounds[i + 1].open, m_motion_bounds[node.offset].open);
+            bounds.close = AABB(m_motion_bounds[i + 1].close, m_motion_bounds[node.offset].close);
+        }
+    }
+}
+
+AABB BVH::MotionBounds::at(float const time) const
+{
+    // Hittables moving along straight lines stay inside the interpolated bounds of their own, and so of every node above them.
+    return {Interval(glm::mix(open.x.min, close.x.min, time), glm::mix(open.x.max, close.x.max, time)),
+            Interval(glm::mix(open.y.min, close.y.min, time), glm::mix(open.y.max, close.y.max, time)),
+            Interval(glm::mix(open.z.min, close.z.min, time), glm::mix(open.z.max, close.z.max, time))};
+}
+
+bool BVH::hit_leaf(u32 const node_index, Ray const& ray, float const t_min, float& closest, HitRecord& hit_record) const
+{
+    LeafBlocks const& leaf = m_leaf_blocks[node_index];
+    bool hit_anything = false;
+
+    if (leaf.sphere_block_count + leaf.quad_block_count > 0)
+    {
+        RAYTRACER_STAT_ADD(primitive_tests[static_cast<size_t>(PrimitiveType::Sphere)], leaf.sphere_block_count * block_size);
+        RAYTRACER_STAT_ADD(primitive_tests[static_cast<size_t>(PrimitiveType::Quad)], leaf.quad_block_count * block_size);
+
+        // The quad kernel only looks for hits closer than the sphere candidate.
+        float candidate_t = closest;
+        u32 candidate = closest_sphere(m_sphere_blocks.data() + leaf.first_sphere_block, leaf.sphere_block_count, ray, t_min, candidate_t);
+
+        if (u32 const quad = closest_quad(m_quad_blocks.data() + leaf.first_quad_block, leaf.quad_block_count, ray, t_min, candidate_t);
+            quad != no_primitive)
+        {
+            candidate = quad;
+        }
+
+        if (candidate != no_primitive)
+        {
+            if (m_primitives[candidate]->hit(ray, Interval(t_min, closest), hit_record))
+            {
+                hit_anything = true;
+                closest = hit_record.t;
+            }
+            else
+            {
+                // The kernel and the hittable disagree on a hit at the limit of float precision,
+                // fall back to testing the whole leaf one by one.
+                BVHNode const& node = m_nodes[node_index];
+
+                for (u32 i = node.offset; i < node.offset + node.primitive_count; ++i)
+                {
+                    if (m_primitives[i]->hit(ray, Interval(t_min, closest), hit_record))
+                    {
+                        hit_anything = true;
+                        closest = hit_record.t;
+                    }
+                }
+
+                return hit_anything;
+            }
+        }
+    }
+
+    for (u32 i = leaf.first_other; i < leaf.first_other + leaf.other_count; ++i)
+    {
+        if (m_primitives[m_other_primitives[i]]->hit(ray, Interval(t_min, closest), hit_record))
+        {
+            hit_anything = true;
+            closest = hit_record.t;
+        }
+    }
+
+    return hit_anything;
+}
+
+u32 BVH::closest_sphere(SphereBlock const* blocks, u32 const block_count, Ray const& ray, float const t_min, float& t_max)
+{
+    // Same root selection as SphereRaytraced::hit(): the near root if it is inside (t_min, t_max), otherwise the far one.
+    glm::vec3 const& origin = ray.origin();
+    glm::vec3 const& direction = ray.direction();
+    float const a = glm::dot(direction, direction);
+
+    u32 closest = no_primitive;
+
+#if defined(__AVX2__)
+    __m256 const origin_x = _mm256_set1_ps(origin.x);
+    __m256 const origin_y = _mm256_set1_ps(origin.y);
+    __m256 const origin_z = _mm256_set1_ps(origin.z);
+    __m256 const direction_x = _mm256_set1_ps(direction.x);
+    __m256 const direction_y = _mm256_set1_ps(direction.y);
+    __m256 const direction_z = _mm256_set1_ps(direction.z);
+    __m256 const a_wide = _mm256_set1_ps(a);
+    __m256 const t_min_wide = _mm256_set1_ps(t_min);
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const infinity = _mm256_set1_ps(AK::INFINITY_F);
+
+    for (u32 block_index = 0; block_index < block_count; ++block_index)
+    {
+        SphereBlock const& block = blocks[block_index];
+        __m256 const t_max_wide = _mm256_set1_ps(t_max);
+
+        __m256 const origin_center_x = _mm256_sub_ps(_mm256_load_ps(block.center_x), origin_x);
+        __m256 const origin_center_y = _mm256_sub_ps(_mm256_load_ps(block.center_y), origin_y);
+        __m256 const origin_center_z = _mm256_sub_ps(_mm256_load_ps(block.center_z), origin_z);
+
+        __m256 const h = _mm256_fmadd_ps(direction_z, origin_center_z,
+                                         _mm256_fmadd_ps(direction_y, origin_center_y, _mm256_mul_ps(direction_x, origin_center_x)));
+        __m256 const c = _mm256_fmadd_ps(
+            origin_center_z, origin_center_z,
+            _mm256_fmadd_ps(origin_center_y, origin_center_y,
+                            _mm256_fmsub_ps(origin_center_x, origin_center_x, _mm256_load_ps(block.radius_squared))));
+
+        __m256 const discriminant = _mm256_fmsub_ps(h, h, _mm256_mul_ps(a_wide, c));
+        __m256 const has_roots = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+        __m256 const sqrt_discriminant = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+
+        __m256 const near_root = _mm256_div_ps(_mm256_sub_ps(h, sqrt_discriminant), a_wide);
+        __m256 const far_root = _mm256_div_ps(_mm256_add_ps(h, sqrt_discriminant), a_wide);
+
+        __m256 const near_valid =
+            _mm256_and_ps(_mm256_cmp_ps(near_root, t_min_wide, _CMP_GT_OQ), _mm256_cmp_ps(near_root, t_max_wide, _CMP_LT_OQ));
+        __m256 const far_valid =
+            _mm256_and_ps(_mm256_cmp_ps(far_root, t_min_wide, _CMP_GT_OQ), _mm256_cmp_ps(far_root, t_max_wide, _CMP_LT_OQ));
+
+        __m256 const is_hit = _mm256_and_ps(has_roots, _mm256_or_ps(near_valid, far_valid));
+
+        if (_mm256_movemask_ps(is_hit) == 0)
+            continue;
+
+        __m256 const root = _mm256_blendv_ps(far_root, near_root, near_valid);
+
+        alignas(32) float roots[block_size];
+        _mm256_store_ps(roots, _mm256_blendv_ps(infinity, root, is_hit));
+
+        for (u32 lane = 0; lane < block_size; ++lane)
+        {
+            if (roots[lane] < t_max)
+            {
+                t_max = roots[lane];
+                closest = block.primitive[lane];
+            }
+        }
+    }
+#else
+    for (u32 block_index = 0; block_index < block_count; ++block_index)
+    {
+        SphereBlock const& block = blocks[block_index];
+
+        for (u32 lane = 0; lane < block_size; ++lane)
+        {
+            glm::vec3 const origin_center = glm::vec3(block.center_x[lane], block.center_y[lane], block.center_z[lane]) - origin;
+            float const h = glm::dot(direction, origin_center);
+            float const c = glm::dot(origin_center, origin_center) - block.radius_squared[lane];
+            float const discriminant = h * h - a * c;
+
+            if (!(discriminant >= 0.0f))
+                continue;
+
+            float const sqrt_discriminant = std::sqrt(discriminant);
+            float root = (h - sqrt_discriminant) / a;
+
+            if (root <= t_min || t_max <= root)
+            {
+                root = (h + sqrt_discriminant) / a;
+
+                if (root <= t_min || t_max <= root)
+                    continue;
+            }
+
+            t_max = root;
+            closest = block.primitive[lane];
+        }
+    }
+#endif
+
+    return closest;
+}
+
+u32 BVH::closest_quad(QuadBlock const* blocks, u32 const block_count, Ray const& ray, float const t_min, float& t_max)
+{
+    // Same tests as QuadRaytraced::hit(): not parallel to the plane, t inside [t_min, t_max], planar coordinates inside [0, 1].
+    glm::vec3 const& origin = ray.origin();
+    glm::vec3 const& direction = ray.direction();
+
+    u32 closest = no_primitive;
+
+#if defined(__AVX2__)
+    __m256 const origin_x = _mm256_set1_ps(origin.x);
+    __m256 const origin_y = _mm256_set1_ps(origin.y);
+    __m256 const origin_z = _mm256_set1_ps(origin.z);
+    __m256 const direction_x = _mm256_set1_ps(direction.x);
+    __m256 const direction_y = _mm256_set1_ps(direction.y);
+    __m256 const direction_z = _mm256_set1_ps(direction.z);
+    __m256 const t_min_wide = _mm256_set1_ps(t_min);
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const one = _mm256_set1_ps(1.0f);
+    __m256 const parallel_epsilon = _mm256_set1_ps(0.000001f);
+    __m256 const sign_mask = _mm256_set1_ps(-0.0f);
+    __m256 const infinity = _mm256_set1_ps(AK::INFINITY_F);
+
+    for (u32 block_index = 0; block_index < block_count; ++block_index)
+    {
+        QuadBlock const& block = blocks[block_index];
+        __m256 const t_max_wide = _mm256_set1_ps(t_max);
+
+        __m256 const normal_x = _mm256_load_ps(block.normal_x);
+        __m256 const normal_y = _mm256_load_ps(block.normal_y);
+        __m256 const normal_z = _mm256_load_ps(block.normal_z);
+
+        __m256 const denominator =
+            _mm256_fmadd_ps(normal_z, direction_z, _mm256_fmadd_ps(normal_y, direction_y, _mm256_mul_ps(normal_x, direction_x)));
+        __m256 const normal_origin =
+            _mm256_fmadd_ps(normal_z, origin_z, _mm256_fmadd_ps(normal_y, origin_y, _mm256_mul_ps(normal_x, origin_x)));
+        __m256 const t = _mm256_div_ps(_mm256_sub_ps(_mm256_load_ps(block.d), normal_origin), denominator);
+
+        __m256 const not_parallel = _mm256_cmp_ps(_mm256_andnot_ps(sign_mask, denominator), parallel_epsilon, _CMP_GE_OQ);
+        __m256 const in_range = _mm256_and_ps(_mm256_cmp_ps(t, t_min_wide, _CMP_GE_OQ), _mm256_cmp_ps(t, t_max_wide, _CMP_LE_OQ));
+        __m256 is_hit = _mm256_and_ps(not_parallel, in_range);
+
+        if (_mm256_movemask_ps(is_hit) == 0)
+            continue;
+
+        __m256 const planar_x = _mm256_fmadd_ps(t, direction_x, _mm256_sub_ps(origin_x, _mm256_load_ps(block.q_x)));
+        __m256 const planar_y = _mm256_fmadd_ps(t, direction_y, _mm256_sub_ps(origin_y, _mm256_load_ps(block.q_y)));
+        __m256 const planar_z = _mm256_fmadd_ps(t, direction_z, _mm256_sub_ps(origin_z, _mm256_load_ps(block.q_z)));
+
+        __m256 const alpha = _mm256_fmadd_ps(
+            planar_z, _mm256_load_ps(block.alpha_z),
+            _mm256_fmadd_ps(planar_y, _mm256_load_ps(block.alpha_y), _mm256_mul_ps(planar_x, _mm256_load_ps(block.alpha_x))));
+        __m256 const beta = _mm256_fmadd_ps(
+            planar_z, _mm256_load_ps(block.beta_z),
+            _mm256_fmadd_ps(planar_y, _mm256_load_ps(block.beta_y), _mm256_mul_ps(planar_x, _mm256_load_ps(block.beta_x))));
+
+        is_hit = _mm256_and_ps(is_hit, _mm256_and_ps(_mm256_cmp_ps(alpha, zero, _CMP_GE_OQ), _mm256_cmp_ps(alpha, one, _CMP_LE_OQ)));
+        is_hit = _mm256_and_ps(is_hit, _mm256_and_ps(_mm256_cmp_ps(beta, zero, _CMP_GE_OQ), _mm256_cmp_ps(beta, one, _CMP_LE_OQ)));
+
+        if (_mm256_movemask_ps(is_hit) == 0)
+            continue;
+
+        alignas(32) float distances[block_size];
+        _mm256_store_ps(distances, _mm256_blendv_ps(infinity, t, is_hit));
+
+        for (u32 lane = 0; lane < block_size; ++lane)
+        {
+            if (distances[lane] < t_max)
+            {
+                t_max = distances[lane];
+                closest = block.primitive[lane];
+            }
+        }
+    }
+#else
+    for (u32 block_index = 0; block_index < block_count; ++block_index)
+    {
+        QuadBlock const& block = blocks[block_index];
+
+        for (u32 lane = 0; lane < block_size; ++lane)
+        {
+            glm::vec3 const normal = {block.normal_x[lane], block.normal_y[lane], block.normal_z[lane]};
+            float const denominator = glm::dot(normal, direction);
+
+            if (std::fabs(denominator) < 0.000001f)
+                continue;
+
+            float const t = (block.d[lane] - glm::dot(normal, origin)) / denominator;
+
+            if (t < t_min || t >= t_max)
+                continue;
+
+            glm::vec3 const planar_hit = origin + t * direction - glm::vec3(block.q_x[lane], block.q_y[lane], block.q_z[lane]);
+            float const alpha = glm::dot(planar_hit, glm::vec3(block.alpha_x[lane], block.alpha_y[lane], block.alpha_z[lane]));
+            float const beta = glm::dot(planar_hit, glm::vec3(block.beta_x[lane], block.beta_y[lane], block.beta_z[lane]));
+
+            if (alpha < 0.0f || alpha > 1.0f || beta < 0.0f || beta > 1.0f)
+                continue;
+
+            t_max = t;
+            closest = block.primitive[lane];
+        }
+    }
+#endif
+
+    return closest;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "AK/AABB.h"
+#include "AK/Arena.h"
+#include "AK/Badge.h"
+#include "AK/MappedFile.h"
+#include "Hittable.h"
+
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Nodes are stored depth first in a single array. The left child of an inner node directly follows it,
+// so only the right child has to be stored. The layout is written to the BVH cache as is.
+struct BVHNode
+{
+    AABB bbox = {};
+
+    // Leaf: index of the first primitive. Inner node: index of the right child.
+    u32 offset = 0;
+
+    // 0 for inner nodes.
+    u32 primitive_count = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<BVHNode>, "BVHNode is memory mapped from the BVH cache.");
+
+class BVH
+{
+public:
+    // Builds over the hittables in the given order. The vector itself is not modified, the order the leaves
+    // reference them in is stored in primitive_order(). The hittables are not owned and have to outlive the BVH.
+    //
+    // Nodes and leaf data are allocated from the arena, which then has to outlive the BVH too. Temporary build data
+    // goes to the scratch arena, it is not referenced once this returns. Without arenas both use the heap.
+    static std::shared_ptr<BVH> build(std::vector<std::shared_ptr<Hittable>> const& hittables, AK::Arena* const arena = nullptr,
+                                      AK::Arena* const scratch_arena = nullptr);
+
+    // Uses already built nodes, e.g. from a mapped cache file. The spans have to stay valid as long as the storage is alive.
+    static std::shared_ptr<BVH> create(std::vector<std::shared_ptr<Hittable>> const& hittables, std::span<BVHNode const> const nodes,
+                                       std::span<u32 const> const primitive_order, std::shared_ptr<AK::MappedFile> const& storage,
+                                       AK::Arena* const arena = nullptr, AK::Arena* const scratch_arena = nullptr);
+
+    explicit BVH(AK::Badge<BVH>, AK::Arena* const arena);
+
+    [[nodiscard]] bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const;
+
+    // Updates the node bounds and leaf geometry after hittables moved, keeping the tree structure. Much cheaper
+    // than a rebuild, but the tree gets worse the further the hittables move from where it was built.
+    void refit(AK::Arena* const scratch_arena = nullptr);
+
+    [[nodiscard]] AABB bounding_box() const;
+
+    // True if a hittable moves while the shutter is open. Nodes are then tested with their bounds at the time of the ray,
+    // interpolated between the bounds when the shutter opens and closes, rather than with the bounds of the whole exposure.
+    [[nodiscard]] bool has_motion() const;
+
+    [[nodiscard]] std::span<BVHNode const> nodes() const;
+    [[nodiscard]] std::span<u32 const> primitive_order() const;
+
+    // Number of nodes visited by hit() on the calling thread. Used for the traversal cost AOV.
+    inline static thread_local u32 visited_nodes = 0;
+
+    // Leaves hold up to this many primitives, one SIMD block of spheres or quads.
+    static u32 constexpr max_leaf_size = 8;
+
+private:
+    static u32 constexpr block_size = 8;
+
+    // Spheres and quads of the leaves in structure of arrays layout, with rotations and translations already applied.
+    // A block only holds primitives of a single leaf, unused lanes never hit.
+    struct alignas(32) SphereBlock
+    {
+        float center_x[block_size] = {};
+        float center_y[block_size] = {};
+        float center_z[block_size] = {};
+        float radius_squared[block_size] = {};
+
+        // Index into m_primitives.
+        u32 primitive[block_size] = {};
+    };
+
+    struct alignas(32) QuadBlock
+    {
+        float q_x[block_size] = {};
+        float q_y[block_size] = {};
+        float q_z[block_size] = {};
+        float normal_x[block_size] = {};
+        float normal_y[block_size] = {};
+        float normal_z[block_size] = {};
+        float d[block_size] = {};
+
+        // Planar coordinates of a point p on the plane are dot(p - q, alpha) and dot(p - q, beta).
+        float alpha_x[block_size] = {};
+        float alpha_y[block_size] = {};
+        float alpha_z[block_size] = {};
+        float beta_x[block_size] = {};
+        float beta_y[block_size] = {};
+        float beta_z[block_size] = {};
+
+        u32 primitive[block_size] = {};
+    };
+
+    // Primitives of a leaf by kind. Nodes are memory mapped from the cache as is, so this is kept next to them,
+    // indexed by the node index.
+    struct LeafBlocks
+    {
+        u32 first_sphere_block = 0;
+        u32 sphere_block_count = 0;
+        u32 first_quad_block = 0;
+        u32 quad_block_count = 0;
+
+        // Range in m_other_primitives, the hittables that are tested one by one.
+        u32 first_other = 0;
+        u32 other_count = 0;
+    };
+
+    // Kept next to the nodes like LeafBlocks, the cached node layout only holds the bounds of the whole exposure.
+    struct MotionBounds
+    {
+        AABB open = {};
+        AABB close = {};
+
+        [[nodiscard]] AABB at(float const time) const;
+    };
+
+    [[nodiscard]] static size_t node_count(size_t const primitive_count);
+    static u32 build_recursive(std::span<AABB const> const bounds, AK::ArenaVector<u32>& primitive_order, size_t const start,
+                               size_t const end, AK::ArenaVector<BVHNode>& nodes);
+
+    // Closest candidate of the blocks closer than t_max, returns its index into m_primitives or no_primitive and
+    // lowers t_max to its distance. The hit record is filled by the hittable itself afterwards, the kernels only pick which one.
+    [[nodiscard]] static u32 closest_sphere(SphereBlock const* blocks, u32 const block_count, Ray const& ray, float const t_min,
+                                            float& t_max);
+    [[nodiscard]] static u32 closest_quad(QuadBlock const* blocks, u32 const block_count, Ray const& ray, float const t_min,
+                                          float& t_max);
+
+    void set_primitives(std::vector<std::shared_ptr<Hittable>> const& hittables);
+    void set_leaf_blocks(AK::Arena* const scratch_arena);
+    void set_motion_bounds();
+
+    [[nodiscard]] bool hit_leaf(u32 const node_index, Ray const& ray, float const t_min, float& closest, HitRecord& hit_record) const;
+
+    static u32 constexpr no_primitive = 0xFFFFFFFF;
+
+    AK::ArenaVector<BVHNode> m_owned_nodes = {};
+    AK::ArenaVector<u32> m_owned_primitive_order = {};
+    std::shared_ptr<AK::MappedFile> m_storage = {};
+
+    std::span<BVHNode const> m_nodes = {};
+    std::span<u32 const> m_primitive_order = {};
+
+    // Hittables in leaf order, so a leaf covers a contiguous range.
+    AK::ArenaVector<Hittable const*> m_primitives = {};
+
+    AK::ArenaVector<LeafBlocks> m_leaf_blocks = {};
+    AK::ArenaVector<SphereBlock> m_sphere_blocks = {};
+    AK::ArenaVector<QuadBlock> m_quad_blocks = {};
+    AK::ArenaVector<u32> m_other_primitives = {};
+
+    // Empty unless has_motion().
+    AK::ArenaVector<MotionBounds> m_motion_bounds = {};
+};
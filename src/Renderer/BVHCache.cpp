@@ -0,0 +1,176 @@
+#include "BVHCache.h"
+
+#include "AK/AK.h"
+#include "AK/MappedFile.h"
+#include "BVH.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+struct BVHCacheHeader
+{
+    u32 magic = 0;
+    u32 version = 0;
+    u64 key = 0;
+    u32 node_count = 0;
+    u32 primitive_count = 0;
+};
+
+u64 BVHCache::compute_key(std::vector<std::shared_ptr<Hittable>> const& hittables)
+{
+    u64 hash = AK::HASH_OFFSET_BASIS;
+
+    u32 const layout[] = {version, static_cast<u32>(sizeof(BVHNode)), static_cast<u32>(hittables.size())};
+    AK::hash_bytes(hash, layout, sizeof(layout));
+
+    for (auto const& hittable : hittables)
+    {
+        AABB const bbox = hittable->bounding_box();
+        float const bounds[] = {bbox.x.min, bbox.x.max, bbox.y.min, bbox.y.max, bbox.z.min, bbox.z.max};
+        AK::hash_bytes(hash, bounds, sizeof(bounds));
+    }
+
+    return hash;
+}
+
+std::shared_ptr<BVH> BVHCache::load(std::string const& directory, u64 const key, std::vector<std::shared_ptr<Hittable>> const& hittables,
+                                    AK::Arena* const arena, AK::Arena* const scratch_arena)
+{
+    std::string const path = entry_path(directory, key);
+
+    auto const file = AK::MappedFile::create(path);
+
+    if (file == nullptr || file->size() < sizeof(BVHCacheHeader))
+        return nullptr;
+
+    BVHCacheHeader header = {};
+    std::memcpy(&header, file->data(), sizeof(BVHCacheHeader));
+
+    size_t const nodes_size = static_cast<size_t>(header.node_count) * sizeof(BVHNode);
+    size_t const order_size = static_cast<size_t>(header.primitive_count) * sizeof(u32);
+
+    bool const is_valid = header.magic == magic && header.version == version && header.key == key
+                       && header.primitive_count == hittables.size()
+                       && file->size() == sizeof(BVHCacheHeader) + nodes_size + order_size;
+
+    if (!is_valid)
+    {
+        std::clog << "Ignoring invalid BVH cache entry: " << path << "\n";
+        return nullptr;
+    }
+
+    // The header size keeps both arrays aligned, so they can be used straight from the mapping.
+    static_assert(sizeof(BVHCacheHeader) % alignof(BVHNode) == 0 && sizeof(BVHNode) % alignof(u32) == 0);
+
+    auto const* nodes = reinterpret_cast<BVHNode const*>(file->data() + sizeof(BVHCacheHeader));
+    auto const* primitive_order = reinterpret_cast<u32 const*>(file->data() + sizeof(BVHCacheHeader) + nodes_size);
+
+    // The key only covers the scene, a damaged entry with a matching header must not send traversal out of bounds.
+    // Children also have to come after their parent, refitting relies on that and it rules out cycles.
+    for (u32 i = 0; i < header.node_count; ++i)
+    {
+        BVHNode const& node = nodes[i];
+
+        bool const is_valid_node = node.primitive_count == 0
+                                     ? i + 1 < node.offset && node.offset < header.node_count
+                                     : static_cast<u64>(node.offset) + node.primitive_count <= header.primitive_count;
+
+        if (!is_valid_node)
+        {
+            std::clog << "Ignoring invalid BVH cache entry: " << path << "\n";
+            return nullptr;
+        }
+    }
+
+    for (u32 i = 0; i < header.primitive_count; ++i)
+    {
+        if (primitive_order[i] >= header.primitive_count)
+        {
+            std::clog << "Ignoring invalid BVH cache entry: " << path << "\n";
+            return nullptr;
+        }
+    }
+
+    // Mark the entry as recently used, so it is the last to be removed.
+    std::error_code error = {};
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+
+    return BVH::create(hittables, {nodes, header.node_count}, {primitive_order, header.primitive_count}, file, arena, scratch_arena);
+}
+
+void BVHCache::store(std::string const& directory, u64 const key, BVH const& bvh)
+{
+    std::error_code error = {};
+    std::filesystem::create_directories(directory, error);
+
+    BVHCacheHeader header = {};
+    header.magic = magic;
+    header.version = version;
+    header.key = key;
+    header.node_count = static_cast<u32>(bvh.nodes().size());
+    header.primitive_count = static_cast<u32>(bvh.primitive_order().size());
+
+    // Written under a temporary name and renamed, so a concurrent render never maps a half written entry. The name is
+    // random, --workers processes building the same scene write their entries at the same time.
+    std::string const path = entry_path(directory, key);
+    std::string const temporary_path = path + "." + AK::generate_hex(8) + ".tmp";
+
+    std::ofstream output(temporary_path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        std::clog << "Could not write a BVH cache entry: " << path << "\n";
+        return;
+    }
+
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    output.write(reinterpret_cast<char const*>(bvh.nodes().data()), static_cast<std::streamsize>(bvh.nodes().size_bytes()));
+    output.write(reinterpret_cast<char const*>(bvh.primitive_order().data()),
+                 static_cast<std::streamsize>(bvh.primitive_order().size_bytes()));
+    output.close();
+
+    std::filesystem::rename(temporary_path, path, error);
+
+    if (error)
+    {
+        std::filesystem::remove(temporary_path, error);
+        return;
+    }
+
+    remove_oldest_entries(directory);
+}
+
+std::string BVHCache::entry_path(std::string const& directory, u64 const key)
+{
+    std::ostringstream file_name;
+    file_name << std::hex << std::setw(16) << std::setfill('0') << key << ".bvh";
+
+    return (std::filesystem::path(directory) / file_name.str()).string();
+}
+
+void BVHCache::remove_oldest_entries(std::string const& directory)
+{
+    std::vector<std::filesystem::directory_entry> entries = {};
+    std::error_code error = {};
+
+    for (auto const& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".bvh")
+            entries.emplace_back(entry);
+    }
+
+    if (entries.size() <= max_entries)
+        return;
+
+    std::ranges::sort(entries, [](auto const& a, auto const& b) { return a.last_write_time() > b.last_write_time(); });
+
+    for (size_t i = max_entries; i < entries.size(); ++i)
+    {
+        std::filesystem::remove(entries[i].path(), error);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "AK/Arena.h"
+#include "AK/Types.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class BVH;
+class Hittable;
+
+// On-disk cache of built BVHs. Each entry is a header followed by the raw node array and the primitive order,
+// so loading it is a memory mapping and a few size checks.
+//
+// Entries are keyed by a hash of what the build depends on: the bounding boxes of the hittables in registration order
+// and the layout version. Any change to the geometry produces a different key, so stale entries are never loaded,
+// they are only removed once the cache grows over max_entries.
+class BVHCache
+{
+public:
+    [[nodiscard]] static u64 compute_key(std::vector<std::shared_ptr<Hittable>> const& hittables);
+
+    // Returns nullptr if there is no valid entry for the key. The arenas are used like in BVH::build().
+    [[nodiscard]] static std::shared_ptr<BVH> load(std::string const& directory, u64 const key,
+                                                   std::vector<std::shared_ptr<Hittable>> const& hittables,
+                                                   AK::Arena* const arena = nullptr, AK::Arena* const scratch_arena = nullptr);
+
+    static void store(std::string const& directory, u64 const key, BVH const& bvh);
+
+private:
+    [[nodiscard]] static std::string entry_path(std::string const& directory, u64 const key);
+    static void remove_oldest_entries(std::string const& directory);
+
+    // Bump whenever BVHNode or the build algorithm changes.
+    static u32 constexpr version = 2;
+    static u32 constexpr magic = 0x48564252; // "RBVH"
+
+    static size_t constexpr max_entries = 32;
+};
@@ -0,0 +1,165 @@
+#include "BakedGrid.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+std::shared_ptr<BakedGrid> BakedGrid::create_volume(AABB const& bounds, i32 const resolution, i32 const thread_count,
+                                                    std::function<float(glm::vec3 const&)> const& function)
+{
+    glm::vec3 const size = {bounds.x.size(), bounds.y.size(), bounds.z.size()};
+    float const longest_size = std::max({size.x, size.y, size.z, 0.0001f});
+
+    // At least one cell per axis, so even flat bounds (e.g. a quad) interpolate between two samples.
+    auto const get_cell_counts = [&](float const cells_along_longest_axis) {
+        return glm::max(glm::ivec3(glm::ceil(size / longest_size * cells_along_longest_axis)), glm::ivec3(1, 1, 1));
+    };
+
+    auto const get_sample_count = [](glm::ivec3 const& cell_counts) {
+        return static_cast<size_t>(cell_counts.x + 1) * (cell_counts.y + 1) * (cell_counts.z + 1);
+    };
+
+    float cells_along_longest_axis = static_cast<float>(std::max(resolution, 1));
+    glm::ivec3 cell_counts = get_cell_counts(cells_along_longest_axis);
+
+    while (get_sample_count(cell_counts) > max_sample_count && cells_along_longest_axis > 1.0f)
+    {
+        cells_along_longest_axis = std::max(std::floor(cells_along_longest_axis * 0.9f), 1.0f);
+        cell_counts = get_cell_counts(cells_along_longest_axis);
+    }
+
+    glm::vec3 const cell_size = glm::max(size, glm::vec3(0.0001f, 0.0001f, 0.0001f)) / glm::vec3(cell_counts);
+
+    return std::make_shared<BakedGrid>(AK::Badge<BakedGrid> {}, glm::vec3(bounds.x.min, bounds.y.min, bounds.z.min), cell_size,
+                                       cell_counts + 1, thread_count, function);
+}
+
+std::shared_ptr<BakedGrid> BakedGrid::create_atlas(i32 const resolution, i32 const thread_count,
+                                                   std::function<float(glm::vec2 const&)> const& function)
+{
+    i32 cell_count = std::max(resolution, 1);
+
+    while (static_cast<size_t>(cell_count + 1) * (cell_count + 1) > max_sample_count)
+    {
+        cell_count -= 1;
+    }
+
+    return std::make_shared<BakedGrid>(AK::Badge<BakedGrid> {}, glm::vec3(0.0f), glm::vec3(1.0f / static_cast<float>(cell_count)),
+                                       glm::ivec3(cell_count + 1, cell_count + 1, 1), thread_count,
+                                       [&function](glm::vec3 const& point) { return function(glm::vec2(point.x, point.y)); });
+}
+
+BakedGrid::BakedGrid(AK::Badge<BakedGrid>, glm::vec3 const& origin, glm::vec3 const& cell_size, glm::ivec3 const& sample_counts,
+                     i32 const thread_count, std::function<float(glm::vec3 const&)> const& function)
+    : m_origin(origin), m_inverse_cell_size(1.0f / cell_size), m_sample_counts(sample_counts)
+{
+    m_values.resize(static_cast<size_t>(m_sample_counts.x) * m_sample_counts.y * m_sample_counts.z);
+
+    // Slices are handed out to the threads one by one, like scanlines when rendering. An atlas has a single Z slice,
+    // so it is split along Y instead.
+    bool const is_flat = m_sample_counts.z == 1;
+    i32 const slice_count = is_flat ? m_sample_counts.y : m_sample_counts.z;
+    std::atomic<i32> next_slice = 0;
+
+    auto const bake_slice = [&](i32 const y, i32 const z) {
+        for (i32 x = 0; x < m_sample_counts.x; ++x)
+        {
+            m_values[(static_cast<size_t>(z) * m_sample_counts.y + y) * m_sample_counts.x + x] =
+                function(m_origin + glm::vec3(x, y, z) * cell_size);
+        }
+    };
+
+    auto const bake_slices = [&] {
+        for (i32 slice = next_slice.fetch_add(1); slice < slice_count; slice = next_slice.fetch_add(1))
+        {
+            if (is_flat)
+            {
+                bake_slice(slice, 0);
+                continue;
+            }
+
+            for (i32 y = 0; y < m_sample_counts.y; ++y)
+            {
+                bake_slice(y, slice);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(std::max(thread_count - 1, 0));
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(bake_slices);
+    }
+
+    bake_slices();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+float BakedGrid::sample(glm::vec3 const& point) const
+{
+    glm::vec3 const grid_point = glm::clamp((point - m_origin) * m_inverse_cell_size, glm::vec3(0.0f), glm::vec3(m_sample_counts - 1));
+
+    // The far neighbours are clamped as well, so points on the last grid point (and flat grids) stay inside.
+    glm::ivec3 const cell = glm::ivec3(grid_point);
+    glm::ivec3 const next = glm::min(cell + 1, m_sample_counts - 1);
+    glm::vec3 const t = grid_point - glm::vec3(cell);
+
+    float const c00 = glm::mix(at(cell.x, cell.y, cell.z), at(next.x, cell.y, cell.z), t.x);
+    float const c10 = glm::mix(at(cell.x, next.y, cell.z), at(next.x, next.y, cell.z), t.x);
+    float const c01 = glm::mix(at(cell.x, cell.y, next.z), at(next.x, cell.y, next.z), t.x);
+    float const c11 = glm::mix(at(cell.x, next.y, next.z), at(next.x, next.y, next.z), t.x);
+
+    return glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+}
+
+float BakedGrid::sample_uv(float const u, float const v) const
+{
+    return sample(glm::vec3(u, v, 0.0f));
+}
+
+float BakedGrid::max_value(AABB const& bounds) const
+{
+    glm::vec3 const grid_min = (glm::vec3(bounds.x.min, bounds.y.min, bounds.z.min) - m_origin) * m_inverse_cell_size;
+    glm::vec3 const grid_max = (glm::vec3(bounds.x.max, bounds.y.max, bounds.z.max) - m_origin) * m_inverse_cell_size;
+
+    glm::ivec3 const first = glm::clamp(glm::ivec3(glm::floor(grid_min)), glm::ivec3(0), m_sample_counts - 1);
+    glm::ivec3 const last = glm::clamp(glm::ivec3(glm::ceil(grid_max)), glm::ivec3(0), m_sample_counts - 1);
+
+    float result = 0.0f;
+
+    for (i32 z = first.z; z <= last.z; ++z)
+    {
+        for (i32 y = first.y; y <= last.y; ++y)
+        {
+            for (i32 x = first.x; x <= last.x; ++x)
+            {
+                result = std::max(result, at(x, y, z));
+            }
+        }
+    }
+
+    return result;
+}
+
+glm::ivec3 BakedGrid::sample_counts() const
+{
+    return m_sample_counts;
+}
+
+size_t BakedGrid::memory_size() const
+{
+    return m_values.size() * sizeof(float);
+}
+
+float BakedGrid::at(i32 const x, i32 const y, i32 const z) const
+{
+    return m_values[(static_cast<size_t>(z) * m_sample_counts.y + y) * m_sample_counts.x + x];
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "AK/AABB.h"
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Scalar field sampled at the corners of a regular grid and reconstructed with trilinear interpolation.
+// Used to replace expensive procedural functions with a few memory reads when shading.
+class BakedGrid
+{
+public:
+    // Grids are made coarser until they fit, 64 MB of floats.
+    static size_t constexpr max_sample_count = 1 << 24;
+
+    // Grid over a bounding box. Resolution is the number of cells along the longest axis, the other axes get cells
+    // of the same size. Points outside of the bounds are clamped to the closest grid point.
+    [[nodiscard]] static std::shared_ptr<BakedGrid> create_volume(AABB const& bounds, i32 const resolution, i32 const thread_count,
+                                                                  std::function<float(glm::vec3 const&)> const& function);
+
+    // Flat grid over the [0, 1] UV square with resolution cells along each axis, sampled with sample_uv().
+    [[nodiscard]] static std::shared_ptr<BakedGrid> create_atlas(i32 const resolution, i32 const thread_count,
+                                                                 std::function<float(glm::vec2 const&)> const& function);
+
+    // Evaluates the function at every grid point, spread over the given number of threads.
+    BakedGrid(AK::Badge<BakedGrid>, glm::vec3 const& origin, glm::vec3 const& cell_size, glm::ivec3 const& sample_counts,
+              i32 const thread_count, std::function<float(glm::vec3 const&)> const& function);
+
+    [[nodiscard]] float sample(glm::vec3 const& point) const;
+    [[nodiscard]] float sample_uv(float const u, float const v) const;
+
+    // Upper bound of sample() inside the bounds: the largest grid value any lookup in them interpolates.
+    [[nodiscard]] float max_value(AABB const& bounds) const;
+
+    [[nodiscard]] glm::ivec3 sample_counts() const;
+    [[nodiscard]] size_t memory_size() const;
+
+private:
+    [[nodiscard]] float at(i32 const x, i32 const y, i32 const z) const;
+
+    glm::vec3 m_origin = {};
+    glm::vec3 m_inverse_cell_size = {};
+    glm::ivec3 m_sample_counts = {};
+    std::vector<float> m_values = {};
+};
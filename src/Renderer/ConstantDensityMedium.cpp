@@ -2,38 +2,68 @@
 
 #include "AK/AK.h"
 #include "AK/Math.h"
-#include "Raytracer.h"
+#include "RaytracerStatistics.h"
 
 ConstantDensityMedium::ConstantDensityMedium(std::vector<std::shared_ptr<Hittable>> const& boundary, float const density,
-                                             std::shared_ptr<Material> const& material, bool const disable_boundary_hits)
-    : Hittable(material), m_disable_boundary_hits(disable_boundary_hits), m_negative_inverse_density(-1.0f / density)
+                                             std::shared_ptr<MaterialCPU> const& material)
+    : Hittable(material), m_boundary(boundary), m_negative_inverse_density(-1.0f / density)
 {
-    for (auto const& hittable : boundary)
+    m_bbox = AABB::empty;
+
+    for (auto const& hittable : m_boundary)
     {
-        m_boundary.emplace_back(hittable);
+        m_bbox = AABB(m_bbox, hittable->bounding_box());
     }
 }
 
-void ConstantDensityMedium::initialize()
+bool ConstantDensityMedium::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
 {
-    Hittable::initialize();
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::ConstantDensityMedium);
 
-    for (auto const& hittable : m_boundary)
-    {
-        if (m_disable_boundary_hits)
-        {
-            Raytracer::get_instance()->unregister_hittable(hittable.lock());
-        }
+    // Shadow rays take the transmittance() of the whole path through the medium instead of a collision.
+    if (ray.is_shadow())
+        return false;
 
-        m_bbox = AABB(m_bbox, hittable.lock()->bounding_box());
+    float t_enter = 0.0f;
+    float t_exit = 0.0f;
+
+    if (!clip(ray, ray_t, t_enter, t_exit))
+        return false;
+
+    float const ray_length = glm::length(ray.direction());
+    float const distance_inside_boundary = (t_exit - t_enter) * ray_length;
+    float const hit_distance = m_negative_inverse_density * std::log(AK::random_float_fast());
+
+    if (hit_distance > distance_inside_boundary)
+    {
+        return false;
     }
+
+    hit_record.t = t_enter + hit_distance / ray_length;
+    hit_record.point = ray.at(hit_record.t);
+    hit_record.normal = glm::vec3(1.0f, 0.0f, 0.0f); // Arbitrary
+    hit_record.front_face = true; // Arbitrary
+    hit_record.uv_footprint = 0.0f;
+    hit_record.material = material;
+
+    return true;
 }
 
-void ConstantDensityMedium::draw() const
+float ConstantDensityMedium::transmittance(Ray const& ray, Interval const ray_t) const
 {
+    float t_enter = 0.0f;
+    float t_exit = 0.0f;
+
+    if (!clip(ray, ray_t, t_enter, t_exit))
+        return 1.0f;
+
+    // Beer-Lambert, exact for a constant density.
+    float const distance_inside_boundary = (t_exit - t_enter) * glm::length(ray.direction());
+
+    return std::exp(distance_inside_boundary / m_negative_inverse_density);
 }
 
-bool ConstantDensityMedium::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+bool ConstantDensityMedium::clip(Ray const& ray, Interval const ray_t, float& t_enter, float& t_exit) const
 {
     HitRecord record1;
     HitRecord record2;
@@ -68,20 +98,18 @@ bool ConstantDensityMedium::hit(Ray const& ray, Interval const ray_t, HitRecord&
         record1.t = 0.0f;
     }
 
-    float const ray_length = glm::length(ray.direction());
-    float const distance_inside_boundary = (record2.t - record1.t) * ray_length;
-    float const hit_distance = m_negative_inverse_density * std::log(AK::random_float_fast());
+    t_enter = record1.t;
+    t_exit = record2.t;
 
-    if (hit_distance > distance_inside_boundary)
-    {
-        return false;
-    }
+    return true;
+}
 
-    hit_record.t = record1.t + hit_distance / ray_length;
-    hit_record.point = ray.at(hit_record.t);
-    hit_record.normal = glm::vec3(1.0f, 0.0f, 0.0f); // Arbitrary
-    hit_record.front_face = true; // Arbitrary
-    hit_record.material = material;
+std::vector<std::shared_ptr<Hittable>> const& ConstantDensityMedium::boundary() const
+{
+    return m_boundary;
+}
 
-    return true;
+float ConstantDensityMedium::density() const
+{
+    return -1.0f / m_negative_inverse_density;
 }
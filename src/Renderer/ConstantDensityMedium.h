@@ -5,17 +5,21 @@
 class ConstantDensityMedium final : public Hittable
 {
 public:
+    // The boundary hittables are only used to find where rays enter and leave the medium. Register them with
+    // the raytracer as well if the boundary itself should be visible (e.g. a glass sphere filled with smoke).
     ConstantDensityMedium(std::vector<std::shared_ptr<Hittable>> const& boundary, float const density,
-                          std::shared_ptr<Material> const& material, bool const disable_boundary_hits = true);
-
-    virtual void initialize() override;
-
-    virtual void draw() const override;
+                          std::shared_ptr<MaterialCPU> const& material);
 
     virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual float transmittance(Ray const& ray, Interval const ray_t) const override;
+
+    [[nodiscard]] std::vector<std::shared_ptr<Hittable>> const& boundary() const;
+    [[nodiscard]] float density() const;
 
 private:
-    bool m_disable_boundary_hits = true;
-    std::vector<std::weak_ptr<Hittable>> m_boundary;
+    // Ray parameters where the ray enters and leaves the boundary, clipped to ray_t.
+    [[nodiscard]] bool clip(Ray const& ray, Interval const ray_t, float& t_enter, float& t_exit) const;
+
+    std::vector<std::shared_ptr<Hittable>> m_boundary = {};
     float m_negative_inverse_density = 0.0f;
 };
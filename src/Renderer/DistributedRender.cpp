@@ -0,0 +1,458 @@
+#include "DistributedRender.h"
+
+#include "Framebuffer.h"
+#include "Raytracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct WorkerHello
+{
+    u32 magic = 0;
+    u32 version = 0;
+    u64 scene_hash = 0;
+    i32 width = 0;
+    i32 height = 0;
+    u32 enabled_aovs = 0;
+};
+
+struct ShardRequest
+{
+    i32 first_row = 0;
+    i32 row_count = 0;
+};
+
+struct ShardResult
+{
+    i32 first_row = 0;
+    i32 row_count = 0;
+    u64 size = 0;
+};
+
+static u32 constexpr protocol_magic = 0x57445452; // "RTDW"
+static u32 constexpr protocol_version = 2;
+
+#ifdef _WIN32
+
+bool DistributedRender::coordinate(Raytracer&, std::vector<std::string> const&, i32 const)
+{
+    std::cout << "Distributed rendering needs POSIX processes and pipes, it is not supported on this platform.\n";
+    return false;
+}
+
+bool DistributedRender::serve(Raytracer&)
+{
+    std::cout << "Distributed rendering needs POSIX processes and pipes, it is not supported on this platform.\n";
+    return false;
+}
+
+#else
+
+struct WorkerProcess
+{
+    pid_t pid = -1;
+
+    // Requests go to the stdin of the worker, results come from its stdout.
+    i32 input = -1;
+    i32 output = -1;
+
+    bool is_ready = false;
+
+    // Index of the shard being rendered, -1 if the worker is idle.
+    i32 shard = -1;
+};
+
+static bool write_all(i32 const fd, void const* data, size_t const size)
+{
+    auto const* bytes = static_cast<u8 const*>(data);
+    size_t written = 0;
+
+    while (written < size)
+    {
+        ssize_t const result = ::write(fd, bytes + written, size - written);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result <= 0)
+            return false;
+
+        written += static_cast<size_t>(result);
+    }
+
+    return true;
+}
+
+// Returns false on errors and when the other side closed the pipe before sending everything.
+static bool read_all(i32 const fd, void* data, size_t const size)
+{
+    auto* bytes = static_cast<u8*>(data);
+    size_t received = 0;
+
+    while (received < size)
+    {
+        ssize_t const result = ::read(fd, bytes + received, size - received);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result <= 0)
+            return false;
+
+        received += static_cast<size_t>(result);
+    }
+
+    return true;
+}
+
+static bool spawn_worker(std::vector<std::string> const& command, WorkerProcess& worker)
+{
+    i32 to_worker[2] = {-1, -1};
+    i32 from_worker[2] = {-1, -1};
+
+    if (pipe(to_worker) != 0)
+        return false;
+
+    if (pipe(from_worker) != 0)
+    {
+        close(to_worker[0]);
+        close(to_worker[1]);
+        return false;
+    }
+
+    // The ends kept by the coordinator must not leak into later workers, or a dead worker would never be seen as closed.
+    fcntl(to_worker[1], F_SETFD, FD_CLOEXEC);
+    fcntl(from_worker[0], F_SETFD, FD_CLOEXEC);
+
+    pid_t const pid = fork();
+
+    if (pid == 0)
+    {
+        dup2(to_worker[0], STDIN_FILENO);
+        dup2(from_worker[1], STDOUT_FILENO);
+        close(to_worker[0]);
+        close(from_worker[1]);
+
+        std::vector<char*> arguments = {};
+
+        for (auto const& argument : command)
+        {
+            arguments.emplace_back(const_cast<char*>(argument.c_str()));
+        }
+
+        arguments.emplace_back(nullptr);
+
+        execvp(arguments[0], arguments.data());
+        _exit(127);
+    }
+
+    close(to_worker[0]);
+    close(from_worker[1]);
+
+    if (pid < 0)
+    {
+        close(to_worker[1]);
+        close(from_worker[0]);
+        return false;
+    }
+
+    worker = {};
+    worker.pid = pid;
+    worker.input = to_worker[1];
+    worker.output = from_worker[0];
+
+    return true;
+}
+
+static void stop_worker(WorkerProcess& worker, bool const is_failed)
+{
+    if (worker.pid < 0)
+        return;
+
+    close(worker.input);
+    close(worker.output);
+
+    // A healthy worker exits once it sees its stdin closed.
+    if (is_failed)
+        kill(worker.pid, SIGKILL);
+
+    waitpid(worker.pid, nullptr, 0);
+
+    worker = {};
+}
+
+bool DistributedRender::coordinate(Raytracer& raytracer, std::vector<std::string> const& worker_command, i32 const worker_count)
+{
+    // Writing to a worker that just died has to fail with an error, not end the coordinator.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    raytracer.reset_framebuffer();
+    Framebuffer& framebuffer = *raytracer.get_framebuffer();
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    u64 const scene_hash = raytracer.compute_scene_hash();
+    i32 const height = framebuffer.height();
+    i32 const shard_count = (height + rows_per_shard - 1) / rows_per_shard;
+
+    std::deque<i32> pending_shards = {};
+
+    for (i32 shard = 0; shard < shard_count; ++shard)
+    {
+        pending_shards.emplace_back(shard);
+    }
+
+    std::vector<WorkerProcess> workers(worker_count);
+    i32 restarts_left = worker_count;
+
+    for (auto& worker : workers)
+    {
+        if (!spawn_worker(worker_command, worker))
+            std::clog << "Could not start a render worker.\n";
+    }
+
+    auto const fail_worker = [&](WorkerProcess& worker, char const* reason) {
+        std::clog << "Render worker " << worker.pid << " " << reason;
+
+        if (worker.shard >= 0)
+        {
+            std::clog << ", handing out its rows again";
+            pending_shards.emplace_front(worker.shard);
+        }
+
+        std::clog << ".\n";
+        stop_worker(worker, true);
+
+        if (restarts_left > 0 && spawn_worker(worker_command, worker))
+            restarts_left -= 1;
+    };
+
+    i32 finished_shards = 0;
+    std::vector<char> payload = {};
+
+    while (finished_shards < shard_count)
+    {
+        for (auto& worker : workers)
+        {
+            if (worker.pid < 0 || !worker.is_ready || worker.shard >= 0 || pending_shards.empty())
+                continue;
+
+            i32 const shard = pending_shards.front();
+            pending_shards.pop_front();
+
+            ShardRequest request = {};
+            request.first_row = shard * rows_per_shard;
+            request.row_count = std::min(rows_per_shard, height - request.first_row);
+
+            worker.shard = shard;
+
+            if (!write_all(worker.input, &request, sizeof(request)))
+                fail_worker(worker, "stopped accepting work");
+        }
+
+        std::vector<pollfd> poll_fds = {};
+        std::vector<WorkerProcess*> polled_workers = {};
+
+        for (auto& worker : workers)
+        {
+            if (worker.pid < 0)
+                continue;
+
+            poll_fds.emplace_back(pollfd {worker.output, POLLIN, 0});
+            polled_workers.emplace_back(&worker);
+        }
+
+        if (poll_fds.empty())
+            break;
+
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        for (size_t i = 0; i < poll_fds.size(); ++i)
+        {
+            if (poll_fds[i].revents == 0)
+                continue;
+
+            WorkerProcess& worker = *polled_workers[i];
+
+            if (!worker.is_ready)
+            {
+                WorkerHello hello = {};
+
+                if (!read_all(worker.output, &hello, sizeof(hello)))
+                {
+                    fail_worker(worker, "exited before the handshake");
+                    continue;
+                }
+
+                bool const is_valid = hello.magic == protocol_magic && hello.version == protocol_version
+                                   && hello.scene_hash == scene_hash && hello.width == framebuffer.width() && hello.height == height
+                                   && hello.enabled_aovs == framebuffer.enabled_aovs();
+
+                // Another start would load the same mismatching scene, so the worker is not replaced.
+                if (!is_valid)
+                {
+                    std::clog << "Render worker " << worker.pid << " loaded a different scene or settings, stopping it.\n";
+                    stop_worker(worker, true);
+                    continue;
+                }
+
+                worker.is_ready = true;
+                continue;
+            }
+
+            ShardResult result = {};
+
+            if (!read_all(worker.output, &result, sizeof(result)))
+            {
+                fail_worker(worker, "exited");
+                continue;
+            }
+
+            // The size is checked before anything is allocated for it, a worker that died mid-write can send any value.
+            bool const is_expected = worker.shard >= 0 && result.first_row == worker.shard * rows_per_shard
+                                  && result.row_count == std::min(rows_per_shard, height - result.first_row)
+                                  && result.size == static_cast<u64>(result.row_count) * framebuffer.row_byte_size();
+
+            if (!is_expected)
+            {
+                fail_worker(worker, "sent a broken shard");
+                continue;
+            }
+
+            payload.resize(result.size);
+
+            if (!read_all(worker.output, payload.data(), payload.size()))
+            {
+                fail_worker(worker, "sent a broken shard");
+                continue;
+            }
+
+            std::istringstream rows(std::string(payload.data(), payload.size()));
+            bool is_complete = true;
+
+            for (i32 row = result.first_row; row < result.first_row + result.row_count; ++row)
+            {
+                is_complete = is_complete && framebuffer.read_row(rows, row);
+            }
+
+            if (!is_complete)
+            {
+                fail_worker(worker, "sent a broken shard");
+                continue;
+            }
+
+            std::clog << "Shards: " << (finished_shards + 1) << "/" << shard_count << '\n';
+
+            worker.shard = -1;
+            finished_shards += 1;
+        }
+    }
+
+    if (finished_shards < shard_count)
+    {
+        std::clog << "No render workers left, rendering the remaining rows locally.\n";
+
+        for (auto const& worker : workers)
+        {
+            if (worker.shard >= 0)
+                pending_shards.emplace_back(worker.shard);
+        }
+
+        for (i32 const shard : pending_shards)
+        {
+            for (i32 row = shard * rows_per_shard; row < std::min((shard + 1) * rows_per_shard, height); ++row)
+            {
+                raytracer.render_row(row);
+            }
+        }
+    }
+
+    for (auto& worker : workers)
+    {
+        stop_worker(worker, false);
+    }
+
+    std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time;
+
+    raytracer.save_framebuffer();
+
+    std::clog << "\rDone.                 \n";
+    std::clog << "Render time: " << render_time.count() << " s (" << worker_count << " worker processes)\n";
+
+    return true;
+}
+
+bool DistributedRender::serve(Raytracer& raytracer)
+{
+    // Stdout carries the results. Anything else printed from now on goes to stderr, so it cannot corrupt them.
+    std::cout.flush();
+    std::fflush(stdout);
+
+    i32 const output = dup(STDOUT_FILENO);
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    raytracer.reset_framebuffer();
+    Framebuffer const& framebuffer = *raytracer.get_framebuffer();
+
+    WorkerHello hello = {};
+    hello.magic = protocol_magic;
+    hello.version = protocol_version;
+    hello.scene_hash = raytracer.compute_scene_hash();
+    hello.width = framebuffer.width();
+    hello.height = framebuffer.height();
+    hello.enabled_aovs = framebuffer.enabled_aovs();
+
+    if (!write_all(output, &hello, sizeof(hello)))
+        return false;
+
+    ShardRequest request = {};
+
+    while (read_all(STDIN_FILENO, &request, sizeof(request)))
+    {
+        if (request.first_row < 0 || request.row_count < 0 || request.first_row + request.row_count > framebuffer.height())
+            return false;
+
+        std::ostringstream rows = {};
+
+        for (i32 row = request.first_row; row < request.first_row + request.row_count; ++row)
+        {
+            raytracer.render_row(row);
+            framebuffer.write_row(rows, row);
+        }
+
+        std::string const payload = rows.str();
+
+        ShardResult result = {};
+        result.first_row = request.first_row;
+        result.row_count = request.row_count;
+        result.size = payload.size();
+
+        if (!write_all(output, &result, sizeof(result)) || !write_all(output, payload.data(), payload.size()))
+            return false;
+    }
+
+    close(output);
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "AK/Types.h"
+
+#include <string>
+#include <vector>
+
+class Raytracer;
+
+// Splits a render across worker processes. The coordinator starts the workers with the given command line, hands them
+// shards of consecutive rows and stores the raw sums and sample counts they send back in its own framebuffer.
+// Every worker loads the scene on its own and rows are seeded by their index, so the merged image is the same
+// as a render in a single process.
+//
+// A worker that exits or breaks the protocol is replaced and its shard is handed out again. A worker that loaded
+// a different scene (e.g. one built from random numbers) is rejected by the scene hash of its handshake. If no worker
+// is left, the coordinator renders the remaining rows itself.
+//
+// Workers only talk through stdin and stdout, the command line decides where they run.
+class DistributedRender
+{
+public:
+    // Coordinator side of Raytracer::render(), Raytracer::initialize() has to be called first.
+    // Returns false if the platform has no support for worker processes.
+    static bool coordinate(Raytracer& raytracer, std::vector<std::string> const& worker_command, i32 const worker_count);
+
+    // Worker side, renders shards until the coordinator closes stdin. Raytracer::initialize() has to be called first.
+    static bool serve(Raytracer& raytracer);
+
+    // Small enough to balance the load between workers, large enough to keep the messages few.
+    static i32 constexpr rows_per_shard = 4;
+};
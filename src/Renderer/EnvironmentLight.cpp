@@ -0,0 +1,158 @@
+#include "EnvironmentLight.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "Image.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+std::shared_ptr<EnvironmentLight> EnvironmentLight::create(std::string const& path, float const intensity, float const rotation)
+{
+    auto const image = Image::create(path);
+
+    if (image->width() <= 0 || image->height() <= 0)
+        return nullptr;
+
+    return std::make_shared<EnvironmentLight>(AK::Badge<EnvironmentLight> {}, image, intensity, rotation);
+}
+
+EnvironmentLight::EnvironmentLight(AK::Badge<EnvironmentLight>, std::shared_ptr<Image> const& image, float const intensity,
+                                   float const rotation)
+    : m_image(image), m_intensity(intensity), m_rotation(rotation)
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    i32 level = 0;
+
+    while (level + 1 < m_image->mip_level_count() && m_image->level_size(level).x > max_table_width)
+    {
+        level += 1;
+    }
+
+    m_table_size = m_image->level_size(level);
+
+    std::vector<float> weights(static_cast<size_t>(m_table_size.x) * m_table_size.y);
+    double total_luminance = 0.0;
+
+    for (i32 y = 0; y < m_table_size.y; ++y)
+    {
+        for (i32 x = 0; x < m_table_size.x; ++x)
+        {
+            glm::vec3 const color = m_image->texel(level, x, y);
+            float const luminance = glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+
+            weights[static_cast<size_t>(y) * m_table_size.x + x] = std::max(luminance, 0.0f);
+            total_luminance += std::max(luminance, 0.0f);
+        }
+    }
+
+    // A small share of the average keeps dark texels pickable, the bilinear lookups of the full image can bleed
+    // light into texels that are black in the mip level.
+    float const floor = 0.01f * static_cast<float>(total_luminance / static_cast<double>(weights.size()));
+
+    for (i32 y = 0; y < m_table_size.y; ++y)
+    {
+        // Rows near the poles cover less of the sphere.
+        float const sin_theta = glm::sin(AK::PI_F * (static_cast<float>(y) + 0.5f) / static_cast<float>(m_table_size.y));
+
+        for (i32 x = 0; x < m_table_size.x; ++x)
+        {
+            float& weight = weights[static_cast<size_t>(y) * m_table_size.x + x];
+            weight = (weight + floor) * sin_theta;
+        }
+    }
+
+    m_table = AK::AliasTable(weights);
+
+    std::chrono::duration<double> const build_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Environment table build time: " << build_time.count() << " s (" << m_table_size.x << "x" << m_table_size.y
+              << " texels of " << m_image->path() << ")\n";
+}
+
+glm::vec3 EnvironmentLight::radiance(glm::vec3 const& direction) const
+{
+    glm::vec2 const uv = direction_to_uv(glm::normalize(direction));
+
+    return m_intensity * m_image->sample(uv.x, uv.y, 0.0f);
+}
+
+float EnvironmentLight::sample(glm::vec3& direction) const
+{
+    u32 const index = m_table.sample(AK::random_float_fast());
+    i32 const x = static_cast<i32>(index % static_cast<u32>(m_table_size.x));
+    i32 const y = static_cast<i32>(index / static_cast<u32>(m_table_size.x));
+
+    // Uniform within the texel.
+    glm::vec2 const uv = {(static_cast<float>(x) + AK::random_float_fast()) / static_cast<float>(m_table_size.x),
+                          (static_cast<float>(y) + AK::random_float_fast()) / static_cast<float>(m_table_size.y)};
+
+    direction = uv_to_direction(uv);
+
+    float const sin_theta = glm::sin(AK::PI_F * uv.y);
+
+    if (sin_theta <= 0.0f)
+        return 0.0f;
+
+    // Density over the image is the probability of the texel times the texel count, the image spans
+    // 2 pi by pi radians and a row covers sin(theta) of the solid angle of a row at the equator.
+    float const texel_count = static_cast<float>(m_table_size.x) * static_cast<float>(m_table_size.y);
+    return m_table.probability(index) * texel_count / (2.0f * AK::PI_F * AK::PI_F * sin_theta);
+}
+
+float EnvironmentLight::pdf(glm::vec3 const& direction) const
+{
+    glm::vec2 const uv = direction_to_uv(glm::normalize(direction));
+    float const sin_theta = glm::sin(AK::PI_F * uv.y);
+
+    if (sin_theta <= 0.0f)
+        return 0.0f;
+
+    i32 const x = glm::clamp(static_cast<i32>(uv.x * static_cast<float>(m_table_size.x)), 0, m_table_size.x - 1);
+    i32 const y = glm::clamp(static_cast<i32>(uv.y * static_cast<float>(m_table_size.y)), 0, m_table_size.y - 1);
+    u32 const index = static_cast<u32>(y) * static_cast<u32>(m_table_size.x) + static_cast<u32>(x);
+
+    float const texel_count = static_cast<float>(m_table_size.x) * static_cast<float>(m_table_size.y);
+    return m_table.probability(index) * texel_count / (2.0f * AK::PI_F * AK::PI_F * sin_theta);
+}
+
+std::shared_ptr<Image> const& EnvironmentLight::image() const
+{
+    return m_image;
+}
+
+float EnvironmentLight::intensity() const
+{
+    return m_intensity;
+}
+
+float EnvironmentLight::rotation() const
+{
+    return m_rotation;
+}
+
+glm::vec2 EnvironmentLight::direction_to_uv(glm::vec3 const& direction) const
+{
+    float const theta = std::acos(glm::clamp(direction.y, -1.0f, 1.0f));
+    float const phi = std::atan2(-direction.x, direction.z) - glm::radians(m_rotation);
+
+    float u = phi / (2.0f * AK::PI_F);
+    u -= std::floor(u);
+
+    return {u, theta / AK::PI_F};
+}
+
+glm::vec3 EnvironmentLight::uv_to_direction(glm::vec2 const& uv) const
+{
+    float const theta = AK::PI_F * uv.y;
+    float const phi = 2.0f * AK::PI_F * uv.x + glm::radians(m_rotation);
+    float const sin_theta = glm::sin(theta);
+
+    return {-sin_theta * glm::sin(phi), glm::cos(theta), sin_theta * glm::cos(phi)};
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "AK/AliasTable.h"
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <string>
+
+class Image;
+
+// Light arriving from infinitely far away, read from an equirectangular image, usually an HDR file. U runs around
+// the Y axis with the middle of the image towards -Z, V runs from +Y at the top row down to -Y.
+//
+// The path tracer samples it explicitly at diffuse hits. Directions are picked with an alias table over the texels,
+// weighted by their brightness and by the solid angle they cover, so the few texels of the sun get most of the rays.
+// The table is built from a mip level of at most max_table_width texels across, that is plenty to find the bright
+// areas and keeps it small for 8K images.
+class EnvironmentLight
+{
+public:
+    // Nullptr if the image cannot be loaded. Rotation turns the image around the Y axis, in degrees.
+    static std::shared_ptr<EnvironmentLight> create(std::string const& path, float const intensity = 1.0f, float const rotation = 0.0f);
+
+    explicit EnvironmentLight(AK::Badge<EnvironmentLight>, std::shared_ptr<Image> const& image, float const intensity,
+                              float const rotation);
+
+    // Radiance arriving along the direction, which does not have to be normalized.
+    [[nodiscard]] glm::vec3 radiance(glm::vec3 const& direction) const;
+
+    // Picks a normalized direction towards the light, returns its probability density per solid angle.
+    [[nodiscard]] float sample(glm::vec3& direction) const;
+
+    // Probability density per solid angle of sample() picking the direction.
+    [[nodiscard]] float pdf(glm::vec3 const& direction) const;
+
+    [[nodiscard]] std::shared_ptr<Image> const& image() const;
+    [[nodiscard]] float intensity() const;
+    [[nodiscard]] float rotation() const;
+
+    static i32 constexpr max_table_width = 1024;
+
+private:
+    [[nodiscard]] glm::vec2 direction_to_uv(glm::vec3 const& direction) const;
+    [[nodiscard]] glm::vec3 uv_to_direction(glm::vec2 const& uv) const;
+
+    std::shared_ptr<Image> m_image = {};
+    float m_intensity = 1.0f;
+    float m_rotation = 0.0f;
+
+    // Over the texels of a mip level of the image, row by row.
+    AK::AliasTable m_table = {};
+    glm::ivec2 m_table_size = {};
+};
@@ -0,0 +1,434 @@
+#include "Framebuffer.h"
+
+#include "AK/AK.h"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+static float luminance(glm::vec3 const& color)
+{
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+std::shared_ptr<Framebuffer> Framebuffer::create(i32 const width, i32 const height, u32 const enabled_aovs)
+{
+    return std::make_shared<Framebuffer>(AK::Badge<Framebuffer> {}, width, height, enabled_aovs);
+}
+
+Framebuffer::Framebuffer(AK::Badge<Framebuffer>, i32 const width, i32 const height, u32 const enabled_aovs)
+    : m_width(width), m_height(height), m_enabled_aovs(enabled_aovs | aov_bit(AOVType::Beauty))
+{
+    size_t const pixel_count = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+
+    m_sample_counts.resize(pixel_count, 0);
+    m_luminance_squares.resize(pixel_count, 0.0f);
+
+    for (u32 i = 0; i < static_cast<u32>(AOVType::Count); ++i)
+    {
+        auto const type = static_cast<AOVType>(i);
+
+        // Sample count lives in m_sample_counts, it does not need its own float planes.
+        if (!is_enabled(type) || type == AOVType::SampleCount)
+            continue;
+
+        Layer& layer = m_layers[i];
+        layer.channel_count = aov_channel_count(type);
+
+        for (u32 channel = 0; channel < layer.channel_count; ++channel)
+        {
+            layer.channels[channel].resize(pixel_count, 0.0f);
+        }
+    }
+}
+
+u32 Framebuffer::aov_bit(AOVType const type)
+{
+    return 1u << static_cast<u32>(type);
+}
+
+std::string Framebuffer::aov_name(AOVType const type)
+{
+    switch (type)
+    {
+    case AOVType::Beauty:
+        return "beauty";
+    case AOVType::Depth:
+        return "depth";
+    case AOVType::Normal:
+        return "normal";
+    case AOVType::Albedo:
+        return "albedo";
+    case AOVType::Direct:
+        return "direct";
+    case AOVType::Indirect:
+        return "indirect";
+    case AOVType::Emission:
+        return "emission";
+    case AOVType::SampleCount:
+        return "sample_count";
+    case AOVType::TraversalCost:
+        return "traversal_cost";
+    default:
+        return "unknown";
+    }
+}
+
+u32 Framebuffer::aov_channel_count(AOVType const type)
+{
+    switch (type)
+    {
+    case AOVType::Depth:
+    case AOVType::SampleCount:
+    case AOVType::TraversalCost:
+        return 1;
+    default:
+        return 3;
+    }
+}
+
+i32 Framebuffer::width() const
+{
+    return m_width;
+}
+
+i32 Framebuffer::height() const
+{
+    return m_height;
+}
+
+bool Framebuffer::is_enabled(AOVType const type) const
+{
+    return (m_enabled_aovs & aov_bit(type)) != 0;
+}
+
+u32 Framebuffer::enabled_aovs() const
+{
+    return m_enabled_aovs;
+}
+
+void Framebuffer::clear()
+{
+    std::ranges::fill(m_sample_counts, 0);
+    std::ranges::fill(m_luminance_squares, 0.0f);
+
+    for (auto& layer : m_layers)
+    {
+        for (auto& channel : layer.channels)
+        {
+            std::ranges::fill(channel, 0.0f);
+        }
+    }
+}
+
+void Framebuffer::accumulate(i32 const index, AOVSample const& sample)
+{
+    m_sample_counts[index] += 1;
+
+    float const sample_luminance = luminance(sample.color);
+    m_luminance_squares[index] += sample_luminance * sample_luminance;
+
+    add(AOVType::Beauty, index, sample.color);
+
+    if (is_enabled(AOVType::Depth))
+        add(AOVType::Depth, index, sample.depth);
+
+    if (is_enabled(AOVType::Normal))
+        add(AOVType::Normal, index, sample.normal);
+
+    if (is_enabled(AOVType::Albedo))
+        add(AOVType::Albedo, index, sample.albedo);
+
+    if (is_enabled(AOVType::Direct))
+        add(AOVType::Direct, index, sample.direct);
+
+    if (is_enabled(AOVType::Indirect))
+        add(AOVType::Indirect, index, sample.indirect);
+
+    if (is_enabled(AOVType::Emission))
+        add(AOVType::Emission, index, sample.emission);
+
+    if (is_enabled(AOVType::TraversalCost))
+        add(AOVType::TraversalCost, index, sample.traversal_cost);
+}
+
+glm::vec3 Framebuffer::resolve(AOVType const type, i32 const index) const
+{
+    u32 const samples = m_sample_counts[index];
+
+    if (type == AOVType::SampleCount)
+    {
+        auto const value = static_cast<float>(samples);
+        return {value, value, value};
+    }
+
+    if (samples == 0 || !is_enabled(type))
+        return {0.0f, 0.0f, 0.0f};
+
+    Layer const& layer = m_layers[static_cast<size_t>(type)];
+    float const scale = 1.0f / static_cast<float>(samples);
+
+    if (layer.channel_count == 1)
+    {
+        float const value = layer.channels[0][index] * scale;
+        return {value, value, value};
+    }
+
+    return glm::vec3(layer.channels[0][index], layer.channels[1][index], layer.channels[2][index]) * scale;
+}
+
+float Framebuffer::estimate_error() const
+{
+    double squared_error_sum = 0.0;
+    double luminance_sum = 0.0;
+    size_t pixel_count = 0;
+
+    for (size_t index = 0; index < m_sample_counts.size(); ++index)
+    {
+        u32 const samples = m_sample_counts[index];
+
+        if (samples < 2)
+            continue;
+
+        auto const count = static_cast<double>(samples);
+        double const mean = luminance(resolve(AOVType::Beauty, static_cast<i32>(index)));
+        double const second_moment = static_cast<double>(m_luminance_squares[index]) / count;
+        double const variance = std::max(0.0, second_moment - mean * mean) * count / (count - 1.0);
+
+        // Squared standard error of the mean of the pixel.
+        squared_error_sum += variance / count;
+        luminance_sum += mean;
+        pixel_count += 1;
+    }
+
+    if (pixel_count == 0)
+        return std::numeric_limits<float>::infinity();
+
+    // Black images are converged.
+    if (luminance_sum <= 0.0)
+        return 0.0f;
+
+    auto const pixels = static_cast<double>(pixel_count);
+
+    return static_cast<float>(std::sqrt(squared_error_sum / pixels) / (luminance_sum / pixels));
+}
+
+u32 Framebuffer::sample_count(i32 const index) const
+{
+    return m_sample_counts[index];
+}
+
+void Framebuffer::clear_pixel(i32 const index)
+{
+    limit_sample_count(index, 0);
+}
+
+void Framebuffer::limit_sample_count(i32 const index, u32 const max_count)
+{
+    u32 const samples = m_sample_counts[index];
+
+    if (samples <= max_count)
+        return;
+
+    float const scale = static_cast<float>(max_count) / static_cast<float>(samples);
+
+    for (auto& layer : m_layers)
+    {
+        for (u32 channel = 0; channel < layer.channel_count; ++channel)
+        {
+            layer.channels[channel][index] *= scale;
+        }
+    }
+
+    m_luminance_squares[index] *= scale;
+    m_sample_counts[index] = max_count;
+}
+
+std::shared_ptr<Framebuffer> Framebuffer::clone() const
+{
+    return std::make_shared<Framebuffer>(*this);
+}
+
+void Framebuffer::write_row(std::ostream& output, i32 const row) const
+{
+    size_t const offset = static_cast<size_t>(row) * m_width;
+    auto const row_size = static_cast<std::streamsize>(m_width * sizeof(float));
+
+    output.write(reinterpret_cast<char const*>(m_sample_counts.data() + offset), static_cast<std::streamsize>(m_width * sizeof(u32)));
+    output.write(reinterpret_cast<char const*>(m_luminance_squares.data() + offset), row_size);
+
+    for (auto const& layer : m_layers)
+    {
+        for (u32 channel = 0; channel < layer.channel_count; ++channel)
+        {
+            output.write(reinterpret_cast<char const*>(layer.channels[channel].data() + offset), row_size);
+        }
+    }
+}
+
+size_t Framebuffer::row_byte_size() const
+{
+    size_t channel_count = 0;
+
+    for (auto const& layer : m_layers)
+    {
+        channel_count += layer.channel_count;
+    }
+
+    // Sample counts and luminance squares come first, then every channel of the layers.
+    return static_cast<size_t>(m_width) * (sizeof(u32) + sizeof(float) + channel_count * sizeof(float));
+}
+
+bool Framebuffer::read_row(std::istream& input, i32 const row)
+{
+    size_t const offset = static_cast<size_t>(row) * m_width;
+    auto const row_size = static_cast<std::streamsize>(m_width * sizeof(float));
+
+    input.read(reinterpret_cast<char*>(m_sample_counts.data() + offset), static_cast<std::streamsize>(m_width * sizeof(u32)));
+    input.read(reinterpret_cast<char*>(m_luminance_squares.data() + offset), row_size);
+
+    for (auto& layer : m_layers)
+    {
+        for (u32 channel = 0; channel < layer.channel_count; ++channel)
+        {
+            input.read(reinterpret_cast<char*>(layer.channels[channel].data() + offset), row_size);
+        }
+    }
+
+    return static_cast<bool>(input);
+}
+
+void Framebuffer::save(std::string const& directory, std::string const& file_name, FramebufferFormat const format) const
+{
+    std::filesystem::path const directory_path = directory;
+
+    if (!std::filesystem::exists(directory_path))
+    {
+        std::filesystem::create_directories(directory_path);
+    }
+
+    std::filesystem::path const file_path = file_name;
+    std::string const stem = file_path.stem().string();
+    std::string const extension = format == FramebufferFormat::PFM ? ".pfm" : ".ppm";
+
+    for (u32 i = 0; i < static_cast<u32>(AOVType::Count); ++i)
+    {
+        auto const type = static_cast<AOVType>(i);
+
+        if (!is_enabled(type))
+            continue;
+
+        std::string const suffix = type == AOVType::Beauty ? "" : "_" + aov_name(type);
+        std::string const path = (directory_path / (stem + suffix + extension)).string();
+
+        if (format == FramebufferFormat::PFM)
+        {
+            write_pfm(path, type);
+        }
+        else
+        {
+            write_ppm(path, type);
+        }
+    }
+}
+
+void Framebuffer::add(AOVType const type, i32 const index, glm::vec3 const& value)
+{
+    Layer& layer = m_layers[static_cast<size_t>(type)];
+    layer.channels[0][index] += value.x;
+    layer.channels[1][index] += value.y;
+    layer.channels[2][index] += value.z;
+}
+
+void Framebuffer::add(AOVType const type, i32 const index, float const value)
+{
+    m_layers[static_cast<size_t>(type)].channels[0][index] += value;
+}
+
+void Framebuffer::write_ppm(std::string const& path, AOVType const type) const
+{
+    // Color layers are gamma corrected like the beauty pass. Data layers are remapped into the displayable range.
+    bool const is_color = type == AOVType::Beauty || type == AOVType::Albedo || type == AOVType::Direct || type == AOVType::Indirect
+                       || type == AOVType::Emission;
+    float const inverse_max = type == AOVType::Depth || type == AOVType::SampleCount || type == AOVType::TraversalCost
+                                ? 1.0f / glm::max(max_value(type), 0.0001f)
+                                : 1.0f;
+
+    std::string buffer = {};
+    buffer.reserve(static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * 12);
+
+    for (i32 index = 0; index < m_width * m_height; ++index)
+    {
+        glm::vec3 value = resolve(type, index);
+        glm::ivec3 color_byte = {};
+
+        if (is_color)
+        {
+            color_byte = AK::color_to_byte(value);
+        }
+        else
+        {
+            if (type == AOVType::Normal)
+            {
+                value = value * 0.5f + 0.5f;
+            }
+            else
+            {
+                value *= inverse_max;
+            }
+
+            color_byte = glm::ivec3(glm::clamp(value, 0.0f, 0.999f) * 256.0f);
+        }
+
+        buffer += std::to_string(color_byte.r) + ' ' + std::to_string(color_byte.g) + ' ' + std::to_string(color_byte.b) + '\n';
+    }
+
+    std::ofstream output(path);
+
+    output << "P3\n" << m_width << ' ' << m_height << "\n255\n";
+    output << buffer;
+
+    output.close();
+}
+
+void Framebuffer::write_pfm(std::string const& path, AOVType const type) const
+{
+    // Portable float map, little endian (negative scale). Rows are stored bottom to top.
+    std::ofstream output(path, std::ios::binary);
+
+    output << "PF\n" << m_width << ' ' << m_height << "\n-1.0\n";
+
+    std::vector<float> row(static_cast<size_t>(m_width) * 3);
+
+    for (i32 y = m_height - 1; y >= 0; --y)
+    {
+        for (i32 x = 0; x < m_width; ++x)
+        {
+            glm::vec3 const value = resolve(type, y * m_width + x);
+            row[x * 3 + 0] = value.x;
+            row[x * 3 + 1] = value.y;
+            row[x * 3 + 2] = value.z;
+        }
+
+        output.write(reinterpret_cast<char const*>(row.data()), static_cast<std::streamsize>(row.size() * sizeof(float)));
+    }
+
+    output.close();
+}
+
+float Framebuffer::max_value(AOVType const type) const
+{
+    float result = 0.0f;
+
+    for (i32 index = 0; index < m_width * m_height; ++index)
+    {
+        result = glm::max(result, resolve(type, index).x);
+    }
+
+    return result;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+enum class AOVType : u8
+{
+    Beauty = 0,
+    Depth,
+    Normal,
+    Albedo,
+    Direct,
+    Indirect,
+    Emission,
+    SampleCount,
+    TraversalCost,
+    Count,
+};
+
+// Everything a single camera sample produces. Filled by the path tracer and accumulated into every enabled layer.
+struct AOVSample
+{
+    glm::vec3 color = {};
+    glm::vec3 emission = {};
+    glm::vec3 direct = {};
+    glm::vec3 indirect = {};
+    glm::vec3 albedo = {};
+    glm::vec3 normal = {};
+    float depth = 0.0f;
+    float traversal_cost = 0.0f;
+};
+
+enum class FramebufferFormat
+{
+    PPM, // 8-bit, gamma corrected for color layers
+    PFM, // 32-bit float, linear
+};
+
+class Framebuffer
+{
+public:
+    static std::shared_ptr<Framebuffer> create(i32 const width, i32 const height, u32 const enabled_aovs);
+
+    explicit Framebuffer(AK::Badge<Framebuffer>, i32 const width, i32 const height, u32 const enabled_aovs);
+
+    [[nodiscard]] static u32 aov_bit(AOVType const type);
+    [[nodiscard]] static std::string aov_name(AOVType const type);
+    [[nodiscard]] static u32 aov_channel_count(AOVType const type);
+
+    [[nodiscard]] i32 width() const;
+    [[nodiscard]] i32 height() const;
+
+    [[nodiscard]] bool is_enabled(AOVType const type) const;
+    [[nodiscard]] u32 enabled_aovs() const;
+
+    void clear();
+
+    // Not thread safe for the same pixel. Different pixels can be accumulated concurrently.
+    void accumulate(i32 const index, AOVSample const& sample);
+
+    // Returns the value of the layer averaged over all samples taken for the pixel.
+    [[nodiscard]] glm::vec3 resolve(AOVType const type, i32 const index) const;
+
+    [[nodiscard]] u32 sample_count(i32 const index) const;
+
+    // Relative RMSE of the beauty layer against the converged image, estimated from the variance of the samples of
+    // every pixel: the root mean square of the standard errors of the pixel luminances over the mean luminance.
+    // Pixels with fewer than 2 samples are left out, infinity if no pixel has enough. Underestimates the error of
+    // pixels whose rare bright samples were not found yet.
+    [[nodiscard]] float estimate_error() const;
+
+    // Temporal reuse of samples between the frames of a RenderSequence. Limiting the sample count keeps the average
+    // of the pixel, the samples added afterwards just weigh more.
+    void clear_pixel(i32 const index);
+    void limit_sample_count(i32 const index, u32 const max_count);
+
+    [[nodiscard]] std::shared_ptr<Framebuffer> clone() const;
+
+    // Raw sums and sample counts of a single row of every enabled layer, for render checkpoints.
+    // Reading fails if the stream ends early, the row is left partially filled then.
+    void write_row(std::ostream& output, i32 const row) const;
+    [[nodiscard]] bool read_row(std::istream& input, i32 const row);
+
+    // Bytes write_row() writes for a single row.
+    [[nodiscard]] size_t row_byte_size() const;
+
+    // Writes every enabled layer. Beauty goes to file_name, other layers get the layer name appended before the extension.
+    void save(std::string const& directory, std::string const& file_name, FramebufferFormat const format) const;
+
+private:
+    // Structure of arrays: one contiguous float plane per channel.
+    struct Layer
+    {
+        u32 channel_count = 0;
+        std::array<std::vector<float>, 3> channels = {};
+    };
+
+    void add(AOVType const type, i32 const index, glm::vec3 const& value);
+    void add(AOVType const type, i32 const index, float const value);
+
+    void write_ppm(std::string const& path, AOVType const type) const;
+    void write_pfm(std::string const& path, AOVType const type) const;
+
+    [[nodiscard]] float max_value(AOVType const type) const;
+
+    i32 m_width = 0;
+    i32 m_height = 0;
+    u32 m_enabled_aovs = 0;
+
+    // Always tracked, needed to resolve the other layers.
+    std::vector<u32> m_sample_counts = {};
+
+    // Sums of the squared luminance of the beauty samples, for estimate_error().
+    std::vector<float> m_luminance_squares = {};
+
+    std::array<Layer, static_cast<size_t>(AOVType::Count)> m_layers = {};
+};
@@ -0,0 +1,304 @@
+#include "HeterogeneousMedium.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "BakedGrid.h"
+#include "RaytracerStatistics.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+MediumBoundary MediumBoundary::sphere(glm::vec3 const& center, float const radius)
+{
+    MediumBoundary boundary = {};
+    boundary.shape = Shape::Sphere;
+    boundary.center = center;
+    boundary.radius = radius;
+    return boundary;
+}
+
+MediumBoundary MediumBoundary::box(glm::vec3 const& min, glm::vec3 const& max)
+{
+    MediumBoundary boundary = {};
+    boundary.shape = Shape::Box;
+    boundary.min = glm::min(min, max);
+    boundary.max = glm::max(min, max);
+    return boundary;
+}
+
+bool MediumBoundary::intersect(Ray const& ray, float& t_enter, float& t_exit) const
+{
+    if (shape == Shape::Sphere)
+    {
+        glm::vec3 const origin_center = center - ray.origin();
+        float const a = glm::dot(ray.direction(), ray.direction());
+        float const h = glm::dot(ray.direction(), origin_center);
+        float const c = glm::dot(origin_center, origin_center) - radius * radius;
+
+        float const discriminant = h * h - a * c;
+
+        if (discriminant < 0.0f)
+            return false;
+
+        float const sqrt_discriminant = glm::sqrt(discriminant);
+        t_enter = (h - sqrt_discriminant) / a;
+        t_exit = (h + sqrt_discriminant) / a;
+
+        return true;
+    }
+
+    // Slab test, the same as AABB::hit() but keeping both ends of the interval.
+    t_enter = -AK::INFINITY_F;
+    t_exit = AK::INFINITY_F;
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        float const inverse_direction = 1.0f / ray.direction()[axis];
+        float const t0 = (min[axis] - ray.origin()[axis]) * inverse_direction;
+        float const t1 = (max[axis] - ray.origin()[axis]) * inverse_direction;
+
+        t_enter = std::max(t_enter, std::min(t0, t1));
+        t_exit = std::min(t_exit, std::max(t0, t1));
+    }
+
+    return t_enter <= t_exit;
+}
+
+AABB MediumBoundary::bounding_box() const
+{
+    if (shape == Shape::Sphere)
+    {
+        glm::vec3 const radius_vector = glm::vec3(radius, radius, radius);
+        return {center - radius_vector, center + radius_vector};
+    }
+
+    return {min, max};
+}
+
+HeterogeneousMedium::HeterogeneousMedium(MediumBoundary const& boundary, float const max_density, float const noise_scale, u32 const seed,
+                                         i32 const resolution, std::shared_ptr<MaterialCPU> const& material)
+    : Hittable(material), m_boundary(boundary), m_max_density(max_density), m_noise_scale(noise_scale), m_seed(seed),
+      m_resolution(resolution), m_noise(seed)
+{
+    m_bbox = m_boundary.bounding_box();
+
+    auto const density_function = [this](glm::vec3 const& point) {
+        return m_max_density * glm::clamp(0.5f + 0.5f * m_noise.noise(m_noise_scale * point), 0.0f, 1.0f);
+    };
+
+    i32 const thread_count = static_cast<i32>(std::max(1u, std::thread::hardware_concurrency()));
+    m_density = BakedGrid::create_volume(m_bbox, m_resolution, thread_count, density_function);
+
+    // The majorant of a cell bounds every density lookup inside it, so delta tracking stays unbiased.
+    glm::vec3 const size = {m_bbox.x.size(), m_bbox.y.size(), m_bbox.z.size()};
+    float const longest_size = std::max({size.x, size.y, size.z, 0.0001f});
+
+    m_majorant_counts = glm::max(glm::ivec3(glm::ceil(size / longest_size * static_cast<float>(majorant_resolution))), glm::ivec3(1, 1, 1));
+    m_majorant_origin = {m_bbox.x.min, m_bbox.y.min, m_bbox.z.min};
+    m_majorant_cell_size = glm::max(size, glm::vec3(0.0001f, 0.0001f, 0.0001f)) / glm::vec3(m_majorant_counts);
+    m_majorants.resize(static_cast<size_t>(m_majorant_counts.x) * m_majorant_counts.y * m_majorant_counts.z);
+
+    for (i32 z = 0; z < m_majorant_counts.z; ++z)
+    {
+        for (i32 y = 0; y < m_majorant_counts.y; ++y)
+        {
+            for (i32 x = 0; x < m_majorant_counts.x; ++x)
+            {
+                glm::vec3 const cell_min = m_majorant_origin + glm::vec3(x, y, z) * m_majorant_cell_size;
+                AABB const cell_bounds = {cell_min, cell_min + m_majorant_cell_size};
+                size_t const index = (static_cast<size_t>(z) * m_majorant_counts.y + y) * m_majorant_counts.x + x;
+
+                m_majorants[index] = m_density->max_value(cell_bounds);
+            }
+        }
+    }
+}
+
+bool HeterogeneousMedium::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+{
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::HeterogeneousMedium);
+
+    // Shadow rays take the ratio tracking estimate of transmittance() instead of a collision.
+    if (ray.is_shadow())
+        return false;
+
+    float t_enter = 0.0f;
+    float t_exit = 0.0f;
+
+    if (!clip(ray, ray_t, t_enter, t_exit))
+        return false;
+
+    float const ray_length = glm::length(ray.direction());
+    float collision_t = 0.0f;
+    bool has_collision = false;
+
+    traverse_majorants(ray, t_enter, t_exit, [&](float const t_min, float const t_max, float const majorant) {
+        if (majorant <= 0.0f)
+            return true;
+
+        float t = t_min;
+
+        while (true)
+        {
+            // Tentative collision with a medium of the majorant density. Distances are converted to ray parameters.
+            t -= std::log(1.0f - AK::random_float_fast()) / (majorant * ray_length);
+
+            if (t >= t_max)
+                return true;
+
+            // Real collision with the probability of the actual density, otherwise a null collision that changes nothing.
+            if (AK::random_float_fast() * majorant < m_density->sample(ray.at(t)))
+            {
+                collision_t = t;
+                has_collision = true;
+                return false;
+            }
+        }
+    });
+
+    if (!has_collision)
+        return false;
+
+    hit_record.t = collision_t;
+    hit_record.point = ray.at(collision_t);
+    hit_record.normal = glm::vec3(1.0f, 0.0f, 0.0f); // Arbitrary
+    hit_record.front_face = true; // Arbitrary
+    hit_record.uv_footprint = 0.0f;
+    hit_record.material = material;
+
+    return true;
+}
+
+float HeterogeneousMedium::transmittance(Ray const& ray, Interval const ray_t) const
+{
+    float t_enter = 0.0f;
+    float t_exit = 0.0f;
+
+    if (!clip(ray, ray_t, t_enter, t_exit))
+        return 1.0f;
+
+    float const ray_length = glm::length(ray.direction());
+    float transmittance = 1.0f;
+
+    traverse_majorants(ray, t_enter, t_exit, [&](float const t_min, float const t_max, float const majorant) {
+        if (majorant <= 0.0f)
+            return true;
+
+        float t = t_min;
+
+        while (true)
+        {
+            t -= std::log(1.0f - AK::random_float_fast()) / (majorant * ray_length);
+
+            if (t >= t_max)
+                return true;
+
+            // Every tentative collision only weights the estimate instead of ending the walk.
+            transmittance *= 1.0f - m_density->sample(ray.at(t)) / majorant;
+
+            if (transmittance < 0.0001f)
+            {
+                transmittance = 0.0f;
+                return false;
+            }
+        }
+    });
+
+    return transmittance;
+}
+
+float HeterogeneousMedium::density(glm::vec3 const& point) const
+{
+    return m_density->sample(point);
+}
+
+MediumBoundary const& HeterogeneousMedium::boundary() const
+{
+    return m_boundary;
+}
+
+float HeterogeneousMedium::max_density() const
+{
+    return m_max_density;
+}
+
+float HeterogeneousMedium::noise_scale() const
+{
+    return m_noise_scale;
+}
+
+u32 HeterogeneousMedium::seed() const
+{
+    return m_seed;
+}
+
+i32 HeterogeneousMedium::resolution() const
+{
+    return m_resolution;
+}
+
+template<typename Callback>
+void HeterogeneousMedium::traverse_majorants(Ray const& ray, float const t_enter, float const t_exit, Callback const& callback) const
+{
+    // 3D DDA over the majorant grid, starting in the cell of the entry point.
+    glm::vec3 const entry = (ray.at(t_enter) - m_majorant_origin) / m_majorant_cell_size;
+    glm::ivec3 cell = glm::clamp(glm::ivec3(glm::floor(entry)), glm::ivec3(0), m_majorant_counts - 1);
+
+    glm::ivec3 step = {};
+    glm::vec3 t_next = {};
+    glm::vec3 t_delta = {};
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        float const direction = ray.direction()[axis];
+
+        if (direction == 0.0f)
+        {
+            t_next[axis] = AK::INFINITY_F;
+            t_delta[axis] = AK::INFINITY_F;
+            continue;
+        }
+
+        step[axis] = direction > 0.0f ? 1 : -1;
+
+        i32 const next_cell = cell[axis] + (direction > 0.0f ? 1 : 0);
+        float const cell_boundary = m_majorant_origin[axis] + static_cast<float>(next_cell) * m_majorant_cell_size[axis];
+        t_next[axis] = (cell_boundary - ray.origin()[axis]) / direction;
+        t_delta[axis] = m_majorant_cell_size[axis] / std::abs(direction);
+    }
+
+    float t = t_enter;
+
+    while (t < t_exit)
+    {
+        i32 const axis = t_next.x < t_next.y ? (t_next.x < t_next.z ? 0 : 2) : (t_next.y < t_next.z ? 1 : 2);
+        float const t_cell_exit = std::min(t_next[axis], t_exit);
+        size_t const index = (static_cast<size_t>(cell.z) * m_majorant_counts.y + cell.y) * m_majorant_counts.x + cell.x;
+
+        if (!callback(t, t_cell_exit, m_majorants[index]))
+            return;
+
+        t = t_cell_exit;
+        cell[axis] += step[axis];
+
+        if (cell[axis] < 0 || cell[axis] >= m_majorant_counts[axis])
+            return;
+
+        t_next[axis] += t_delta[axis];
+    }
+}
+
+bool HeterogeneousMedium::clip(Ray const& ray, Interval const ray_t, float& t_enter, float& t_exit) const
+{
+    if (!m_boundary.intersect(ray, t_enter, t_exit))
+        return false;
+
+    t_enter = std::max(t_enter, ray_t.min);
+    t_exit = std::min(t_exit, ray_t.max);
+
+    return t_enter < t_exit;
+}
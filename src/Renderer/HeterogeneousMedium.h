@@ -0,0 +1,93 @@
+#pragma once
+
+#include "AK/AABB.h"
+#include "Hittable.h"
+#include "PerlinNoise.h"
+
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <vector>
+
+class BakedGrid;
+
+// Analytic convex boundary of a medium. Rays enter and leave it with a single intersection test,
+// instead of two closest hit searches over boundary hittables.
+struct MediumBoundary
+{
+    enum class Shape : u8
+    {
+        Sphere,
+        Box,
+    };
+
+    static MediumBoundary sphere(glm::vec3 const& center, float const radius);
+    static MediumBoundary box(glm::vec3 const& min, glm::vec3 const& max);
+
+    // Ray parameters of the entry and exit points, the entry is negative if the ray starts inside.
+    [[nodiscard]] bool intersect(Ray const& ray, float& t_enter, float& t_exit) const;
+
+    [[nodiscard]] AABB bounding_box() const;
+
+    Shape shape = Shape::Box;
+
+    // Sphere
+    glm::vec3 center = {};
+    float radius = 0.0f;
+
+    // Box
+    glm::vec3 min = {};
+    glm::vec3 max = {};
+};
+
+// Participating medium with a density that varies in space, noise driven fog. The density is baked into a grid
+// and rays are scattered with delta tracking against a coarse grid of per cell density maxima (majorants),
+// so thin regions are crossed in a few large steps.
+class HeterogeneousMedium final : public Hittable
+{
+public:
+    // Density goes from 0 to max_density, following Perlin noise with the given frequency and seed. Resolution is the
+    // number of density grid cells along the longest axis of the boundary.
+    HeterogeneousMedium(MediumBoundary const& boundary, float const max_density, float const noise_scale, u32 const seed,
+                        i32 const resolution, std::shared_ptr<MaterialCPU> const& material);
+
+    // Delta tracking, returns the first real collision.
+    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+
+    // Ratio tracking estimate of the fraction of light that passes through the medium along the ray.
+    // For shadow rays, which only need the attenuation and not a collision.
+    [[nodiscard]] virtual float transmittance(Ray const& ray, Interval const ray_t) const override;
+
+    [[nodiscard]] float density(glm::vec3 const& point) const;
+
+    [[nodiscard]] MediumBoundary const& boundary() const;
+    [[nodiscard]] float max_density() const;
+    [[nodiscard]] float noise_scale() const;
+    [[nodiscard]] u32 seed() const;
+    [[nodiscard]] i32 resolution() const;
+
+private:
+    // Walks the majorant cells the ray crosses between the two ray parameters. The callback gets the ray parameter
+    // range inside the cell and its majorant, and returns false to stop the walk.
+    template<typename Callback>
+    void traverse_majorants(Ray const& ray, float const t_enter, float const t_exit, Callback const& callback) const;
+
+    [[nodiscard]] bool clip(Ray const& ray, Interval const ray_t, float& t_enter, float& t_exit) const;
+
+    // Cells of the majorant grid along the longest axis of the boundary.
+    static i32 constexpr majorant_resolution = 16;
+
+    MediumBoundary m_boundary = {};
+    float m_max_density = 0.0f;
+    float m_noise_scale = 1.0f;
+    u32 m_seed = 0;
+    i32 m_resolution = 0;
+
+    PerlinNoise m_noise;
+    std::shared_ptr<BakedGrid> m_density = {};
+
+    glm::vec3 m_majorant_origin = {};
+    glm::vec3 m_majorant_cell_size = {};
+    glm::ivec3 m_majorant_counts = {};
+    std::vector<float> m_majorants = {};
+};
@@ -1,26 +1,11 @@
 #include "Hittable.h"
 
-#include "Raytracer.h"
-
-Hittable::Hittable(std::shared_ptr<Material> const& material) : Drawable(material)
-{
-}
-
-void Hittable::initialize()
-{
-    Drawable::initialize();
-
-    Raytracer::get_instance()->register_hittable(static_pointer_cast<Hittable>(shared_from_this()));
-}
-
-void Hittable::uninitialize()
+Hittable::Hittable(std::shared_ptr<MaterialCPU> const& material) : material(material)
 {
-    Drawable::uninitialize();
-
-    Raytracer::get_instance()->unregister_hittable(static_pointer_cast<Hittable>(shared_from_this()));
 }
 
-bool Hittable::hit_list(std::vector<std::weak_ptr<Hittable>> const& hittables, Ray const& ray, Interval const ray_t, HitRecord& hit_record)
+bool Hittable::hit_list(std::vector<std::shared_ptr<Hittable>> const& hittables, Ray const& ray, Interval const ray_t,
+                        HitRecord& hit_record)
 {
     HitRecord temp_record;
     bool hit_anything = false;
@@ -28,7 +13,7 @@ bool Hittable::hit_list(std::vector<std::weak_ptr<Hittable>> const& hittables, R
 
     for (auto const& object : hittables)
     {
-        if (object.lock()->hit(ray, Interval(ray_t.min, closest_so_far), temp_record))
+        if (object->hit(ray, Interval(ray_t.min, closest_so_far), temp_record))
         {
             hit_anything = true;
             closest_so_far = temp_record.t;
@@ -39,7 +24,22 @@ bool Hittable::hit_list(std::vector<std::weak_ptr<Hittable>> const& hittables, R
     return hit_anything;
 }
 
+bool Hittable::surface_point(float const, float const, glm::vec3&) const
+{
+    return false;
+}
+
+float Hittable::transmittance(Ray const&, Interval const) const
+{
+    return 1.0f;
+}
+
 AABB Hittable::bounding_box() const
 {
     return m_bbox;
 }
+
+AABB Hittable::bounding_box_at(float const) const
+{
+    return m_bbox;
+}
@@ -2,19 +2,33 @@
 
 #include "AK/AABB.h"
 #include "AK/Interval.h"
-#include "Drawable.h"
 #include "Ray.h"
 
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <memory>
+#include <vector>
+
+class MaterialCPU;
+
 struct HitRecord
 {
     glm::vec3 point;
     glm::vec3 normal;
-    std::shared_ptr<Material> material;
+    std::shared_ptr<MaterialCPU> material;
     float t;
     float u;
     float v;
     bool front_face;
 
+    // Size of the ray cone footprint in UV units, used to pick the mip level of image textures. 0 is the finest level.
+    float uv_footprint;
+
+    // Texture value at the hit if it is already known, like for cached camera hits. Scattering uses it instead of
+    // looking the texture up again.
+    glm::vec3 const* texture_color = nullptr;
+
     void set_face_normal(Ray const& ray, glm::vec3 const& outward_normal)
     {
         // Sets the hit record normal vector.
@@ -23,24 +37,46 @@ struct HitRecord
         front_face = glm::dot(ray.direction(), outward_normal) < 0.0f;
         normal = front_face ? outward_normal : -outward_normal;
     }
+
+    void set_uv_footprint(Ray const& ray, float const uv_scale)
+    {
+        // Sets the UV footprint from the ray cone at the hit. `uv_scale` is the world space length
+        // of one UV unit at the hit point, the footprint grows at grazing angles.
+        float const cosine = glm::abs(glm::dot(glm::normalize(ray.direction()), normal));
+        uv_footprint = ray.cone_width_at(t) / (uv_scale * glm::max(cosine, 0.05f));
+    }
 };
 
-class Hittable : public Drawable
+// Base of everything the raytracer can intersect. Hittables are plain objects without any engine dependencies,
+// they are added to the scene with Raytracer::register_hittable().
+class Hittable
 {
 public:
-    explicit Hittable(std::shared_ptr<Material> const& material);
-    ~Hittable() override = default;
-
-    virtual void initialize() override;
-    virtual void uninitialize() override;
+    explicit Hittable(std::shared_ptr<MaterialCPU> const& material);
+    virtual ~Hittable() = default;
 
     virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const = 0;
 
-    static bool hit_list(std::vector<std::weak_ptr<Hittable>> const& hittables, Ray const& ray, Interval const ray_t,
+    // Inverse of the UV mapping set by hit(): the world space point with the given texture coordinates.
+    // Returns false for hittables without a surface parameterization.
+    [[nodiscard]] virtual bool surface_point(float const u, float const v, glm::vec3& point) const;
+
+    // Fraction of light that passes through the hittable along the ray, for shadow rays through media.
+    // Surfaces return 1, shadow rays find them with hit() instead.
+    [[nodiscard]] virtual float transmittance(Ray const& ray, Interval const ray_t) const;
+
+    static bool hit_list(std::vector<std::shared_ptr<Hittable>> const& hittables, Ray const& ray, Interval const ray_t,
                          HitRecord& hit_record);
 
+    // Covers every moment of the exposure.
     AABB bounding_box() const;
 
+    // Bounds at the given time of the exposure, see Ray::time(). The BVH interpolates between the bounds at 0 and 1,
+    // so hittables only return something tighter than bounding_box() here if they move along a straight line.
+    [[nodiscard]] virtual AABB bounding_box_at(float const time) const;
+
+    std::shared_ptr<MaterialCPU> material = {};
+
 protected:
     AABB m_bbox;
 };
@@ -0,0 +1,307 @@
+#include "IrradianceProbes.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "Ray.h"
+#include "Raytracer.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+struct IrradianceProbesHeader
+{
+    u32 magic = 0;
+    u32 version = 0;
+    i32 counts[3] = {};
+    float bounds_min[3] = {};
+    float bounds_max[3] = {};
+};
+
+static std::array<float, 9> sh_basis(glm::vec3 const& direction)
+{
+    float const x = direction.x;
+    float const y = direction.y;
+    float const z = direction.z;
+
+    return {
+        0.282095f,
+        0.488603f * y,
+        0.488603f * z,
+        0.488603f * x,
+        1.092548f * x * y,
+        1.092548f * y * z,
+        0.315392f * (3.0f * z * z - 1.0f),
+        1.092548f * x * z,
+        0.546274f * (x * x - y * y),
+    };
+}
+
+// Spherical Fibonacci point set, evenly spread over the sphere. The random turn around the pole keeps neighbouring
+// probes from sampling exactly the same directions.
+static glm::vec3 fibonacci_direction(i32 const index, i32 const count, float const turn)
+{
+    float constexpr golden_ratio_fraction = 0.618034f;
+
+    float const z = 1.0f - (2.0f * static_cast<float>(index) + 1.0f) / static_cast<float>(count);
+    float const radius = glm::sqrt(glm::max(0.0f, 1.0f - z * z));
+    float const phi = 2.0f * AK::PI_F * glm::fract(static_cast<float>(index) * golden_ratio_fraction + turn);
+
+    return {radius * glm::cos(phi), radius * glm::sin(phi), z};
+}
+
+std::shared_ptr<IrradianceProbes> IrradianceProbes::create(AABB const& bounds, glm::ivec3 const& counts)
+{
+    return std::make_shared<IrradianceProbes>(AK::Badge<IrradianceProbes> {}, bounds, counts);
+}
+
+glm::ivec3 IrradianceProbes::counts_for(AABB const& bounds, i32 const probes_along_longest_axis)
+{
+    float const longest = bounds.axis_interval(bounds.longest_axis()).size();
+    glm::ivec3 counts = {};
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        float const fraction = longest > 0.0f ? bounds.axis_interval(axis).size() / longest : 1.0f;
+        counts[axis] = std::max(1, static_cast<i32>(std::round(fraction * static_cast<float>(probes_along_longest_axis))));
+    }
+
+    return counts;
+}
+
+IrradianceProbes::IrradianceProbes(AK::Badge<IrradianceProbes>, AABB const& bounds, glm::ivec3 const& counts)
+    : m_bounds(bounds), m_counts(glm::max(counts, glm::ivec3(1)))
+{
+    m_probes.resize(static_cast<size_t>(m_counts.x) * m_counts.y * m_counts.z);
+}
+
+void IrradianceProbes::bake(Raytracer const& raytracer, i32 const ray_count, i32 const thread_count, u64 const seed)
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    i32 const probe_count = static_cast<i32>(m_probes.size());
+
+    // Uniform directions, every ray stands for the same solid angle.
+    float const ray_weight = 4.0f * AK::PI_F / static_cast<float>(ray_count);
+
+    // Convolution with the clamped cosine per band, turns incoming radiance into irradiance.
+    std::array<float, 3> constexpr band_factors = {AK::PI_F, 2.0f * AK::PI_F / 3.0f, AK::PI_F / 4.0f};
+    std::array<i32, 9> constexpr coefficient_bands = {0, 1, 1, 1, 2, 2, 2, 2, 2};
+
+    std::atomic<i32> next_probe = 0;
+
+    auto const bake_probes = [&] {
+        for (i32 index = next_probe.fetch_add(1); index < probe_count; index = next_probe.fetch_add(1))
+        {
+            u64 hash = AK::HASH_OFFSET_BASIS;
+            AK::hash_bytes(hash, &seed, sizeof(seed));
+            AK::hash_bytes(hash, &index, sizeof(index));
+            AK::seed_random(hash);
+
+            glm::ivec3 const cell = {index % m_counts.x, (index / m_counts.x) % m_counts.y, index / (m_counts.x * m_counts.y)};
+            glm::vec3 const position = probe_position(cell);
+            float const turn = AK::random_float_fast();
+
+            ProbeSH sh = {};
+
+            for (i32 ray = 0; ray < ray_count; ++ray)
+            {
+                glm::vec3 const direction = fibonacci_direction(ray, ray_count, turn);
+                glm::vec3 const radiance = raytracer.trace(Ray(position, direction));
+                std::array<float, 9> const basis = sh_basis(direction);
+
+                for (size_t i = 0; i < sh.size(); ++i)
+                {
+                    sh[i] += radiance * basis[i];
+                }
+            }
+
+            for (size_t i = 0; i < sh.size(); ++i)
+            {
+                sh[i] *= ray_weight * band_factors[coefficient_bands[i]];
+            }
+
+            m_probes[index] = sh;
+        }
+    };
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(std::max(0, thread_count - 1));
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(bake_probes);
+    }
+
+    bake_probes();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::chrono::duration<double> const bake_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Probe bake time: " << bake_time.count() << " s (" << m_counts.x << "x" << m_counts.y << "x" << m_counts.z << " probes, "
+              << ray_count << " rays each, " << thread_count << " threads)\n";
+}
+
+bool IrradianceProbes::save(std::string const& path) const
+{
+    std::error_code error = {};
+    std::filesystem::path const parent = std::filesystem::path(path).parent_path();
+
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+
+    IrradianceProbesHeader header = {};
+    header.magic = magic;
+    header.version = version;
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        header.counts[axis] = m_counts[axis];
+        header.bounds_min[axis] = m_bounds.axis_interval(axis).min;
+        header.bounds_max[axis] = m_bounds.axis_interval(axis).max;
+    }
+
+    std::ofstream output(path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        std::cout << "Could not write the probe file: " << path << "\n";
+        return false;
+    }
+
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    output.write(reinterpret_cast<char const*>(m_probes.data()), static_cast<std::streamsize>(m_probes.size() * sizeof(ProbeSH)));
+
+    if (!output)
+    {
+        std::cout << "Could not write the probe file: " << path << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<IrradianceProbes> IrradianceProbes::load(std::string const& path)
+{
+    std::ifstream input(path, std::ios::binary);
+
+    if (!input.is_open())
+        return nullptr;
+
+    IrradianceProbesHeader header = {};
+    input.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    bool const is_valid = input && header.magic == magic && header.version == version && header.counts[0] > 0 && header.counts[1] > 0
+                       && header.counts[2] > 0;
+
+    if (!is_valid)
+    {
+        std::cout << "Not a probe file of this version: " << path << "\n";
+        return nullptr;
+    }
+
+    AABB const bounds = {glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]),
+                         glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2])};
+
+    auto probes = create(bounds, {header.counts[0], header.counts[1], header.counts[2]});
+    input.read(reinterpret_cast<char*>(probes->m_probes.data()), static_cast<std::streamsize>(probes->m_probes.size() * sizeof(ProbeSH)));
+
+    if (!input)
+    {
+        std::cout << "The probe file is damaged: " << path << "\n";
+        return nullptr;
+    }
+
+    return probes;
+}
+
+glm::vec3 IrradianceProbes::sample(glm::vec3 const& position, glm::vec3 const& normal) const
+{
+    // Grid coordinates with the probes on whole numbers.
+    glm::vec3 coordinates = {};
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        Interval const& interval = m_bounds.axis_interval(axis);
+        float const cell_size = interval.size() / static_cast<float>(m_counts[axis]);
+        float const coordinate = cell_size > 0.0f ? (position[axis] - interval.min) / cell_size - 0.5f : 0.0f;
+
+        coordinates[axis] = glm::clamp(coordinate, 0.0f, static_cast<float>(m_counts[axis] - 1));
+    }
+
+    glm::ivec3 const first = glm::min(glm::ivec3(glm::floor(coordinates)), m_counts - 1);
+    glm::ivec3 const last = glm::min(first + 1, m_counts - 1);
+    glm::vec3 const t = coordinates - glm::vec3(first);
+
+    // Irradiance is linear in the coefficients, so the probes can be blended after evaluating them.
+    glm::vec3 irradiance = {};
+
+    for (i32 corner = 0; corner < 8; ++corner)
+    {
+        glm::ivec3 const cell = {(corner & 1) ? last.x : first.x, (corner & 2) ? last.y : first.y, (corner & 4) ? last.z : first.z};
+        float const weight = ((corner & 1) ? t.x : 1.0f - t.x) * ((corner & 2) ? t.y : 1.0f - t.y) * ((corner & 4) ? t.z : 1.0f - t.z);
+
+        if (weight > 0.0f)
+            irradiance += weight * evaluate(m_probes[probe_index(cell)], normal);
+    }
+
+    return irradiance;
+}
+
+glm::vec3 IrradianceProbes::evaluate(ProbeSH const& sh, glm::vec3 const& normal)
+{
+    std::array<float, 9> const basis = sh_basis(glm::normalize(normal));
+    glm::vec3 irradiance = {};
+
+    for (size_t i = 0; i < sh.size(); ++i)
+    {
+        irradiance += sh[i] * basis[i];
+    }
+
+    // L2 ringing can dip below zero next to bright lights.
+    return glm::max(irradiance, glm::vec3(0.0f));
+}
+
+AABB const& IrradianceProbes::bounds() const
+{
+    return m_bounds;
+}
+
+glm::ivec3 const& IrradianceProbes::counts() const
+{
+    return m_counts;
+}
+
+glm::vec3 IrradianceProbes::probe_position(glm::ivec3 const& cell) const
+{
+    glm::vec3 position = {};
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        Interval const& interval = m_bounds.axis_interval(axis);
+        position[axis] = interval.min + (static_cast<float>(cell[axis]) + 0.5f) * interval.size() / static_cast<float>(m_counts[axis]);
+    }
+
+    return position;
+}
+
+std::vector<ProbeSH> const& IrradianceProbes::probes() const
+{
+    return m_probes;
+}
+
+i32 IrradianceProbes::probe_index(glm::ivec3 const& cell) const
+{
+    return (cell.z * m_counts.y + cell.y) * m_counts.x + cell.x;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "AK/AABB.h"
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+class Raytracer;
+
+// Irradiance of a probe as L2 spherical harmonics: 9 RGB coefficients in the order (l, m) = (0, 0), (1, -1), (1, 0), (1, 1),
+// (2, -2), (2, -1), (2, 0), (2, 1), (2, 2). The cosine lobe is already convolved in, evaluating the basis
+// for a normal gives the irradiance of a surface facing that way.
+using ProbeSH = std::array<glm::vec3, 9>;
+
+// Grid of irradiance probes over a box, baked offline with the raytracer for the raster renderer to light static
+// indirect lighting with. Probes sit at the centers of the grid cells, so none of them lies on the walls of a room
+// that fills the box.
+//
+// The file is a small header (magic, version, probe counts, bounds) followed by the SH coefficients of every probe,
+// x fastest, as 32-bit floats. 108 bytes per probe, ready to be uploaded to a structured buffer as is.
+class IrradianceProbes
+{
+public:
+    static std::shared_ptr<IrradianceProbes> create(AABB const& bounds, glm::ivec3 const& counts);
+
+    // Probes along every axis, spaced as evenly as possible with probes_along_longest_axis on the longest one.
+    [[nodiscard]] static glm::ivec3 counts_for(AABB const& bounds, i32 const probes_along_longest_axis);
+
+    explicit IrradianceProbes(AK::Badge<IrradianceProbes>, AABB const& bounds, glm::ivec3 const& counts);
+
+    // Traces ray_count paths from every probe, Raytracer::initialize() has to be called first. Probes are baked
+    // in parallel and seeded by their index, so the result does not depend on the thread count.
+    void bake(Raytracer const& raytracer, i32 const ray_count, i32 const thread_count, u64 const seed = 0);
+
+    bool save(std::string const& path) const;
+
+    // Returns nullptr if the file is missing or not a probe file of this version.
+    [[nodiscard]] static std::shared_ptr<IrradianceProbes> load(std::string const& path);
+
+    // Irradiance at the position for the normal, interpolated between the eight surrounding probes.
+    // Positions outside the grid use the closest probes.
+    [[nodiscard]] glm::vec3 sample(glm::vec3 const& position, glm::vec3 const& normal) const;
+
+    [[nodiscard]] static glm::vec3 evaluate(ProbeSH const& sh, glm::vec3 const& normal);
+
+    [[nodiscard]] AABB const& bounds() const;
+    [[nodiscard]] glm::ivec3 const& counts() const;
+    [[nodiscard]] glm::vec3 probe_position(glm::ivec3 const& cell) const;
+    [[nodiscard]] std::vector<ProbeSH> const& probes() const;
+
+private:
+    [[nodiscard]] i32 probe_index(glm::ivec3 const& cell) const;
+
+    static u32 constexpr version = 1;
+    static u32 constexpr magic = 0x42525052; // "RPRB"
+
+    AABB m_bounds = {};
+    glm::ivec3 m_counts = {};
+    std::vector<ProbeSH> m_probes = {};
+};
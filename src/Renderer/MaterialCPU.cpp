@@ -0,0 +1,119 @@
+#include "MaterialCPU.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "Hittable.h"
+#include "Ray.h"
+#include "TextureCPU.h"
+#include "TextureProgram.h"
+
+bool MaterialCPU::scatter(Ray const& ray_in, HitRecord const& hit_record, glm::vec3& attenuation, Ray& scattered) const
+{
+    if (metal)
+    {
+        glm::vec3 reflected = glm::reflect(ray_in.direction(), hit_record.normal);
+        reflected = glm::normalize(reflected) + (fuzz * AK::Math::random_unit_vector());
+        scattered = Ray(hit_record.point, reflected);
+        attenuation = color;
+        return glm::dot(scattered.direction(), hit_record.normal) > 0.0f;
+    }
+    else if (dielectric)
+    {
+        attenuation = glm::vec3(1.0f, 1.0f, 1.0f);
+        float const ri = hit_record.front_face ? (1.0f / refraction_index) : refraction_index;
+
+        glm::vec3 const unit_direction = glm::normalize(ray_in.direction());
+
+        float const cos_theta = glm::min(glm::dot(-unit_direction, hit_record.normal), 1.0f);
+        float const sin_theta = glm::sqrt(1.0f - cos_theta * cos_theta);
+
+        bool const cannot_refract = ri * sin_theta > 1.0f;
+        glm::vec3 direction;
+
+        if (cannot_refract || reflectance(cos_theta, ri) > AK::random_float_fast())
+        {
+            direction = glm::reflect(unit_direction, hit_record.normal);
+        }
+        else
+        {
+            direction = glm::refract(unit_direction, hit_record.normal, ri);
+        }
+
+        scattered = Ray(hit_record.point, direction);
+        return true;
+    }
+    else if (emissive)
+    {
+        return false;
+    }
+    else if (isotropic)
+    {
+        scattered = Ray(hit_record.point, AK::Math::random_unit_vector());
+        attenuation = texture_value(hit_record);
+        return true;
+    }
+    else
+    {
+        glm::vec3 scatter_direction = hit_record.normal + AK::Math::random_unit_vector();
+
+        if (AK::Math::are_nearly_equal(scatter_direction, glm::vec3(0.0f, 0.0f, 0.0f)))
+        {
+            scatter_direction = hit_record.normal;
+        }
+
+        scattered = Ray(hit_record.point, scatter_direction);
+
+        if (texture == nullptr)
+        {
+            attenuation = color;
+        }
+        else
+        {
+            attenuation = texture_value(hit_record);
+        }
+
+        return true;
+    }
+}
+
+glm::vec3 MaterialCPU::emit(float const u, float const v, glm::vec3 const& point) const
+{
+    if (!emissive)
+        return {};
+
+    return texture_value(u, v, point, 0.0f);
+}
+
+bool MaterialCPU::is_specular() const
+{
+    return dielectric || (metal && fuzz == 0.0f);
+}
+
+bool MaterialCPU::is_diffuse() const
+{
+    return !metal && !dielectric && !emissive && !isotropic;
+}
+
+glm::vec3 MaterialCPU::texture_value(float const u, float const v, glm::vec3 const& point, float const uv_footprint) const
+{
+    if (texture_program != nullptr)
+        return texture_program->evaluate(texture_entry, u, v, point, uv_footprint);
+
+    return texture->value(u, v, point);
+}
+
+glm::vec3 MaterialCPU::texture_value(HitRecord const& hit_record) const
+{
+    if (hit_record.texture_color != nullptr)
+        return *hit_record.texture_color;
+
+    return texture_value(hit_record.u, hit_record.v, hit_record.point, hit_record.uv_footprint);
+}
+
+float MaterialCPU::reflectance(float cosine, float refraction_index)
+{
+    // Use Schlick's approximation for reflectance.
+    float r0 = (1.0f - refraction_index) / (1.0f + refraction_index);
+    r0 = r0 * r0;
+    return r0 + (1.0f - r0) * glm::pow((1.0f - cosine), 5.0f);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "AK/Types.h"
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <memory>
+
+class TextureCPU;
+class TextureProgram;
+class Ray;
+struct HitRecord;
+
+// Raytracing part of a material. Lives in the raytracer library so it can be used without the engine,
+// the engine Material derives from it and adds the rasterization data.
+class MaterialCPU
+{
+public:
+    MaterialCPU() = default;
+    virtual ~MaterialCPU() = default;
+
+    bool scatter(Ray const& ray_in, HitRecord const& hit_record, glm::vec3& attenuation, Ray& scattered) const;
+    glm::vec3 emit(float const u, float const v, glm::vec3 const& point) const;
+
+    // Scatters into a single direction, like a perfect mirror or glass.
+    [[nodiscard]] bool is_specular() const;
+
+    // Scatters into the whole hemisphere with the plain Lambertian lobe.
+    [[nodiscard]] bool is_diffuse() const;
+
+    glm::vec4 color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+    std::shared_ptr<TextureCPU> texture = {};
+
+    // Set when the raytracer compiles the scene textures, lookups then run the program instead of the texture chain.
+    std::shared_ptr<TextureProgram const> texture_program = {};
+    u32 texture_entry = 0;
+
+    bool metal = false;
+    bool dielectric = false;
+    bool emissive = false;
+    bool isotropic = false;
+
+    // Should be in 0.0 - 1.0 range
+    float fuzz = 0.0f;
+
+    float refraction_index = 0.0f;
+
+private:
+    [[nodiscard]] glm::vec3 texture_value(float const u, float const v, glm::vec3 const& point, float const uv_footprint) const;
+    [[nodiscard]] glm::vec3 texture_value(HitRecord const& hit_record) const;
+
+    static float reflectance(float cosine, float refraction_index);
+};
@@ -0,0 +1,375 @@
+#include "PathGuide.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+// Recorded radiance is stored in 1 / 2^16 steps, which keeps the sums exact no matter in which order the threads add
+// them. Single records are clamped so a quadrant cannot overflow before it saw 2^28 of them.
+static float constexpr fixed_point_scale = 65536.0f;
+static float constexpr max_record = 1048576.0f;
+
+// Deepest level of the directional quadtrees, the cells are about 1e-11 of the sphere there.
+static i32 constexpr max_directional_depth = 20;
+
+// cos(theta) and phi of the direction scaled to the unit square. Equal areas on the square are equal solid angles.
+static glm::vec2 direction_to_square(glm::vec3 const& direction)
+{
+    float const cos_theta = glm::clamp(direction.z, -1.0f, 1.0f);
+    float phi = std::atan2(direction.y, direction.x);
+
+    if (phi < 0.0f)
+        phi += 2.0f * AK::PI_F;
+
+    glm::vec2 const point = {(cos_theta + 1.0f) * 0.5f, phi / (2.0f * AK::PI_F)};
+
+    return glm::clamp(point, 0.0f, std::nextafter(1.0f, 0.0f));
+}
+
+static glm::vec3 square_to_direction(glm::vec2 const& point)
+{
+    float const cos_theta = 2.0f * point.x - 1.0f;
+    float const sin_theta = glm::sqrt(glm::max(0.0f, 1.0f - cos_theta * cos_theta));
+    float const phi = 2.0f * AK::PI_F * point.y;
+
+    return {sin_theta * glm::cos(phi), sin_theta * glm::sin(phi), cos_theta};
+}
+
+static i32 quadrant_of(glm::vec2 const& point)
+{
+    return (point.x >= 0.5f ? 1 : 0) + (point.y >= 0.5f ? 2 : 0);
+}
+
+static glm::vec2 quadrant_offset(i32 const quadrant)
+{
+    return {static_cast<float>(quadrant & 1), static_cast<float>(quadrant >> 1)};
+}
+
+std::shared_ptr<PathGuide> PathGuide::create(PathGuideSettings const& settings, AABB const& bounds)
+{
+    return std::make_shared<PathGuide>(AK::Badge<PathGuide> {}, settings, bounds);
+}
+
+PathGuide::PathGuide(AK::Badge<PathGuide>, PathGuideSettings const& settings, AABB const& bounds) : m_settings(settings)
+{
+    m_settings.bsdf_fraction = glm::clamp(m_settings.bsdf_fraction, 0.0f, 1.0f);
+
+    float longest = 0.0f;
+
+    for (i32 axis = 0; axis < 3; ++axis)
+    {
+        m_bounds_min[axis] = bounds.axis_interval(axis).min;
+        longest = std::max(longest, bounds.axis_interval(axis).size());
+    }
+
+    // A little larger, so points on the border of the scene do not all end up in the outermost cells.
+    m_bounds_size = std::max(longest * 1.001f, 1e-4f);
+}
+
+u32 PathGuide::leaf_of(glm::vec3 const& point) const
+{
+    glm::vec3 position = glm::clamp((point - m_bounds_min) / m_bounds_size, 0.0f, 1.0f);
+    u32 node = 0;
+    i32 axis = 0;
+
+    while (m_spatial_nodes[node].children[0] != 0)
+    {
+        i32 const child = position[axis] < 0.5f ? 0 : 1;
+
+        position[axis] = position[axis] * 2.0f - static_cast<float>(child);
+        node = m_spatial_nodes[node].children[child];
+        axis = (axis + 1) % 3;
+    }
+
+    return m_spatial_nodes[node].leaf;
+}
+
+float PathGuide::sample(u32 const leaf, glm::vec3 const& normal, glm::vec3& direction) const
+{
+    DirectionalTree const& tree = m_leaves[leaf].sampling;
+
+    if (total_energy(tree.nodes[0]) > 0 && AK::random_float_fast() >= m_settings.bsdf_fraction)
+        direction = square_to_direction(sample_square(tree));
+
+    return pdf(leaf, normal, direction);
+}
+
+float PathGuide::pdf(u32 const leaf, glm::vec3 const& normal, glm::vec3 const& direction) const
+{
+    float const cosine_pdf = glm::max(glm::dot(direction, normal), 0.0f) / AK::PI_F;
+    DirectionalTree const& tree = m_leaves[leaf].sampling;
+
+    if (total_energy(tree.nodes[0]) == 0)
+        return cosine_pdf;
+
+    // The square covers the whole sphere with an area of 1.
+    float const guided_pdf = square_pdf(tree, direction_to_square(direction)) / (4.0f * AK::PI_F);
+
+    return m_settings.bsdf_fraction * cosine_pdf + (1.0f - m_settings.bsdf_fraction) * guided_pdf;
+}
+
+void PathGuide::record(u32 const leaf, glm::vec3 const& direction, float const radiance, float const pdf)
+{
+    DirectionalTree& tree = m_leaves[leaf].building;
+
+    std::atomic_ref(tree.sample_count).fetch_add(1, std::memory_order_relaxed);
+
+    // Also leaves out NaNs.
+    if (!(radiance > 0.0f) || !(pdf > 0.0f))
+        return;
+
+    // Estimate of the integral of the radiance over the quadrant it lands in.
+    u64 const energy = static_cast<u64>(glm::min(radiance / pdf, max_record) * fixed_point_scale);
+
+    if (energy == 0)
+        return;
+
+    glm::vec2 point = direction_to_square(direction);
+    u32 node = 0;
+
+    while (true)
+    {
+        i32 const quadrant = quadrant_of(point);
+        u32 const child = tree.nodes[node].children[quadrant];
+
+        // Only the quadrants without children count here, build() sums them up.
+        if (child == 0)
+        {
+            std::atomic_ref(tree.nodes[node].energy[quadrant]).fetch_add(energy, std::memory_order_relaxed);
+            return;
+        }
+
+        point = point * 2.0f - quadrant_offset(quadrant);
+        node = child;
+    }
+}
+
+void PathGuide::finish_iteration()
+{
+    split_spatial_leaves();
+
+    for (auto& leaf : m_leaves)
+    {
+        build(leaf.building, 0);
+
+        leaf.sampling = std::move(leaf.building);
+        leaf.building = refine(leaf.sampling, m_settings.directional_threshold);
+    }
+
+    m_iteration += 1;
+}
+
+PathGuideSettings const& PathGuide::settings() const
+{
+    return m_settings;
+}
+
+i32 PathGuide::iteration() const
+{
+    return m_iteration;
+}
+
+size_t PathGuide::leaf_count() const
+{
+    return m_leaves.size();
+}
+
+size_t PathGuide::directional_node_count() const
+{
+    size_t count = 0;
+
+    for (auto const& leaf : m_leaves)
+    {
+        count += leaf.sampling.nodes.size();
+    }
+
+    return count;
+}
+
+void PathGuide::split_spatial_leaves()
+{
+    // Later iterations trace more paths, the threshold grows slower than them so the tree keeps getting finer.
+    double const threshold = static_cast<double>(m_settings.spatial_threshold) * std::sqrt(std::pow(2.0, m_iteration));
+
+    struct StackEntry
+    {
+        u32 node = 0;
+        i32 depth = 0;
+    };
+
+    std::vector<StackEntry> stack = {{0, 0}};
+
+    while (!stack.empty())
+    {
+        StackEntry const entry = stack.back();
+        stack.pop_back();
+
+        if (m_spatial_nodes[entry.node].children[0] != 0)
+        {
+            stack.push_back({m_spatial_nodes[entry.node].children[0], entry.depth + 1});
+            stack.push_back({m_spatial_nodes[entry.node].children[1], entry.depth + 1});
+            continue;
+        }
+
+        u32 const leaf = m_spatial_nodes[entry.node].leaf;
+
+        // Deep enough for the cells to be smaller than the float precision of the positions.
+        if (static_cast<double>(m_leaves[leaf].building.sample_count) <= threshold || entry.depth >= 60)
+            continue;
+
+        // Both halves start from the distribution of the whole cell, with half of its paths each.
+        m_leaves[leaf].building.sample_count /= 2;
+
+        Leaf half = m_leaves[leaf];
+        m_leaves.emplace_back(std::move(half));
+
+        u32 const first = static_cast<u32>(m_spatial_nodes.size());
+        m_spatial_nodes.push_back({{}, leaf});
+        m_spatial_nodes.push_back({{}, static_cast<u32>(m_leaves.size() - 1)});
+        m_spatial_nodes[entry.node].children = {first, first + 1};
+
+        // The halves may still have too many paths.
+        stack.push_back({first, entry.depth + 1});
+        stack.push_back({first + 1, entry.depth + 1});
+    }
+}
+
+glm::vec2 PathGuide::sample_square(DirectionalTree const& tree)
+{
+    glm::vec2 origin = {};
+    float size = 1.0f;
+    u32 node = 0;
+
+    while (true)
+    {
+        DirectionalNode const& current = tree.nodes[node];
+        float const target = AK::random_float_fast() * static_cast<float>(total_energy(current));
+
+        // Picks a quadrant with a probability proportional to its energy. Quadrants without any are skipped, so the
+        // rounding of the sums cannot pick one.
+        i32 quadrant = 0;
+        float sum = 0.0f;
+
+        for (i32 i = 0; i < 4; ++i)
+        {
+            if (current.energy[i] == 0)
+                continue;
+
+            quadrant = i;
+            sum += static_cast<float>(current.energy[i]);
+
+            if (sum > target)
+                break;
+        }
+
+        size *= 0.5f;
+        origin += quadrant_offset(quadrant) * size;
+
+        if (current.children[quadrant] == 0)
+            return origin + size * glm::vec2(AK::random_float_fast(), AK::random_float_fast());
+
+        node = current.children[quadrant];
+    }
+}
+
+float PathGuide::square_pdf(DirectionalTree const& tree, glm::vec2 point)
+{
+    float pdf = 1.0f;
+    u32 node = 0;
+
+    while (true)
+    {
+        DirectionalNode const& current = tree.nodes[node];
+        u64 const total = total_energy(current);
+
+        if (total == 0)
+            return 0.0f;
+
+        i32 const quadrant = quadrant_of(point);
+
+        // The quadrant covers a quarter of the area of the node.
+        pdf *= 4.0f * static_cast<float>(current.energy[quadrant]) / static_cast<float>(total);
+
+        if (current.children[quadrant] == 0)
+            return pdf;
+
+        point = point * 2.0f - quadrant_offset(quadrant);
+        node = current.children[quadrant];
+    }
+}
+
+u64 PathGuide::total_energy(DirectionalNode const& node)
+{
+    return node.energy[0] + node.energy[1] + node.energy[2] + node.energy[3];
+}
+
+u64 PathGuide::build(DirectionalTree& tree, u32 const node)
+{
+    for (i32 quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        u32 const child = tree.nodes[node].children[quadrant];
+
+        if (child != 0)
+            tree.nodes[node].energy[quadrant] = build(tree, child);
+    }
+
+    return total_energy(tree.nodes[node]);
+}
+
+PathGuide::DirectionalTree PathGuide::refine(DirectionalTree const& tree, float const threshold)
+{
+    DirectionalTree refined = {};
+    u64 const total = total_energy(tree.nodes[0]);
+
+    // Nothing to go by, the next iteration samples the BSDF only and records into a single cell.
+    if (total == 0)
+        return refined;
+
+    struct StackEntry
+    {
+        u32 node = 0;
+
+        // Node of the old tree covering the same square, 0 if the old tree did not subdivide that far.
+        u32 old_node = 0;
+        bool has_old_node = false;
+
+        // Part of the total energy in the square of the node.
+        double fraction = 0.0;
+        i32 depth = 0;
+    };
+
+    std::vector<StackEntry> stack = {{0, 0, true, 1.0, 1}};
+
+    while (!stack.empty())
+    {
+        StackEntry const entry = stack.back();
+        stack.pop_back();
+
+        for (i32 quadrant = 0; quadrant < 4; ++quadrant)
+        {
+            // Squares the old tree did not subdivide are assumed to be uniform.
+            double const fraction = entry.has_old_node
+                                      ? static_cast<double>(tree.nodes[entry.old_node].energy[quadrant]) / static_cast<double>(total)
+                                      : entry.fraction / 4.0;
+
+            if (fraction <= threshold || entry.depth >= max_directional_depth)
+                continue;
+
+            u32 const child = static_cast<u32>(refined.nodes.size());
+            refined.nodes.emplace_back();
+            refined.nodes[entry.node].children[quadrant] = child;
+
+            u32 const old_child = entry.has_old_node ? tree.nodes[entry.old_node].children[quadrant] : 0;
+            stack.push_back({child, old_child, old_child != 0, fraction, entry.depth + 1});
+        }
+    }
+
+    return refined;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "AK/AABB.h"
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+
+struct PathGuideSettings
+{
+    // Training iterations run by initialize(), 0 disables path guiding.
+    i32 iteration_count = 0;
+
+    // Samples per pixel of the first training iteration, every following iteration takes twice as many.
+    i32 training_samples = 1;
+
+    // Part of the diffuse bounces sampled from the BSDF instead of the learned distribution, between 0 and 1.
+    float bsdf_fraction = 0.5f;
+
+    // Spatial cells that recorded more than this times sqrt(2^iteration) paths in an iteration are split in half. Lower
+    // than in the paper, which trained on much larger images.
+    i32 spatial_threshold = 2000;
+
+    // Directional cells holding more than this part of the recorded radiance of their distribution are split in four.
+    float directional_threshold = 0.01f;
+};
+
+// Learns where the light arriving at diffuse surfaces comes from, so bounces can be sent there instead of all over the
+// cosine lobe. Helps most when the light reaches the scene through small openings, like the Cornell box lit by a quad
+// in the ceiling, where only a few BSDF samples ever find it.
+//
+// Practical path guiding after Mueller et al.: a binary tree splitting the scene bounds in half along x, y and z in turn,
+// with a quadtree over the sphere of directions in every leaf. Directions map to the unit square by cos(theta) and phi,
+// which keeps areas, so the quadtree is a piecewise constant density over the sphere. Every leaf holds the distribution
+// sampled from during an iteration and the one the iteration records into. After the iteration the recorded one is
+// sampled from and the tree is refined where it recorded many paths or much radiance.
+//
+// Recording is thread-safe: the trees do not change during an iteration and the radiance is added to fixed point
+// counters with atomic adds, so the result does not depend on the order of the threads either.
+class PathGuide
+{
+public:
+    static std::shared_ptr<PathGuide> create(PathGuideSettings const& settings, AABB const& bounds);
+
+    explicit PathGuide(AK::Badge<PathGuide>, PathGuideSettings const& settings, AABB const& bounds);
+
+    // Leaf of the spatial tree containing the point, points outside the bounds go to the closest leaf.
+    [[nodiscard]] u32 leaf_of(glm::vec3 const& point) const;
+
+    // Takes a cosine distributed direction around the normal and replaces it with a sample of the learned distribution
+    // of the leaf with a probability of 1 - bsdf_fraction. Returns the density of the mixture for the direction, per
+    // solid angle. Leaves that learned nothing yet keep the cosine sample.
+    float sample(u32 const leaf, glm::vec3 const& normal, glm::vec3& direction) const;
+
+    // Density of sample() for the direction, per solid angle.
+    [[nodiscard]] float pdf(u32 const leaf, glm::vec3 const& normal, glm::vec3 const& direction) const;
+
+    // Adds the radiance arriving at a point of the leaf from the direction, which was sampled with the given density,
+    // to the distribution of the current iteration. Can be called from any thread.
+    void record(u32 const leaf, glm::vec3 const& direction, float const radiance, float const pdf);
+
+    // Samples from what the iteration recorded from now on and refines the trees for the next one.
+    void finish_iteration();
+
+    [[nodiscard]] PathGuideSettings const& settings() const;
+    [[nodiscard]] i32 iteration() const;
+    [[nodiscard]] size_t leaf_count() const;
+    [[nodiscard]] size_t directional_node_count() const;
+
+private:
+    struct DirectionalNode
+    {
+        // Radiance recorded in each quadrant, in fixed point, see record(). Quadrant i covers x >= 0.5 if i & 1 and
+        // y >= 0.5 if i & 2. Once the tree is built, quadrants with a child hold the sum of the child.
+        std::array<u64, 4> energy = {};
+
+        // Index of the node subdividing each quadrant, 0 for quadrants that are not subdivided.
+        std::array<u32, 4> children = {};
+    };
+
+    struct DirectionalTree
+    {
+        // The root is node 0.
+        std::vector<DirectionalNode> nodes = {DirectionalNode {}};
+        u64 sample_count = 0;
+    };
+
+    struct SpatialNode
+    {
+        // Both 0 for leaves. The split axis is the depth of the node modulo 3.
+        std::array<u32, 2> children = {};
+        u32 leaf = 0;
+    };
+
+    struct Leaf
+    {
+        DirectionalTree sampling = {};
+        DirectionalTree building = {};
+    };
+
+    void split_spatial_leaves();
+
+    [[nodiscard]] static glm::vec2 sample_square(DirectionalTree const& tree);
+    [[nodiscard]] static float square_pdf(DirectionalTree const& tree, glm::vec2 point);
+    [[nodiscard]] static u64 total_energy(DirectionalNode const& node);
+    static u64 build(DirectionalTree& tree, u32 const node);
+    [[nodiscard]] static DirectionalTree refine(DirectionalTree const& tree, float const threshold);
+
+    PathGuideSettings m_settings = {};
+
+    // Cube around the scene bounds, so the cells stay close to cubes as they are split.
+    glm::vec3 m_bounds_min = {};
+    float m_bounds_size = 1.0f;
+
+    // The root is node 0.
+    std::vector<SpatialNode> m_spatial_nodes = {SpatialNode {}};
+    std::vector<Leaf> m_leaves = {Leaf {}};
+
+    i32 m_iteration = 0;
+};
@@ -2,28 +2,30 @@
 
 #include "AK/AK.h"
 
-#include <glm/gtc/random.hpp>
+#include <glm/geometric.hpp>
 
-PerlinNoise::PerlinNoise()
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+PerlinNoise::PerlinNoise(u32 const seed)
 {
-    m_rand_float = new float[point_count];
+    std::default_random_engine engine(seed);
+    std::uniform_real_distribution random_floats(-1.0f, 1.0f);
 
     for (i32 i = 0; i < point_count; ++i)
     {
-        m_random_vectors[i] = glm::normalize(glm::linearRand(glm::vec3(-1.0f, -1.0f, -1.0f), glm::vec3(1.0f, 1.0f, 1.0f)));
+        glm::vec3 const gradient = glm::normalize(glm::vec3(random_floats(engine), random_floats(engine), random_floats(engine)));
+        m_gradients[i] = gradient.x;
+        m_gradients[point_count + i] = gradient.y;
+        m_gradients[point_count * 2 + i] = gradient.z;
     }
 
-    m_permutation_x = perlin_generate_permutation();
-    m_permutation_y = perlin_generate_permutation();
-    m_permutation_z = perlin_generate_permutation();
-}
-
-PerlinNoise::~PerlinNoise()
-{
-    delete[] m_rand_float;
-    delete[] m_permutation_x;
-    delete[] m_permutation_y;
-    delete[] m_permutation_z;
+    generate_permutation(m_permutations.data(), engine);
+    generate_permutation(m_permutations.data() + point_count, engine);
+    generate_permutation(m_permutations.data() + point_count * 2, engine);
 }
 
 float PerlinNoise::noise(glm::vec3 const& point) const
@@ -40,7 +42,15 @@ float PerlinNoise::noise(glm::vec3 const& point) const
     auto const k = static_cast<i32>(y_floor);
     auto const m = static_cast<i32>(z_floor);
 
-    glm::vec3 c[2][2][2];
+    float const uu = u * u * (3 - 2 * u);
+    float const vv = v * v * (3 - 2 * v);
+    float const ww = w * w * (3 - 2 * w);
+
+    i32 const* permutation_x = m_permutations.data();
+    i32 const* permutation_y = permutation_x + point_count;
+    i32 const* permutation_z = permutation_y + point_count;
+
+    float accumulator = 0.0f;
 
     for (i32 di = 0; di < 2; ++di)
     {
@@ -48,75 +58,189 @@ float PerlinNoise::noise(glm::vec3 const& point) const
         {
             for (i32 dm = 0; dm < 2; ++dm)
             {
-                c[di][dk][dm] =
-                    m_random_vectors[m_permutation_x[(i + di) & 255] ^ m_permutation_y[(k + dk) & 255] ^ m_permutation_z[(m + dm) & 255]];
+                i32 const gradient = permutation_x[(i + di) & 255] ^ permutation_y[(k + dk) & 255] ^ permutation_z[(m + dm) & 255];
+
+                float const dot = m_gradients[gradient] * (u - di) + m_gradients[point_count + gradient] * (v - dk)
+                                + m_gradients[point_count * 2 + gradient] * (w - dm);
+
+                accumulator += (di * uu + (1 - di) * (1 - uu)) * (dk * vv + (1 - dk) * (1 - vv)) * (dm * ww + (1 - dm) * (1 - ww)) * dot;
             }
         }
     }
 
-    return perlin_interpolation(c, u, v, w);
+    return accumulator;
+}
+
+void PerlinNoise::noise(float const* x, float const* y, float const* z, float* results, i32 const count) const
+{
+    i32 index = 0;
+
+    for (; index + batch_size <= count; index += batch_size)
+    {
+        noise_batch(x + index, y + index, z + index, results + index);
+    }
+
+    if (index == count)
+        return;
+
+    alignas(32) std::array<float, batch_size> padded_x = {};
+    alignas(32) std::array<float, batch_size> padded_y = {};
+    alignas(32) std::array<float, batch_size> padded_z = {};
+    alignas(32) std::array<float, batch_size> padded_results = {};
+
+    i32 const remainder = count - index;
+
+    std::copy_n(x + index, remainder, padded_x.data());
+    std::copy_n(y + index, remainder, padded_y.data());
+    std::copy_n(z + index, remainder, padded_z.data());
+
+    noise_batch(padded_x.data(), padded_y.data(), padded_z.data(), padded_results.data());
+
+    std::copy_n(padded_results.data(), remainder, results + index);
 }
 
 float PerlinNoise::turbulence(glm::vec3 const& point, i32 const depth) const
 {
+    alignas(32) std::array<float, batch_size> x = {};
+    alignas(32) std::array<float, batch_size> y = {};
+    alignas(32) std::array<float, batch_size> z = {};
+    alignas(32) std::array<float, batch_size> values = {};
+
     float accumulator = 0.0f;
-    glm::vec3 temp_point = point;
     float weight = 1.0f;
+    glm::vec3 temp_point = point;
 
-    for (i32 i = 0; i < depth; ++i)
+    for (i32 first_octave = 0; first_octave < depth; first_octave += batch_size)
     {
-        accumulator += weight * noise(temp_point);
-        weight *= 0.5f;
-        temp_point *= 2.0f;
+        i32 const octave_count = std::min(batch_size, depth - first_octave);
+
+        for (i32 i = 0; i < octave_count; ++i)
+        {
+            x[i] = temp_point.x;
+            y[i] = temp_point.y;
+            z[i] = temp_point.z;
+            temp_point *= 2.0f;
+        }
+
+        noise_batch(x.data(), y.data(), z.data(), values.data());
+
+        for (i32 i = 0; i < octave_count; ++i)
+        {
+            accumulator += weight * values[i];
+            weight *= 0.5f;
+        }
     }
 
     return std::fabs(accumulator);
 }
 
-float PerlinNoise::perlin_interpolation(glm::vec3 const c[2][2][2], float const u, float const v, float const w)
+#if defined(__AVX2__)
+
+void PerlinNoise::noise_batch(float const* x, float const* y, float const* z, float* results) const
 {
-    float const uu = u * u * (3 - 2 * u);
-    float const vv = v * v * (3 - 2 * v);
-    float const ww = w * w * (3 - 2 * w);
-    float accumulator = 0.0f;
+    __m256 const one = _mm256_set1_ps(1.0f);
+    __m256 const two = _mm256_set1_ps(2.0f);
+    __m256 const three = _mm256_set1_ps(3.0f);
+    __m256i const mask = _mm256_set1_epi32(255);
+    __m256i const one_i = _mm256_set1_epi32(1);
+
+    __m256 const px = _mm256_loadu_ps(x);
+    __m256 const py = _mm256_loadu_ps(y);
+    __m256 const pz = _mm256_loadu_ps(z);
+
+    __m256 const x_floor = _mm256_floor_ps(px);
+    __m256 const y_floor = _mm256_floor_ps(py);
+    __m256 const z_floor = _mm256_floor_ps(pz);
+
+    __m256 const u = _mm256_sub_ps(px, x_floor);
+    __m256 const v = _mm256_sub_ps(py, y_floor);
+    __m256 const w = _mm256_sub_ps(pz, z_floor);
+
+    // Hermite smoothing, u * u * (3 - 2 * u).
+    __m256 const uu = _mm256_mul_ps(_mm256_mul_ps(u, u), _mm256_fnmadd_ps(two, u, three));
+    __m256 const vv = _mm256_mul_ps(_mm256_mul_ps(v, v), _mm256_fnmadd_ps(two, v, three));
+    __m256 const ww = _mm256_mul_ps(_mm256_mul_ps(w, w), _mm256_fnmadd_ps(two, w, three));
+
+    __m256 const weights_u[2] = {_mm256_sub_ps(one, uu), uu};
+    __m256 const weights_v[2] = {_mm256_sub_ps(one, vv), vv};
+    __m256 const weights_w[2] = {_mm256_sub_ps(one, ww), ww};
+
+    __m256 const offsets_u[2] = {u, _mm256_sub_ps(u, one)};
+    __m256 const offsets_v[2] = {v, _mm256_sub_ps(v, one)};
+    __m256 const offsets_w[2] = {w, _mm256_sub_ps(w, one)};
+
+    __m256i const i = _mm256_cvttps_epi32(x_floor);
+    __m256i const k = _mm256_cvttps_epi32(y_floor);
+    __m256i const m = _mm256_cvttps_epi32(z_floor);
+
+    i32 const* permutation_x = m_permutations.data();
+    i32 const* permutation_y = permutation_x + point_count;
+    i32 const* permutation_z = permutation_y + point_count;
+
+    __m256i const hashes_x[2] = {
+        _mm256_i32gather_epi32(permutation_x, _mm256_and_si256(i, mask), 4),
+        _mm256_i32gather_epi32(permutation_x, _mm256_and_si256(_mm256_add_epi32(i, one_i), mask), 4),
+    };
+    __m256i const hashes_y[2] = {
+        _mm256_i32gather_epi32(permutation_y, _mm256_and_si256(k, mask), 4),
+        _mm256_i32gather_epi32(permutation_y, _mm256_and_si256(_mm256_add_epi32(k, one_i), mask), 4),
+    };
+    __m256i const hashes_z[2] = {
+        _mm256_i32gather_epi32(permutation_z, _mm256_and_si256(m, mask), 4),
+        _mm256_i32gather_epi32(permutation_z, _mm256_and_si256(_mm256_add_epi32(m, one_i), mask), 4),
+    };
+
+    float const* gradients_x = m_gradients.data();
+    float const* gradients_y = gradients_x + point_count;
+    float const* gradients_z = gradients_y + point_count;
+
+    __m256 accumulator = _mm256_setzero_ps();
 
-    for (i32 i = 0; i < 2; ++i)
+    for (i32 di = 0; di < 2; ++di)
     {
-        for (i32 k = 0; k < 2; ++k)
+        for (i32 dk = 0; dk < 2; ++dk)
         {
-            for (i32 m = 0; m < 2; ++m)
+            __m256i const hash_xy = _mm256_xor_si256(hashes_x[di], hashes_y[dk]);
+            __m256 const weight_uv = _mm256_mul_ps(weights_u[di], weights_v[dk]);
+
+            for (i32 dm = 0; dm < 2; ++dm)
             {
-                auto const weight_v = glm::vec3(u - i, v - k, w - m);
-                accumulator += (i * uu + (1 - i) * (1 - uu)) * (k * vv + (1 - k) * (1 - vv)) * (m * ww + (1 - m) * (1 - ww))
-                             * glm::dot(c[i][k][m], weight_v);
+                __m256i const gradient = _mm256_xor_si256(hash_xy, hashes_z[dm]);
+
+                __m256 dot = _mm256_mul_ps(_mm256_i32gather_ps(gradients_x, gradient, 4), offsets_u[di]);
+                dot = _mm256_fmadd_ps(_mm256_i32gather_ps(gradients_y, gradient, 4), offsets_v[dk], dot);
+                dot = _mm256_fmadd_ps(_mm256_i32gather_ps(gradients_z, gradient, 4), offsets_w[dm], dot);
+
+                accumulator = _mm256_fmadd_ps(_mm256_mul_ps(weight_uv, weights_w[dm]), dot, accumulator);
             }
         }
     }
 
-    return accumulator;
+    _mm256_storeu_ps(results, accumulator);
 }
 
-i32* PerlinNoise::perlin_generate_permutation()
+#else
+
+void PerlinNoise::noise_batch(float const* x, float const* y, float const* z, float* results) const
 {
-    auto const p = new i32[point_count];
+    for (i32 i = 0; i < batch_size; ++i)
+    {
+        results[i] = noise(glm::vec3(x[i], y[i], z[i]));
+    }
+}
+
+#endif
 
+void PerlinNoise::generate_permutation(i32* p, std::default_random_engine& engine)
+{
     for (i32 i = 0; i < point_count; ++i)
     {
         p[i] = i;
     }
 
-    permute(p, point_count);
-
-    return p;
-}
-
-void PerlinNoise::permute(i32* p, i32 n)
-{
-    for (i32 i = n - 1; i > 0; --i)
+    for (i32 i = point_count - 1; i > 0; --i)
     {
-        i32 const target = AK::random_int_fast(0, i);
-        i32 const temp = p[i];
-        p[i] = p[target];
-        p[target] = temp;
+        i32 const target = std::uniform_int_distribution(0, i)(engine);
+        std::swap(p[i], p[target]);
     }
 }
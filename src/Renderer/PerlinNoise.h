@@ -4,27 +4,37 @@
 
 #include <array>
 #include <glm/vec3.hpp>
+#include <random>
 
 class PerlinNoise
 {
 public:
-    PerlinNoise();
-    ~PerlinNoise();
+    // Number of points evaluated together by the batch kernel, one AVX2 register of floats.
+    static i32 constexpr batch_size = 8;
+
+    // The tables come from the seed instead of the global engine, so a scene builds the same noise in every run
+    // and a render can be resumed from a checkpoint.
+    explicit PerlinNoise(u32 const seed = 0);
 
     [[nodiscard]] float noise(glm::vec3 const& point) const;
+
+    // Batch version of noise() for points given as separate x, y and z arrays. Any count works,
+    // full batches go through the SIMD kernel and the remainder is padded.
+    void noise(float const* x, float const* y, float const* z, float* results, i32 const count) const;
+
+    // The octaves are independent, so they are evaluated as a batch instead of calling noise() once per octave.
     [[nodiscard]] float turbulence(glm::vec3 const& point, i32 const depth) const;
 
 private:
-    static float perlin_interpolation(glm::vec3 const c[2][2][2], float const u, float const v, float const w);
-    static i32* perlin_generate_permutation();
-    static void permute(i32* p, i32 n);
+    void noise_batch(float const* x, float const* y, float const* z, float* results) const;
+
+    static void generate_permutation(i32* p, std::default_random_engine& engine);
 
     static i32 constexpr point_count = 256;
 
-    std::array<glm::vec3, point_count> m_random_vectors = {};
-    float* m_rand_float = nullptr;
+    // Gradient vectors as separate x, y and z planes, so the batch kernel can gather them directly.
+    std::array<float, point_count * 3> m_gradients = {};
 
-    i32* m_permutation_x = nullptr;
-    i32* m_permutation_y = nullptr;
-    i32* m_permutation_z = nullptr;
+    // X, Y and Z permutations fused into a single 3 KB table that stays in L1.
+    std::array<i32, point_count * 3> m_permutations = {};
 };
@@ -0,0 +1,398 @@
+#include "PhotonMap.h"
+
+#include "AK/AK.h"
+#include "AK/Math.h"
+#include "MaterialCPU.h"
+#include "QuadRaytraced.h"
+#include "Raytracer.h"
+#include "SphereRaytraced.h"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+struct PhotonEmitter
+{
+    QuadRaytraced const* quad = nullptr;
+    SphereRaytraced const* sphere = nullptr;
+    MaterialCPU const* material = nullptr;
+    float area = 0.0f;
+};
+
+// Uniformly distributed random point on the emitter with its outward normal and texture coordinates.
+static void sample_emitter(PhotonEmitter const& emitter, glm::vec3& point, glm::vec3& normal, float& u, float& v)
+{
+    if (emitter.quad != nullptr)
+    {
+        u = AK::random_float_fast();
+        v = AK::random_float_fast();
+        point = emitter.quad->q() + u * emitter.quad->u() + v * emitter.quad->v();
+        normal = glm::normalize(glm::cross(emitter.quad->u(), emitter.quad->v()));
+        return;
+    }
+
+    normal = AK::Math::random_unit_vector();
+    point = emitter.sphere->center() + emitter.sphere->radius() * normal;
+    SphereRaytraced::get_sphere_uv(normal, u, v);
+}
+
+static float luminance(glm::vec3 const& color)
+{
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+std::shared_ptr<PhotonMap> PhotonMap::create(PhotonMapSettings const& settings)
+{
+    return std::make_shared<PhotonMap>(AK::Badge<PhotonMap> {}, settings);
+}
+
+PhotonMap::PhotonMap(AK::Badge<PhotonMap>, PhotonMapSettings const& settings) : m_settings(settings)
+{
+    m_settings.pass_count = std::max(1, m_settings.pass_count);
+}
+
+void PhotonMap::trace(Raytracer const& raytracer, i32 const thread_count, u64 const seed)
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    m_passes.clear();
+    m_passes.resize(m_settings.pass_count);
+
+    size_t stored_count = 0;
+
+    for (i32 i = 0; i < m_settings.pass_count; ++i)
+    {
+        Pass& pass = m_passes[i];
+        pass.photons = trace_pass(raytracer, thread_count, seed + static_cast<u64>(i));
+
+        if (i == 0)
+        {
+            pass.radius = m_settings.radius > 0.0f ? m_settings.radius : pick_radius(pass.photons);
+        }
+        else
+        {
+            float const previous_radius = m_passes[i - 1].radius;
+            float const shrink = (static_cast<float>(i) + m_settings.alpha) / static_cast<float>(i + 1);
+            pass.radius = previous_radius * glm::sqrt(shrink);
+        }
+
+        build_grid(pass);
+        stored_count += pass.photons.size();
+    }
+
+    std::chrono::duration<double> const trace_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Photon trace time: " << trace_time.count() << " s (" << stored_count << " caustic photons stored in "
+              << m_settings.pass_count << " passes, radius " << m_passes.front().radius << " to " << m_passes.back().radius << ")\n";
+}
+
+glm::vec3 PhotonMap::estimate(i32 const pass_index, glm::vec3 const& point, glm::vec3 const& normal) const
+{
+    Pass const& pass = m_passes[pass_index];
+
+    if (pass.photons.empty())
+        return {};
+
+    float const radius_squared = pass.radius * pass.radius;
+    float const cell_size = 2.0f * pass.radius;
+    size_t const bucket_count = pass.bucket_starts.size() - 1;
+
+    // The disc spans at most two cells along every axis, rounding far from the origin must not make it more.
+    glm::ivec3 const first = cell_of(point - pass.radius, cell_size);
+    glm::ivec3 const last = glm::min(cell_of(point + pass.radius, cell_size), first + 1);
+
+    // Different cells may share a bucket, which must not be counted twice.
+    std::array<u32, 8> visited = {};
+    u32 visited_count = 0;
+
+    glm::vec3 power = {};
+
+    for (i32 z = first.z; z <= last.z; ++z)
+    {
+        for (i32 y = first.y; y <= last.y; ++y)
+        {
+            for (i32 x = first.x; x <= last.x; ++x)
+            {
+                u32 const bucket = bucket_of({x, y, z}, bucket_count);
+
+                if (std::find(visited.begin(), visited.begin() + visited_count, bucket) != visited.begin() + visited_count)
+                    continue;
+
+                visited[visited_count++] = bucket;
+
+                for (u32 i = pass.bucket_starts[bucket]; i < pass.bucket_starts[bucket + 1]; ++i)
+                {
+                    Photon const& photon = pass.photons[i];
+                    glm::vec3 const offset = photon.position - point;
+
+                    if (glm::dot(offset, offset) <= radius_squared && glm::dot(photon.direction, normal) < 0.0f)
+                        power += photon.power;
+                }
+            }
+        }
+    }
+
+    // Irradiance over the disc, reflected by a white Lambertian surface.
+    return power / (AK::PI_F * radius_squared) / AK::PI_F;
+}
+
+i32 PhotonMap::pass_count() const
+{
+    return m_settings.pass_count;
+}
+
+std::vector<PhotonMap::Photon> PhotonMap::trace_pass(Raytracer const& raytracer, i32 const thread_count, u64 const seed) const
+{
+    std::vector<PhotonEmitter> emitters = {};
+    std::vector<float> cumulative_weights = {};
+    float total_weight = 0.0f;
+
+    for (auto const& hittable : raytracer.get_hittables())
+    {
+        if (hittable->material == nullptr || !hittable->material->emissive)
+            continue;
+
+        PhotonEmitter emitter = {};
+        emitter.material = hittable->material.get();
+        emitter.quad = dynamic_cast<QuadRaytraced const*>(hittable.get());
+        emitter.sphere = dynamic_cast<SphereRaytraced const*>(hittable.get());
+
+        if (emitter.quad != nullptr)
+        {
+            emitter.area = glm::length(glm::cross(emitter.quad->u(), emitter.quad->v()));
+        }
+        else if (emitter.sphere != nullptr)
+        {
+            emitter.area = 4.0f * AK::PI_F * emitter.sphere->radius() * emitter.sphere->radius();
+        }
+        else
+        {
+            continue;
+        }
+
+        // Picked by their power, judged by the emission at the middle of their texture.
+        glm::vec3 point = {};
+        [[maybe_unused]] bool const is_surface = hittable->surface_point(0.5f, 0.5f, point);
+        float const weight = emitter.area * luminance(emitter.material->emit(0.5f, 0.5f, point));
+
+        if (weight <= 0.0f)
+            continue;
+
+        total_weight += weight;
+        emitters.emplace_back(emitter);
+        cumulative_weights.emplace_back(total_weight);
+    }
+
+    if (emitters.empty())
+        return {};
+
+    // Photons are handed out in chunks, each chunk keeps its own photons so they are merged in the same order every time.
+    i32 constexpr chunk_size = 1024;
+    i32 const chunk_count = (m_settings.photon_count + chunk_size - 1) / chunk_size;
+    float const photon_share = 1.0f / static_cast<float>(m_settings.photon_count);
+    i32 const max_depth = raytracer.get_max_depth();
+
+    std::vector<std::vector<Photon>> chunk_photons(chunk_count);
+    std::atomic<i32> next_chunk = 0;
+
+    auto const trace_chunks = [&] {
+        for (i32 chunk = next_chunk.fetch_add(1); chunk < chunk_count; chunk = next_chunk.fetch_add(1))
+        {
+            u64 hash = AK::HASH_OFFSET_BASIS;
+            AK::hash_bytes(hash, &seed, sizeof(seed));
+            AK::hash_bytes(hash, &chunk, sizeof(chunk));
+            AK::seed_random(hash);
+
+            i32 const end = std::min(m_settings.photon_count, (chunk + 1) * chunk_size);
+
+            for (i32 photon = chunk * chunk_size; photon < end; ++photon)
+            {
+                float const pick = AK::random_float_fast() * total_weight;
+                auto const picked = std::ranges::upper_bound(cumulative_weights, pick);
+                size_t const index = std::min(static_cast<size_t>(picked - cumulative_weights.begin()), emitters.size() - 1);
+                PhotonEmitter const& emitter = emitters[index];
+                float const weight = cumulative_weights[index] - (index > 0 ? cumulative_weights[index - 1] : 0.0f);
+                float const pick_probability = weight / total_weight;
+
+                glm::vec3 point = {};
+                glm::vec3 normal = {};
+                float u = 0.0f;
+                float v = 0.0f;
+                sample_emitter(emitter, point, normal, u, v);
+
+                // Quads emit from both faces, like MaterialCPU::emit() sees them.
+                float side_count = 1.0f;
+
+                if (emitter.quad != nullptr)
+                {
+                    side_count = 2.0f;
+
+                    if (AK::random_float_fast() < 0.5f)
+                        normal = -normal;
+                }
+
+                // Cosine weighted directions, the cosine of the emitted radiance cancels out with the sampling probability.
+                float const flux_scale = emitter.area * AK::PI_F * side_count * photon_share / pick_probability;
+                glm::vec3 power = emitter.material->emit(u, v, point) * flux_scale;
+                glm::vec3 direction = normal + AK::Math::random_unit_vector();
+
+                if (AK::Math::are_nearly_equal(direction, glm::vec3(0.0f, 0.0f, 0.0f)))
+                    direction = normal;
+
+                // Random times average the caustics of moving hittables over the exposure.
+                Ray ray = Ray(point, direction, 0.0f, 0.0f, AK::random_float_fast());
+                bool is_caustic = false;
+
+                for (i32 depth = 0; depth < max_depth; ++depth)
+                {
+                    HitRecord hit_record = {};
+
+                    if (!raytracer.hit(ray, Interval(0.001f, AK::INFINITY_F), hit_record))
+                        break;
+
+                    MaterialCPU const& material = *hit_record.material;
+
+                    if (material.is_diffuse())
+                    {
+                        if (is_caustic)
+                            chunk_photons[chunk].emplace_back(hit_record.point, power, glm::normalize(ray.direction()));
+
+                        break;
+                    }
+
+                    // Glossy bounces and media end the photon, the path tracer takes care of the light they carry.
+                    if (!material.is_specular())
+                        break;
+
+                    glm::vec3 attenuation = {};
+                    Ray scattered = {};
+
+                    if (!material.scatter(ray, hit_record, attenuation, scattered))
+                        break;
+
+                    power *= attenuation;
+                    ray = Ray(scattered.origin(), scattered.direction(), 0.0f, 0.0f, ray.time());
+                    is_caustic = true;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(std::max(0, thread_count - 1));
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(trace_chunks);
+    }
+
+    trace_chunks();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::vector<Photon> photons = {};
+
+    for (auto const& chunk : chunk_photons)
+    {
+        photons.insert(photons.end(), chunk.begin(), chunk.end());
+    }
+
+    return photons;
+}
+
+float PhotonMap::pick_radius(std::vector<Photon> const& photons)
+{
+    if (photons.size() < 2)
+        return 1.0f;
+
+    // Median distance from a few photons to their k-th closest neighbour, so that a disc around a typical photon
+    // holds about target_count of them. Neighbours are searched among a subset, with k scaled down to match.
+    size_t constexpr query_count = 32;
+    size_t constexpr max_subset_size = 20000;
+    float constexpr target_count = 50.0f;
+
+    size_t const subset_stride = std::max<size_t>(1, photons.size() / max_subset_size);
+    size_t const subset_size = (photons.size() + subset_stride - 1) / subset_stride;
+    float const subset_share = static_cast<float>(subset_size) / static_cast<float>(photons.size());
+    size_t const k = std::clamp<size_t>(static_cast<size_t>(target_count * subset_share), 1, subset_size - 1);
+
+    std::vector<float> distances = {};
+    std::vector<float> radii = {};
+
+    for (size_t query = 0; query < query_count; ++query)
+    {
+        glm::vec3 const& position = photons[query * photons.size() / query_count].position;
+
+        distances.clear();
+
+        for (size_t i = 0; i < photons.size(); i += subset_stride)
+        {
+            glm::vec3 const offset = photons[i].position - position;
+            distances.emplace_back(glm::dot(offset, offset));
+        }
+
+        std::ranges::nth_element(distances, distances.begin() + static_cast<i64>(k));
+        radii.emplace_back(glm::sqrt(distances[k]));
+    }
+
+    std::ranges::nth_element(radii, radii.begin() + static_cast<i64>(radii.size() / 2));
+
+    return std::max(radii[radii.size() / 2], 1e-4f);
+}
+
+void PhotonMap::build_grid(Pass& pass)
+{
+    // About two buckets per photon keeps the chains short without a large table.
+    size_t const bucket_count = std::max<size_t>(1, pass.photons.size() * 2);
+    float const cell_size = 2.0f * pass.radius;
+
+    std::vector<u32> buckets(pass.photons.size());
+    pass.bucket_starts.assign(bucket_count + 1, 0);
+
+    for (size_t i = 0; i < pass.photons.size(); ++i)
+    {
+        buckets[i] = bucket_of(cell_of(pass.photons[i].position, cell_size), bucket_count);
+        pass.bucket_starts[buckets[i] + 1] += 1;
+    }
+
+    for (size_t bucket = 0; bucket < bucket_count; ++bucket)
+    {
+        pass.bucket_starts[bucket + 1] += pass.bucket_starts[bucket];
+    }
+
+    // Counting sort, stable so the order of the photons within a bucket stays the same.
+    std::vector<u32> next(pass.bucket_starts.begin(), pass.bucket_starts.end() - 1);
+    std::vector<Photon> sorted(pass.photons.size());
+
+    for (size_t i = 0; i < pass.photons.size(); ++i)
+    {
+        sorted[next[buckets[i]]++] = pass.photons[i];
+    }
+
+    pass.photons = std::move(sorted);
+}
+
+glm::ivec3 PhotonMap::cell_of(glm::vec3 const& point, float const cell_size)
+{
+    // Clamped so points far outside the scene still convert to valid cells.
+    float constexpr max_cell = 1 << 30;
+    return glm::ivec3(glm::clamp(glm::floor(point / cell_size), -max_cell, max_cell));
+}
+
+u32 PhotonMap::bucket_of(glm::ivec3 const& cell, size_t const bucket_count)
+{
+    // Spatial hash of Teschner et al.
+    u32 const hash = (static_cast<u32>(cell.x) * 73856093u) ^ (static_cast<u32>(cell.y) * 19349663u)
+                   ^ (static_cast<u32>(cell.z) * 83492791u);
+
+    return static_cast<u32>(hash % bucket_count);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "AK/Types.h"
+
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <vector>
+
+class Raytracer;
+
+struct PhotonMapSettings
+{
+    // Photons traced from the lights per pass, 0 disables photon mapping.
+    i32 photon_count = 0;
+
+    // Every pass traces new photons with a smaller radius, the samples of a pixel take turns between the passes.
+    i32 pass_count = 1;
+
+    // Gather radius of the first pass in world units, 0 picks one from the spacing of the photons.
+    float radius = 0.0f;
+
+    // Part of the photons kept inside the radius from one pass to the next, between 0 and 1.
+    float alpha = 2.0f / 3.0f;
+};
+
+// Caustics cache for scenes with glass and mirrors. The path tracer only finds light reaching a diffuse surface through
+// specular bounces when a diffuse bounce happens to hit the light through the glass, which converges very slowly for
+// small lights. Photons are traced from the lights instead and stored where they land on a diffuse surface after at least
+// one specular bounce. Diffuse hits of the camera paths estimate the photon density around them, and the path tracer
+// leaves out the light it finds along diffuse, specular, ..., light paths, which the photons already carry.
+//
+// Progressive in the probabilistic form of Knaus and Zwicker: every pass is an independent photon map with the radius
+// shrinking as r(i + 1)^2 = r(i)^2 * (i + alpha) / (i + 1). A single pass is blurred by its radius, the average over the
+// passes converges to the exact caustics. Photons of a pass are bucketed into a hash grid with cells twice the radius
+// wide, so a lookup visits at most 8 cells of contiguous photons.
+//
+// Only quads and spheres registered with the raytracer directly emit photons.
+class PhotonMap
+{
+public:
+    static std::shared_ptr<PhotonMap> create(PhotonMapSettings const& settings);
+
+    explicit PhotonMap(AK::Badge<PhotonMap>, PhotonMapSettings const& settings);
+
+    // Traces the photons of every pass, the BVH of the raytracer has to be built. Chunks of photons are seeded by
+    // their index, so the result does not depend on the thread count.
+    void trace(Raytracer const& raytracer, i32 const thread_count, u64 const seed);
+
+    // Radiance reflected by a white diffuse surface at the point, from the photons of the pass arriving on the side
+    // the normal faces.
+    [[nodiscard]] glm::vec3 estimate(i32 const pass, glm::vec3 const& point, glm::vec3 const& normal) const;
+
+    [[nodiscard]] i32 pass_count() const;
+
+private:
+    struct Photon
+    {
+        glm::vec3 position = {};
+        glm::vec3 power = {};
+
+        // Normalized, towards the surface.
+        glm::vec3 direction = {};
+    };
+
+    struct Pass
+    {
+        float radius = 0.0f;
+
+        // Sorted by bucket, the photons of bucket b are photons[bucket_starts[b]] up to photons[bucket_starts[b + 1]].
+        std::vector<Photon> photons = {};
+        std::vector<u32> bucket_starts = {};
+    };
+
+    [[nodiscard]] std::vector<Photon> trace_pass(Raytracer const& raytracer, i32 const thread_count, u64 const seed) const;
+    [[nodiscard]] static float pick_radius(std::vector<Photon> const& photons);
+    static void build_grid(Pass& pass);
+
+    [[nodiscard]] static glm::ivec3 cell_of(glm::vec3 const& point, float const cell_size);
+    [[nodiscard]] static u32 bucket_of(glm::ivec3 const& cell, size_t const bucket_count);
+
+    PhotonMapSettings m_settings = {};
+    std::vector<Pass> m_passes = {};
+};
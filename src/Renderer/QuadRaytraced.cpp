@@ -1,48 +1,31 @@
 #include "QuadRaytraced.h"
 
-#include "Entity.h"
-#include "Material.h"
+#include "RaytracerStatistics.h"
 
-#include <array>
+#include <cmath>
 
 std::shared_ptr<QuadRaytraced> QuadRaytraced::create(glm::vec3 const& q, glm::vec3 const& u, glm::vec3 const& v,
-                                                     std::shared_ptr<Material> const& material)
+                                                     std::shared_ptr<MaterialCPU> const& material)
 {
     return std::make_shared<QuadRaytraced>(AK::Badge<QuadRaytraced> {}, q, u, v, material);
 }
 
 QuadRaytraced::QuadRaytraced(AK::Badge<QuadRaytraced>, glm::vec3 const& q, glm::vec3 const& u, glm::vec3 const& v,
-                             std::shared_ptr<Material> material)
+                             std::shared_ptr<MaterialCPU> const& material)
     : Hittable(material), m_q(q), m_u(u), m_v(v)
 {
     glm::vec3 const n = glm::cross(u, v);
     m_normal = glm::normalize(n);
     m_d = glm::dot(m_normal, q);
     m_w = n / glm::dot(n, n);
-}
-
-void QuadRaytraced::initialize()
-{
-    Hittable::initialize();
-
-    entity->transform->set_position(m_q);
 
     set_bounding_box();
 }
 
-void QuadRaytraced::update()
-{
-    // FIXME: This is actually not called because can_tick is set to false. When we'll set it to true eventually,
-    // AABB will need to be updated as well.
-    m_q = entity->transform->get_position();
-}
-
-void QuadRaytraced::draw() const
-{
-}
-
 bool QuadRaytraced::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
 {
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::Quad);
+
     float const denominator = glm::dot(m_normal, ray.direction());
 
     // No hit if the ray is parallel to the plane.
@@ -77,6 +60,7 @@ bool QuadRaytraced::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_rec
     hit_record.point = intersection;
     hit_record.material = material;
     hit_record.set_face_normal(ray, m_normal);
+    hit_record.set_uv_footprint(ray, glm::sqrt(glm::length(glm::cross(m_u, m_v))));
 
     return true;
 }
@@ -106,7 +90,7 @@ void QuadRaytraced::set_bounding_box()
 }
 
 std::array<std::shared_ptr<Hittable>, 6> QuadRaytraced::box(glm::vec3 const& a, glm::vec3 const& b,
-                                                            std::shared_ptr<Material> const& material)
+                                                            std::shared_ptr<MaterialCPU> const& material)
 {
     // Construct the two opposite vertices with the minimum and maximum coordinates.
     auto const min = glm::vec3(std::fmin(a.x, b.x), std::fmin(a.y, b.y), std::fmin(a.z, b.z));
@@ -118,23 +102,33 @@ std::array<std::shared_ptr<Hittable>, 6> QuadRaytraced::box(glm::vec3 const& a,
 
     std::array<std::shared_ptr<Hittable>, 6> sides = {};
 
-    auto entity = Entity::create("BoxSide");
-    sides[0] = entity->add_component<QuadRaytraced>(create(glm::vec3(min.x, min.y, max.z), delta_x, delta_y, material)); // Front
-
-    entity = Entity::create("BoxSide");
-    sides[1] = entity->add_component<QuadRaytraced>(create(glm::vec3(max.x, min.y, max.z), -delta_z, delta_y, material)); // Right
+    sides[0] = create(glm::vec3(min.x, min.y, max.z), delta_x, delta_y, material); // Front
+    sides[1] = create(glm::vec3(max.x, min.y, max.z), -delta_z, delta_y, material); // Right
+    sides[2] = create(glm::vec3(max.x, min.y, min.z), -delta_x, delta_y, material); // Back
+    sides[3] = create(glm::vec3(min.x, min.y, min.z), delta_z, delta_y, material); // Left
+    sides[4] = create(glm::vec3(min.x, max.y, max.z), delta_x, -delta_z, material); // Top
+    sides[5] = create(glm::vec3(min.x, min.y, min.z), delta_x, delta_z, material); // Bottom
 
-    entity = Entity::create("BoxSide");
-    sides[2] = entity->add_component<QuadRaytraced>(create(glm::vec3(max.x, min.y, min.z), -delta_x, delta_y, material)); // Back
+    return sides;
+}
 
-    entity = Entity::create("BoxSide");
-    sides[3] = entity->add_component<QuadRaytraced>(create(glm::vec3(min.x, min.y, min.z), delta_z, delta_y, material)); // Left
+bool QuadRaytraced::surface_point(float const u, float const v, glm::vec3& point) const
+{
+    point = m_q + u * m_u + v * m_v;
+    return true;
+}
 
-    entity = Entity::create("BoxSide");
-    sides[4] = entity->add_component<QuadRaytraced>(create(glm::vec3(min.x, max.y, max.z), delta_x, -delta_z, material)); // Top
+glm::vec3 QuadRaytraced::q() const
+{
+    return m_q;
+}
 
-    entity = Entity::create("BoxSide");
-    sides[5] = entity->add_component<QuadRaytraced>(create(glm::vec3(min.x, min.y, min.z), delta_x, delta_z, material)); // Bottom
+glm::vec3 QuadRaytraced::u() const
+{
+    return m_u;
+}
 
-    return sides;
+glm::vec3 QuadRaytraced::v() const
+{
+    return m_v;
 }
@@ -3,21 +3,26 @@
 #include "AK/Badge.h"
 #include "Hittable.h"
 
+#include <array>
+
 class QuadRaytraced final : public Hittable
 {
 public:
     static std::shared_ptr<QuadRaytraced> create(glm::vec3 const& q, glm::vec3 const& u, glm::vec3 const& v,
-                                                 std::shared_ptr<Material> const& material);
-
-    QuadRaytraced(AK::Badge<QuadRaytraced>, glm::vec3 const& q, glm::vec3 const& u, glm::vec3 const& v, std::shared_ptr<Material> material);
+                                                 std::shared_ptr<MaterialCPU> const& material);
 
-    virtual void initialize() override;
-    virtual void update() override;
-    virtual void draw() const override;
+    QuadRaytraced(AK::Badge<QuadRaytraced>, glm::vec3 const& q, glm::vec3 const& u, glm::vec3 const& v,
+                  std::shared_ptr<MaterialCPU> const& material);
 
     virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual bool surface_point(float const u, float const v, glm::vec3& point) const override;
+
+    static std::array<std::shared_ptr<Hittable>, 6> box(glm::vec3 const& a, glm::vec3 const& b,
+                                                        std::shared_ptr<MaterialCPU> const& material);
 
-    static std::array<std::shared_ptr<Hittable>, 6> box(glm::vec3 const& a, glm::vec3 const& b, std::shared_ptr<Material> const& material);
+    [[nodiscard]] glm::vec3 q() const;
+    [[nodiscard]] glm::vec3 u() const;
+    [[nodiscard]] glm::vec3 v() const;
 
 private:
     static bool is_interior(float const a, float const b, HitRecord& hit_record);
@@ -1,9 +1,16 @@
 #include "Ray.h"
 
+#include <glm/geometric.hpp>
+
 Ray::Ray(glm::vec3 const& origin, glm::vec3 const& direction) : m_origin(origin), m_direction(direction)
 {
 }
 
+Ray::Ray(glm::vec3 const& origin, glm::vec3 const& direction, float const cone_width, float const cone_spread, float const time)
+    : m_origin(origin), m_direction(direction), m_cone_width(cone_width), m_cone_spread(cone_spread), m_time(time)
+{
+}
+
 glm::vec3 const& Ray::origin() const
 {
     return m_origin;
@@ -18,3 +25,34 @@ glm::vec3 Ray::at(float const t) const
 {
     return m_origin + t * m_direction;
 }
+
+float Ray::cone_width() const
+{
+    return m_cone_width;
+}
+
+float Ray::cone_spread() const
+{
+    return m_cone_spread;
+}
+
+float Ray::cone_width_at(float const t) const
+{
+    // Directions are not normalized, t is measured in direction lengths.
+    return m_cone_width + m_cone_spread * t * glm::length(m_direction);
+}
+
+float Ray::time() const
+{
+    return m_time;
+}
+
+bool Ray::is_shadow() const
+{
+    return m_is_shadow;
+}
+
+void Ray::set_shadow(bool const is_shadow)
+{
+    m_is_shadow = is_shadow;
+}
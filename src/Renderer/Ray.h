@@ -9,12 +9,35 @@ public:
 
     Ray(glm::vec3 const& origin, glm::vec3 const& direction);
 
+    // Ray with a cone around it, used to estimate how large an area of a surface a hit stands for.
+    // The cone is cone_width wide at the origin and widens by cone_spread for every world unit travelled.
+    // time is the moment of the exposure the ray belongs to, 0 when the shutter opens and 1 when it closes.
+    Ray(glm::vec3 const& origin, glm::vec3 const& direction, float const cone_width, float const cone_spread, float const time = 0.0f);
+
     [[nodiscard]] glm::vec3 const& origin() const;
     [[nodiscard]] glm::vec3 const& direction() const;
 
     [[nodiscard]] glm::vec3 at(float const t) const;
 
+    [[nodiscard]] float cone_width() const;
+    [[nodiscard]] float cone_spread() const;
+    [[nodiscard]] float cone_width_at(float const t) const;
+
+    [[nodiscard]] float time() const;
+
+    // Shadow rays only look for surfaces that block the light. Media let them through and attenuate them
+    // with Hittable::transmittance() instead.
+    [[nodiscard]] bool is_shadow() const;
+    void set_shadow(bool const is_shadow);
+
 private:
     glm::vec3 m_origin = {};
     glm::vec3 m_direction = {};
+
+    float m_cone_width = 0.0f;
+    float m_cone_spread = 0.0f;
+
+    float m_time = 0.0f;
+
+    bool m_is_shadow = false;
 };
@@ -3,26 +3,57 @@
 #include "AK/AK.h"
 #include "AK/Math.h"
 #include "AK/Types.h"
-#include "BVHNode.h"
-#include "Camera.h"
+#include "BVH.h"
+#include "BVHCache.h"
+#include "ConstantDensityMedium.h"
+#include "EnvironmentLight.h"
+#include "HeterogeneousMedium.h"
+#include "MaterialCPU.h"
 #include "Ray.h"
+#include "RaytracerSerialization.h"
+#include "RaytracerStatistics.h"
+#include "RenderCheckpoint.h"
+#include "RotateYHittable.h"
+#include "TextureCPU.h"
+#include "TextureProgram.h"
+#include "TranslateHittable.h"
 
-#include <glm/gtc/random.hpp>
 #include <glm/gtx/norm.hpp>
 #include <glm/vec3.hpp>
 
-#include <execution>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+// Every row gets its own random sequence, so it renders the same no matter which thread picks it up
+// or whether the render was resumed from a checkpoint.
+static u64 row_seed(u64 const seed, i32 const row)
+{
+    u64 hash = AK::HASH_OFFSET_BASIS;
+    AK::hash_bytes(hash, &seed, sizeof(seed));
+    AK::hash_bytes(hash, &row, sizeof(row));
+
+    return hash;
+}
 
-std::shared_ptr<Raytracer> Raytracer::create()
+std::shared_ptr<Raytracer> Raytracer::create(bool const is_instance)
 {
     auto raytracer = std::make_shared<Raytracer>(AK::Badge<Raytracer> {});
 
+    if (!is_instance)
+        return raytracer;
+
     if (!m_instance.expired())
     {
-        Debug::log("Instance of Raytracer already exists in the scene.", DebugType::Error);
+        std::cout << "Instance of Raytracer already exists in the scene.\n";
     }
 
     m_instance = raytracer;
@@ -46,6 +77,11 @@ void Raytracer::register_hittable(std::shared_ptr<Hittable> const& hittable)
 {
     m_hittables.emplace_back(hittable);
 
+    // Rebuilt by the next initialize().
+    m_bvh = nullptr;
+    m_baked_texture_resolution = 0;
+    m_photon_map = nullptr;
+
     // Resize bounding box
     m_bbox = AABB(m_bbox, hittable->bounding_box());
 }
@@ -54,61 +90,460 @@ void Raytracer::unregister_hittable(std::shared_ptr<Hittable> const& hittable)
 {
     AK::swap_and_erase(m_hittables, hittable);
 
+    // The BVH does not own the hittables.
+    m_bvh = nullptr;
+    m_baked_texture_resolution = 0;
+
     // FIXME: Make bounding box smaller?
 }
 
-void Raytracer::render(std::shared_ptr<Camera> const& camera)
+std::vector<std::shared_ptr<Hittable>> const& Raytracer::get_hittables() const
+{
+    return m_hittables;
+}
+
+void Raytracer::reset_framebuffer()
+{
+    m_framebuffer = Framebuffer::create(m_image_width, m_image_height, m_enabled_aovs);
+
+#if RAYTRACER_STATISTICS
+    RaytracerStatistics::reset();
+    RaytracerStatistics::begin_heatmap(m_image_width, m_image_height);
+#endif
+}
+
+void Raytracer::render_row(i32 const row, std::span<u32 const> const pixel_samples)
+{
+    AK::seed_random(row_seed(m_seed, row));
+
+    i32 const index = row * m_image_width;
+
+    for (i32 i = 0; i < m_image_width; ++i)
+    {
+        u32 const sample_count = pixel_samples.empty() ? static_cast<u32>(m_samples_per_pixel) : pixel_samples[index + i];
+
+        for (u32 sample = 0; sample < sample_count; ++sample)
+        {
+            render_sample(i, row, sample);
+        }
+    }
+}
+
+void Raytracer::render_pass_row(i32 const row, u64 const pass_seed, u32 const first_sample, u32 const sample_count)
+{
+    AK::seed_random(row_seed(pass_seed, row));
+
+    for (i32 i = 0; i < m_image_width; ++i)
+    {
+        for (u32 sample = first_sample; sample < first_sample + sample_count; ++sample)
+        {
+            render_sample(i, row, sample);
+        }
+    }
+}
+
+void Raytracer::render_sample(i32 const i, i32 const row, u32 const sample)
+{
+    i32 const index = row * m_image_width + i;
+
+    u32 const stratum = m_active_primary_hit_strata > 0 ? sample % static_cast<u32>(m_active_primary_hit_strata) : 0;
+    Ray ray = m_active_primary_hit_strata > 0 ? get_stratum_ray(i, row, stratum) : get_ray(i, row);
+
+    AOVSample aov_sample = {};
+    u32 const visited_nodes_before = BVH::visited_nodes;
+
+#if RAYTRACER_STATISTICS
+    RaytracerCounters const& counters = RaytracerStatistics::thread_counters();
+    u64 const tests_before = counters.bvh_nodes_visited + counters.total_primitive_tests();
+#endif
+
+    // Samples of a pixel take turns between the passes of the photon map, so their average converges.
+    i32 const photon_pass = m_photon_map != nullptr ? static_cast<i32>(sample % static_cast<u32>(m_photon_map->pass_count())) : 0;
+
+    HitRecord primary_hit = {};
+    bool const is_primary_hit_known = m_active_primary_hit_strata > 0 && get_primary_hit(index, stratum, ray, primary_hit);
+
+    aov_sample.color = ray_color(ray, m_max_depth, photon_pass, aov_sample, is_primary_hit_known ? &primary_hit : nullptr);
+
+    // Every stratum of the pixel was traced once by now.
+    if (m_active_primary_hit_strata > 0 && stratum + 1 == static_cast<u32>(m_active_primary_hit_strata))
+        cache_primary_textures(index);
+    aov_sample.traversal_cost = static_cast<float>(BVH::visited_nodes - visited_nodes_before);
+
+#if RAYTRACER_STATISTICS
+    u64 const tests_after = counters.bvh_nodes_visited + counters.total_primitive_tests();
+    RaytracerStatistics::add_heatmap_cost(index, static_cast<float>(tests_after - tests_before));
+#endif
+
+    m_framebuffer->accumulate(index, aov_sample);
+}
+
+void Raytracer::save_framebuffer() const
+{
+    m_framebuffer->save(m_output_directory, m_output_file, m_output_format);
+}
+
+void Raytracer::save_render([[maybe_unused]] double const render_time) const
+{
+    save_framebuffer();
+
+#if RAYTRACER_STATISTICS
+    std::filesystem::path const heatmap_stem = std::filesystem::path(m_output_directory) / std::filesystem::path(m_output_file).stem();
+    std::string const heatmap_path = heatmap_stem.string() + "_heatmap.ppm";
+
+    RaytracerStatistics::print_summary(render_time);
+    RaytracerStatistics::write_heatmap(heatmap_path, *m_framebuffer);
+#endif
+}
+
+void Raytracer::render_rows(std::span<u32 const> const pixel_samples)
+{
+    std::atomic<i32> next_scanline = 0;
+
+    auto const render_scanlines = [&] {
+        for (i32 k = next_scanline.fetch_add(1); k < m_image_height; k = next_scanline.fetch_add(1))
+        {
+            render_row(k, pixel_samples);
+        }
+    };
+
+    i32 const thread_count = get_resolved_thread_count();
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(thread_count - 1);
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(render_scanlines);
+    }
+
+    render_scanlines();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void Raytracer::set_framebuffer(std::shared_ptr<Framebuffer> const& framebuffer)
+{
+    m_framebuffer = framebuffer;
+}
+
+void Raytracer::refit_bvh()
+{
+    // Not built yet, the next initialize() builds it around the new positions anyway.
+    if (m_bvh == nullptr)
+        return;
+
+    m_bvh->refit(&m_scratch_arena);
+    m_scratch_arena.reset();
+
+    m_bbox = AABB::empty;
+
+    for (auto const& hittable : m_hittables)
+    {
+        m_bbox = AABB(m_bbox, hittable->bounding_box());
+    }
+
+    // Volume bakes cover the bounds of the hittables using them, those may have moved out of the grid.
+    m_baked_texture_resolution = 0;
+    m_primary_hits.clear();
+}
+
+bool Raytracer::render()
 {
-    std::filesystem::path const directory = output_directory;
+    if (m_render_budget.mode != RenderBudgetMode::Samples)
+        return render_passes();
 
-    if (!std::filesystem::exists(directory))
+    reset_framebuffer();
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    bool const is_checkpointing = !m_checkpoint_path.empty();
+    u64 const scene_hash = is_checkpointing ? compute_scene_hash() : 0;
+
+    // Written by the worker that finishes a row, read when a checkpoint is taken. Rows marked as finished are not
+    // touched anymore, so a checkpoint can copy them while the other rows are still being rendered.
+    std::vector<std::atomic<bool>> finished_rows(m_image_height);
+    m_finished_row_count.store(0, std::memory_order_relaxed);
+
+    if (is_checkpointing && m_resume)
     {
-        std::filesystem::create_directory(directory);
+        std::vector<i32> const resumed_rows = RenderCheckpoint::read(m_checkpoint_path, scene_hash, *m_framebuffer);
+
+        for (i32 const row : resumed_rows)
+        {
+            finished_rows[row].store(true, std::memory_order_relaxed);
+        }
+
+        std::clog << "Resuming from " << m_checkpoint_path << ": " << resumed_rows.size() << " of " << m_image_height << " rows done\n";
+        m_finished_row_count.store(static_cast<i32>(resumed_rows.size()), std::memory_order_relaxed);
     }
 
-    m_camera_position_this_frame = m_camera->get_position();
+    std::mutex checkpoint_mutex = {};
+    auto last_checkpoint_time = start_time;
 
-    std::vector<std::string> scanlines = {};
-    scanlines.resize(m_image_height * m_image_width);
+    auto const write_checkpoint = [&] {
+        std::vector<i32> rows = {};
 
-    auto range = std::views::iota(0, m_image_height);
-    std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](size_t const k) {
-        std::clog << "Scanline: " << (m_image_height - k) << '\n';
+        for (i32 k = 0; k < m_image_height; ++k)
+        {
+            if (finished_rows[k].load(std::memory_order_acquire))
+                rows.emplace_back(k);
+        }
 
-        i32 const index = static_cast<i32>(k) * m_image_width;
+        [[maybe_unused]] bool const is_written = RenderCheckpoint::write(m_checkpoint_path, scene_hash, *m_framebuffer, rows);
+    };
 
-        for (size_t i = 0; i < m_image_width; ++i)
+    // Scanlines are handed out to the workers one by one, so threads that got cheap rows pick up more of them.
+    // NOTE: The traversal cost AOV reads a thread local counter around each sample, so every sample has to stay on one thread.
+    std::atomic<i32> next_scanline = 0;
+
+    auto const render_scanlines = [&] {
+        for (i32 k = next_scanline.fetch_add(1); k < m_image_height; k = next_scanline.fetch_add(1))
         {
-            glm::vec3 pixel_color = {0.0f, 0.0f, 0.0f};
+            if (is_cancelled())
+                return;
+
+            if (finished_rows[k].load(std::memory_order_relaxed))
+                continue;
 
-            for (i32 sample = 0; sample < m_samples_per_pixel; ++sample)
+            std::clog << "Scanline: " << (m_image_height - k) << '\n';
+
+            render_row(k);
+
+            finished_rows[k].store(true, std::memory_order_release);
+            m_finished_row_count.fetch_add(1, std::memory_order_relaxed);
+
+            // Whoever finishes a row after the interval writes the checkpoint, the others carry on rendering.
+            if (is_checkpointing && checkpoint_mutex.try_lock())
             {
-                Ray ray = get_ray(static_cast<i32>(i), static_cast<i32>(k));
-                pixel_color += ray_color(ray, m_max_depth);
-            }
+                std::lock_guard const lock(checkpoint_mutex, std::adopt_lock);
+                auto const now = std::chrono::steady_clock::now();
 
-            glm::ivec3 const color_byte = AK::color_to_byte(pixel_color * m_pixel_samples_scale);
-            scanlines[index + i] =
-                std::to_string(color_byte.r) + ' ' + std::to_string(color_byte.g) + ' ' + std::to_string(color_byte.b) + '\n';
+                if (std::chrono::duration<double>(now - last_checkpoint_time).count() >= m_checkpoint_interval)
+                {
+                    write_checkpoint();
+                    last_checkpoint_time = now;
+                }
+            }
         }
-    });
+    };
+
+    i32 const thread_count = get_resolved_thread_count();
+
+    std::vector<std::thread> workers = {};
+    workers.reserve(thread_count - 1);
+
+    for (i32 i = 1; i < thread_count; ++i)
+    {
+        workers.emplace_back(render_scanlines);
+    }
+
+    render_scanlines();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time;
+
+    // Unfinished rows are left out of the image, the checkpoint keeps the finished ones for a later resume.
+    if (is_cancelled())
+    {
+        if (is_checkpointing)
+            write_checkpoint();
+
+        std::clog << "Render cancelled after " << render_time.count() << " s\n";
+        return false;
+    }
+
+    save_render(render_time.count());
 
-    std::ofstream output(output_directory + output_file);
+    if (is_checkpointing)
+        RenderCheckpoint::remove(m_checkpoint_path);
 
-    output << "P3\n" << m_image_width << ' ' << m_image_height << "\n255\n";
+    m_render_report = {static_cast<double>(m_samples_per_pixel), render_time.count(), m_framebuffer->estimate_error(),
+                       RenderBudgetMode::Samples};
 
-    for (auto const& line : scanlines)
+    std::clog << "\rDone.                 \n";
+    std::clog << "Render time: " << render_time.count() << " s (" << thread_count << " threads)\n";
+    std::clog << "Samples per pixel: " << m_render_report.samples_per_pixel << ", estimated error: " << m_render_report.estimated_error
+              << "\n";
+
+    return true;
+}
+
+bool Raytracer::render_passes()
+{
+    reset_framebuffer();
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    if (!m_checkpoint_path.empty())
+        std::clog << "Checkpoints are not written for renders with a time or error budget\n";
+
+    m_finished_row_count.store(0, std::memory_order_relaxed);
+
+    bool const has_deadline = m_render_budget.seconds > 0.0;
+    auto const deadline = start_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                           std::chrono::duration<double>(std::max(0.0, m_render_budget.seconds)));
+
+    // The first pass gives every pixel enough samples for a variance. Later ones grow with the samples taken so far, so
+    // checking the budget costs little, but not so much that a pass overshoots the error target by far.
+    u32 constexpr first_pass_samples = 2;
+    u32 constexpr max_pass_samples = 64;
+
+    u32 const max_samples = std::max(m_render_budget.max_samples_per_pixel, 1u);
+
+    u32 sample_count = 0;
+    float error = std::numeric_limits<float>::infinity();
+    RenderBudgetMode stopped_by = RenderBudgetMode::Samples;
+
+    i32 const thread_count = get_resolved_thread_count();
+
+    for (i32 pass = 0;; ++pass)
     {
-        output << line;
+        u32 pass_samples = pass == 0 ? first_pass_samples : std::clamp(sample_count / 2, 1u, max_pass_samples);
+        pass_samples = std::min(pass_samples, max_samples - sample_count);
+
+        double const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+
+        // The error falls with the square root of the samples, which predicts how many are still missing. An error
+        // that is infinite or NaN predicts nothing and keeps the pass as it is.
+        if (pass > 0 && m_render_budget.mode == RenderBudgetMode::Error)
+        {
+            double const ratio = static_cast<double>(error) / static_cast<double>(m_render_budget.target_error);
+            double const missing = std::ceil(static_cast<double>(sample_count) * (ratio * ratio - 1.0));
+
+            if (missing < static_cast<double>(pass_samples))
+                pass_samples = static_cast<u32>(std::max(missing, 1.0));
+        }
+
+        // A pass that would not fit into the remaining time is shortened, so all rows get the same samples.
+        if (pass > 0 && has_deadline)
+        {
+            double const seconds_per_sample = elapsed / static_cast<double>(sample_count);
+            double const remaining_samples = std::floor((m_render_budget.seconds - elapsed) / seconds_per_sample);
+
+            pass_samples = static_cast<u32>(std::clamp(remaining_samples, 1.0, static_cast<double>(pass_samples)));
+        }
+
+        // The time limit may cut the pass off after some rows, those are put back to how they were before it.
+        std::shared_ptr<Framebuffer> const previous_framebuffer = pass > 0 && has_deadline ? m_framebuffer->clone() : nullptr;
+
+        u64 pass_seed = AK::HASH_OFFSET_BASIS;
+        AK::hash_bytes(pass_seed, &m_seed, sizeof(m_seed));
+        AK::hash_bytes(pass_seed, &pass, sizeof(pass));
+
+        m_finished_row_count.store(0, std::memory_order_relaxed);
+        std::atomic<i32> next_scanline = 0;
+
+        auto const render_scanlines = [&] {
+            for (i32 k = next_scanline.fetch_add(1); k < m_image_height; k = next_scanline.fetch_add(1))
+            {
+                if (is_cancelled() || (pass > 0 && has_deadline && std::chrono::steady_clock::now() >= deadline))
+                    return;
+
+                render_pass_row(k, pass_seed, sample_count, pass_samples);
+                m_finished_row_count.fetch_add(1, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> workers = {};
+        workers.reserve(thread_count - 1);
+
+        for (i32 i = 1; i < thread_count; ++i)
+        {
+            workers.emplace_back(render_scanlines);
+        }
+
+        render_scanlines();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        if (is_cancelled())
+        {
+            std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time;
+            std::clog << "Render cancelled after " << render_time.count() << " s\n";
+            return false;
+        }
+
+        // Rows the pass reached would have more samples than the others and show up as bands of less noise.
+        if (m_finished_row_count.load(std::memory_order_relaxed) < m_image_height)
+        {
+            m_framebuffer = previous_framebuffer;
+            stopped_by = RenderBudgetMode::Time;
+            break;
+        }
+
+        sample_count += pass_samples;
+        error = m_framebuffer->estimate_error();
+
+        std::clog << "Pass " << pass << ": " << sample_count << " spp, estimated error " << error << "\n";
+
+        if (m_render_budget.mode == RenderBudgetMode::Error && error <= m_render_budget.target_error)
+        {
+            stopped_by = RenderBudgetMode::Error;
+            break;
+        }
+
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline)
+        {
+            stopped_by = RenderBudgetMode::Time;
+            break;
+        }
+
+        if (sample_count >= max_samples)
+        {
+            std::clog << "Stopped at the limit of " << max_samples << " samples per pixel\n";
+            break;
+        }
     }
 
+    std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time;
+
+    save_render(render_time.count());
+
+    m_render_report = {static_cast<double>(sample_count), render_time.count(), m_framebuffer->estimate_error(), stopped_by};
+
     std::clog << "\rDone.                 \n";
-    output.close();
+    std::clog << "Render time: " << render_time.count() << " s (" << thread_count << " threads)\n";
+    std::clog << "Samples per pixel: " << m_render_report.samples_per_pixel << ", estimated error: " << m_render_report.estimated_error
+              << "\n";
+
+    return true;
 }
 
 void Raytracer::clear()
 {
     m_hittables.clear();
+    m_media.clear();
+    m_bbox = {glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f)};
+    m_bvh = nullptr;
+    m_baked_texture_resolution = 0;
+    m_photon_map = nullptr;
+    m_path_guide = nullptr;
+    m_environment = nullptr;
+    m_primary_hits.clear();
+
+    m_scene_arena.reset();
+    m_scratch_arena.reset();
+}
+
+void Raytracer::set_camera(RaytracerCamera const& camera)
+{
+    m_camera = camera;
+}
+
+RaytracerCamera const& Raytracer::get_camera() const
+{
+    return m_camera;
 }
 
 void Raytracer::set_aspect_ratio(float const aspect_ratio)
@@ -136,95 +571,996 @@ void Raytracer::set_background_color(glm::vec3 const& background_color)
     m_background_color = background_color;
 }
 
-Ray Raytracer::get_ray(i32 const i, i32 const k) const
+void Raytracer::set_environment(std::shared_ptr<EnvironmentLight> const& environment)
 {
-    // Construct a camera ray originating from the origin and directed at randomly sampled
-    // point around the pixel location i, k.
+    m_environment = environment;
+}
 
-    glm::vec3 const offset = sample_square();
-    glm::vec3 const pixel_sample = m_pixel00_location + ((static_cast<float>(i) + offset.x) * m_pixel_delta_u)
-                                 + ((static_cast<float>(k) + offset.y) * m_pixel_delta_v);
+void Raytracer::set_render_budget(RenderBudget const& budget)
+{
+    m_render_budget = budget;
+}
 
-    glm::vec3 const ray_direction = pixel_sample - m_camera_position_this_frame;
+RenderBudget const& Raytracer::get_render_budget() const
+{
+    return m_render_budget;
+}
 
-    return {m_camera_position_this_frame, ray_direction};
+RenderReport const& Raytracer::get_render_report() const
+{
+    return m_render_report;
 }
 
-void Raytracer::initialize(std::shared_ptr<Camera> const& camera)
+void Raytracer::set_thread_count(i32 const thread_count)
 {
-    m_camera = camera;
+    m_thread_count = thread_count;
+}
 
-    m_pixel_samples_scale = 1.0f / static_cast<float>(m_samples_per_pixel);
+void Raytracer::set_output_path(std::string const& path)
+{
+    std::filesystem::path const output_path = path;
 
-    // Calculate the image height, and ensure that it's at least 1.
-    m_image_height = static_cast<i32>(static_cast<float>(m_image_width) / m_aspect_ratio);
-    m_image_height = (m_image_height < 1) ? 1 : m_image_height;
+    m_output_directory = output_path.has_parent_path() ? output_path.parent_path().string() : ".";
+    m_output_file = output_path.filename().string();
 
-    // Determine viewport dimensions.
-    float const focal_length = 3.47f;
-    float const theta = m_camera->fov;
-    float const h = glm::tan(theta / 2.0f);
-    float const viewport_height = 2.0f * h * focal_length;
-    float const viewport_width = viewport_height * (static_cast<float>(m_image_width) / static_cast<float>(m_image_height));
+    if (output_path.extension() == ".pfm")
+    {
+        m_output_format = FramebufferFormat::PFM;
+    }
+    else if (output_path.extension() == ".ppm")
+    {
+        m_output_format = FramebufferFormat::PPM;
+    }
+}
 
-    // Calculate the vectors across the horizontal and down the vertical viewport edges.
-    glm::vec3 const viewport_u = viewport_width * -m_camera->get_right();
-    glm::vec3 const viewport_v = viewport_height * -m_camera->get_up();
+void Raytracer::set_bvh_cache_directory(std::string const& directory)
+{
+    m_bvh_cache_directory = directory;
+}
 
-    // Calculate the horizontal and vertical delta vectors from pixel to pixel.
-    m_pixel_delta_u = viewport_u / static_cast<float>(m_image_width);
-    m_pixel_delta_v = viewport_v / static_cast<float>(m_image_height);
+void Raytracer::set_texture_bake_resolution(i32 const resolution)
+{
+    m_texture_bake_resolution = resolution;
+}
 
-    // Calculate the location of the upper left pixel.
-    glm::vec3 const viewport_upper_left =
-        m_camera->get_position() - focal_length * m_camera->get_front() - viewport_u / 2.0f - viewport_v / 2.0f;
-    m_pixel00_location = viewport_upper_left + 0.5f * (m_pixel_delta_u + m_pixel_delta_v);
+void Raytracer::set_primary_hit_cache(i32 const strata)
+{
+    m_primary_hit_strata = strata;
+}
 
-    m_root = std::make_shared<BVHNode>(m_hittables, 0, m_hittables.size());
+void Raytracer::set_photon_map_settings(PhotonMapSettings const& settings)
+{
+    m_photon_map_settings = settings;
 }
 
-bool Raytracer::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+void Raytracer::set_path_guide_settings(PathGuideSettings const& settings)
 {
-    HitRecord temp_record = {};
-    bool hit_anything = false;
+    m_path_guide_settings = settings;
+}
 
-    if (m_root->hit(ray, Interval(ray_t.min, ray_t.max), temp_record))
-    {
-        hit_anything = true;
-        hit_record = temp_record;
-    }
+void Raytracer::set_seed(u64 const seed)
+{
+    m_seed = seed;
+}
 
-    return hit_anything;
+u64 Raytracer::get_seed() const
+{
+    return m_seed;
 }
 
-glm::vec3 Raytracer::ray_color(Ray const& ray, i32 const depth) const
+void Raytracer::set_checkpoint(std::string const& path, double const interval_seconds)
 {
-    // If we've exceeded the ray bounce limit, no more light is gathered.
-    if (depth <= 0)
-        return {0.0f, 0.0f, 0.0f};
+    m_checkpoint_path = path;
+    m_checkpoint_interval = interval_seconds;
+}
 
-    HitRecord hit_record = {};
+void Raytracer::set_resume(bool const resume)
+{
+    m_resume = resume;
+}
 
-    // If the ray hits nothing, return the background color.
-    if (!hit(ray, Interval(0.001f, AK::INFINITY_F), hit_record))
-    {
-        return m_background_color;
-    }
+void Raytracer::set_cancel_flag(std::atomic<bool> const* cancel_flag)
+{
+    m_cancel_flag = cancel_flag;
+}
+
+i32 Raytracer::get_finished_row_count() const
+{
+    return m_finished_row_count.load(std::memory_order_relaxed);
+}
+
+float Raytracer::get_aspect_ratio() const
+{
+    return m_aspect_ratio;
+}
 
-    Ray scattered;
-    glm::vec3 attenuation;
-    glm::vec3 const emitted_color = hit_record.material->emit(hit_record.u, hit_record.v, hit_record.point);
+i32 Raytracer::get_image_width() const
+{
+    return m_image_width;
+}
+
+i32 Raytracer::get_image_height() const
+{
+    return m_image_height;
+}
 
-    if (!hit_record.material->scatter(ray, hit_record, attenuation, scattered))
-        return emitted_color;
+i32 Raytracer::get_samples_per_pixel() const
+{
+    return m_samples_per_pixel;
+}
 
-    glm::vec3 const scattered_color = attenuation * ray_color(scattered, depth - 1);
+i32 Raytracer::get_max_depth() const
+{
+    return m_max_depth;
+}
 
-    return emitted_color + scattered_color;
+glm::vec3 Raytracer::get_background_color() const
+{
+    return m_background_color;
 }
 
-glm::vec3 Raytracer::sample_square() const
+std::shared_ptr<EnvironmentLight> const& Raytracer::get_environment() const
 {
-    // Returns the vector to a random point in the [-0.5, -0.5]-[+0.5, +0.5] unit square.
-    return {glm::linearRand(0.0f, 1.0f) - 0.5f, glm::linearRand(0.0f, 1.0f) - 0.5f, 0.0f};
+    return m_environment;
+}
+
+void Raytracer::set_enabled_aovs(u32 const enabled_aovs)
+{
+    m_enabled_aovs = enabled_aovs | Framebuffer::aov_bit(AOVType::Beauty);
+}
+
+void Raytracer::enable_aov(AOVType const type)
+{
+    m_enabled_aovs |= Framebuffer::aov_bit(type);
+}
+
+void Raytracer::set_output_format(FramebufferFormat const output_format)
+{
+    m_output_format = output_format;
+}
+
+std::shared_ptr<Framebuffer> Raytracer::get_framebuffer() const
+{
+    return m_framebuffer;
+}
+
+AK::Arena const& Raytracer::get_scene_arena() const
+{
+    return m_scene_arena;
+}
+
+AK::Arena const& Raytracer::get_scratch_arena() const
+{
+    return m_scratch_arena;
+}
+
+Ray Raytracer::get_ray(i32 const i, i32 const k) const
+{
+    // Construct a camera ray originating from the origin and directed at randomly sampled
+    // point around the pixel location i, k.
+
+    glm::vec3 const offset = sample_square();
+    glm::vec3 const pixel_sample = m_pixel00_location + ((static_cast<float>(i) + offset.x) * m_pixel_delta_u)
+                                 + ((static_cast<float>(k) + offset.y) * m_pixel_delta_v);
+
+    // Rays start from a random point of the lens and pass through the pixel sample on the plane in focus,
+    // so only geometry near that plane stays sharp.
+    glm::vec3 ray_origin = m_camera.position;
+
+    if (m_camera.aperture > 0.0f)
+    {
+        glm::vec3 const lens_sample = sample_disk();
+        ray_origin += lens_sample.x * m_lens_u + lens_sample.y * m_lens_v;
+    }
+
+    glm::vec3 const ray_direction = pixel_sample - ray_origin;
+
+    // Static scenes look the same at any time, they skip the random number.
+    float const time = m_bvh->has_motion() ? AK::random_float_fast() : 0.0f;
+
+    return {ray_origin, ray_direction, 0.0f, m_pixel_cone_spread, time};
+}
+
+Ray Raytracer::get_pixel_center_ray(i32 const i, i32 const k) const
+{
+    glm::vec3 const pixel_center = m_pixel00_location + static_cast<float>(i) * m_pixel_delta_u + static_cast<float>(k) * m_pixel_delta_v;
+
+    return {m_camera.position, pixel_center - m_camera.position, 0.0f, m_pixel_cone_spread};
+}
+
+Ray Raytracer::get_stratum_ray(i32 const i, i32 const k, u32 const stratum) const
+{
+    // The strata follow the R2 sequence, which spreads any number of points evenly over the pixel. Every pixel shifts
+    // them by its own hashed offset, so the same pattern does not repeat across the image.
+    float constexpr r2_x = 0.7548776662f;
+    float constexpr r2_y = 0.5698402910f;
+
+    u64 hash = AK::HASH_OFFSET_BASIS;
+    AK::hash_bytes(hash, &i, sizeof(i));
+    AK::hash_bytes(hash, &k, sizeof(k));
+
+    float const shift_x = static_cast<float>(hash & 0xffffff) / 16777216.0f;
+    float const shift_y = static_cast<float>((hash >> 24) & 0xffffff) / 16777216.0f;
+    float const x = glm::fract(shift_x + r2_x * static_cast<float>(stratum)) - 0.5f;
+    float const y = glm::fract(shift_y + r2_y * static_cast<float>(stratum)) - 0.5f;
+
+    glm::vec3 const pixel_sample =
+        m_pixel00_location + ((static_cast<float>(i) + x) * m_pixel_delta_u) + ((static_cast<float>(k) + y) * m_pixel_delta_v);
+
+    return {m_camera.position, pixel_sample - m_camera.position, 0.0f, m_pixel_cone_spread};
+}
+
+bool Raytracer::get_primary_hit(i32 const pixel, u32 const stratum, Ray const& ray, HitRecord& hit_record)
+{
+    PrimaryHit& entry = m_primary_hits[static_cast<size_t>(pixel) * m_active_primary_hit_strata + stratum];
+
+    if (entry.state == PrimaryHit::State::Uncached)
+        return false;
+
+    if (entry.state == PrimaryHit::State::Unknown)
+    {
+        RAYTRACER_STAT_RAY(0);
+
+        bool const is_hit = hit(ray, Interval(0.001f, AK::INFINITY_F), hit_record);
+
+        if (!is_hit)
+            hit_record = {};
+
+        Interval const segment = Interval(0.001f, is_hit ? hit_record.t : AK::INFINITY_F);
+
+        auto const is_crossed = [&](AABB const& bounds) { return bounds.hit(ray, segment); };
+
+        // This sample still uses the hit, only later ones trace the ray again.
+        if (std::ranges::any_of(m_medium_bounds, is_crossed))
+        {
+            entry.state = PrimaryHit::State::Uncached;
+            return true;
+        }
+
+        if (!is_hit)
+        {
+            entry.state = PrimaryHit::State::Miss;
+            return true;
+        }
+
+        entry.point = hit_record.point;
+        entry.normal = hit_record.normal;
+        entry.material = hit_record.material.get();
+        entry.t = hit_record.t;
+        entry.u = hit_record.u;
+        entry.v = hit_record.v;
+        entry.uv_footprint = hit_record.uv_footprint;
+        entry.front_face = hit_record.front_face;
+        entry.state = PrimaryHit::State::Hit;
+        return true;
+    }
+
+    hit_record = {};
+
+    if (entry.state == PrimaryHit::State::Miss)
+        return true;
+
+    hit_record.point = entry.point;
+    hit_record.normal = entry.normal;
+    hit_record.t = entry.t;
+    hit_record.u = entry.u;
+    hit_record.v = entry.v;
+    hit_record.uv_footprint = entry.uv_footprint;
+    hit_record.front_face = entry.front_face;
+
+    if (entry.has_texture_color)
+        hit_record.texture_color = &entry.texture_color;
+
+    // Not owning, so samples do not contend for the reference count. The hittables keep the material alive
+    // for as long as the cache lives.
+    hit_record.material = std::shared_ptr<MaterialCPU>(std::shared_ptr<MaterialCPU>(), entry.material);
+
+    return true;
+}
+
+void Raytracer::cache_primary_textures(i32 const pixel)
+{
+    size_t const first = static_cast<size_t>(pixel) * m_active_primary_hit_strata;
+    std::span<PrimaryHit> const entries = {m_primary_hits.data() + first, static_cast<size_t>(m_active_primary_hit_strata)};
+
+    // The materials of the scene share the program compiled by initialize(), so the strata of a pixel are one batch.
+    size_t constexpr batch_size = 64;
+    std::array<TextureLookup, batch_size> lookups = {};
+    std::array<PrimaryHit*, batch_size> targets = {};
+    std::array<glm::vec3, batch_size> results = {};
+    TextureProgram const* program = nullptr;
+    size_t count = 0;
+
+    auto const flush = [&] {
+        program->evaluate(std::span(lookups).first(count), std::span(results).first(count));
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            targets[i]->texture_color = results[i];
+            targets[i]->has_texture_color = true;
+        }
+
+        count = 0;
+    };
+
+    for (PrimaryHit& entry : entries)
+    {
+        if (entry.state != PrimaryHit::State::Hit || entry.has_texture_color)
+            continue;
+
+        // Only diffuse and isotropic materials scatter with their texture.
+        MaterialCPU const& material = *entry.material;
+
+        if (material.texture == nullptr || material.texture_program == nullptr || material.metal || material.dielectric
+            || material.emissive)
+            continue;
+
+        if (program != nullptr && (material.texture_program.get() != program || count == batch_size))
+            flush();
+
+        program = material.texture_program.get();
+        lookups[count] = {material.texture_entry, entry.u, entry.v, entry.point, entry.uv_footprint};
+        targets[count] = &entry;
+        count += 1;
+    }
+
+    if (count > 0)
+        flush();
+}
+
+// Media scatter rays at random distances, so the first hits of rays crossing them change from sample to sample.
+static bool is_medium(Hittable const& hittable)
+{
+    if (dynamic_cast<ConstantDensityMedium const*>(&hittable) != nullptr || dynamic_cast<HeterogeneousMedium const*>(&hittable) != nullptr)
+        return true;
+
+    if (auto const translated = dynamic_cast<TranslateHittable const*>(&hittable); translated != nullptr)
+        return is_medium(*translated->hittable());
+
+    if (auto const rotated = dynamic_cast<RotateYHittable const*>(&hittable); rotated != nullptr)
+        return is_medium(*rotated->hittable());
+
+    return false;
+}
+
+void Raytracer::update_primary_hit_cache()
+{
+    m_active_primary_hit_strata = 0;
+
+    if (m_primary_hit_strata <= 0)
+    {
+        m_primary_hits = {};
+        return;
+    }
+
+    // Lens and time samples would change the camera rays from sample to sample.
+    if (m_camera.aperture > 0.0f || m_bvh->has_motion())
+    {
+        std::clog << "Primary hit cache is off, it needs a pinhole camera without motion blur\n";
+        m_primary_hits = {};
+        return;
+    }
+
+    PrimaryHitKey key = {};
+    key.origin = m_camera.position;
+    key.pixel00_location = m_pixel00_location;
+    key.pixel_delta_u = m_pixel_delta_u;
+    key.pixel_delta_v = m_pixel_delta_v;
+    key.cone_spread = m_pixel_cone_spread;
+    key.image_width = m_image_width;
+    key.image_height = m_image_height;
+    key.strata = m_primary_hit_strata;
+
+    m_active_primary_hit_strata = m_primary_hit_strata;
+
+    // The camera and the geometry did not change since the last job, its hits are still valid. The texture values are
+    // not, a different bake resolution changes noise textures.
+    if (key == m_primary_hit_key && !m_primary_hits.empty())
+    {
+        for (auto& entry : m_primary_hits)
+        {
+            entry.has_texture_color = false;
+        }
+
+        return;
+    }
+
+    m_primary_hit_key = key;
+    m_primary_hits.assign(static_cast<size_t>(m_image_width) * m_image_height * m_primary_hit_strata, {});
+
+    m_medium_bounds.clear();
+
+    for (auto const& hittable : m_hittables)
+    {
+        if (is_medium(*hittable))
+            m_medium_bounds.emplace_back(hittable->bounding_box());
+    }
+
+    std::clog << "Primary hit cache: " << static_cast<double>(m_primary_hits.size() * sizeof(PrimaryHit)) / (1024.0 * 1024.0) << " MB ("
+              << m_primary_hit_strata << " strata per pixel)\n";
+}
+
+glm::vec3 Raytracer::trace(Ray const& ray) const
+{
+    AOVSample sample = {};
+
+    return ray_color(ray, m_max_depth, 0, sample);
+}
+
+void Raytracer::initialize()
+{
+    // Calculate the image height, and ensure that it's at least 1.
+    m_image_height = static_cast<i32>(static_cast<float>(m_image_width) / m_aspect_ratio);
+    m_image_height = (m_image_height < 1) ? 1 : m_image_height;
+
+    // Determine viewport dimensions. The viewport lies on the plane in focus.
+    float constexpr default_focus_distance = 3.47f;
+    float const focal_length = m_camera.focus_distance > 0.0f ? m_camera.focus_distance : default_focus_distance;
+    float const theta = m_camera.fov;
+    float const h = glm::tan(theta / 2.0f);
+    float const viewport_height = 2.0f * h * focal_length;
+    float const viewport_width = viewport_height * (static_cast<float>(m_image_width) / static_cast<float>(m_image_height));
+
+    // Calculate the vectors across the horizontal and down the vertical viewport edges.
+    glm::vec3 const viewport_u = viewport_width * -m_camera.get_right();
+    glm::vec3 const viewport_v = viewport_height * -m_camera.get_up();
+
+    // Calculate the horizontal and vertical delta vectors from pixel to pixel.
+    m_pixel_delta_u = viewport_u / static_cast<float>(m_image_width);
+    m_pixel_delta_v = viewport_v / static_cast<float>(m_image_height);
+    m_pixel_cone_spread = 0.5f * glm::length(m_pixel_delta_u) / focal_length;
+
+    // Calculate the location of the upper left pixel.
+    glm::vec3 const viewport_upper_left = m_camera.position - focal_length * m_camera.get_front() - viewport_u / 2.0f - viewport_v / 2.0f;
+    m_pixel00_location = viewport_upper_left + 0.5f * (m_pixel_delta_u + m_pixel_delta_v);
+
+    // Lens radius vectors, sample_disk() picks a point within them.
+    float const lens_radius = 0.5f * m_camera.aperture;
+    m_lens_u = lens_radius * m_camera.get_right();
+    m_lens_v = lens_radius * m_camera.get_up();
+
+    if (m_texture_bake_resolution > 0 && m_texture_bake_resolution != m_baked_texture_resolution)
+    {
+        bake_textures();
+        m_baked_texture_resolution = m_texture_bake_resolution;
+    }
+
+    compile_textures();
+
+    // The hittables did not change since the last initialize(), e.g. another job of the render server on the same scene.
+    if (m_bvh == nullptr)
+        build_bvh();
+
+    update_primary_hit_cache();
+
+    if (m_photon_map_settings.photon_count > 0)
+    {
+        m_photon_map = PhotonMap::create(m_photon_map_settings);
+        m_photon_map->trace(*this, get_resolved_thread_count(), m_seed);
+    }
+    else
+    {
+        m_photon_map = nullptr;
+    }
+
+    // Trained last, so the training paths see the photon map like the render does.
+    if (m_path_guide_settings.iteration_count > 0)
+    {
+        train_path_guide();
+    }
+    else
+    {
+        m_path_guide = nullptr;
+    }
+}
+
+void Raytracer::build_bvh()
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    m_primary_hits.clear();
+
+    // Everything the previous job allocated goes away at once.
+    m_scene_arena.reset();
+
+    u64 const cache_key = BVHCache::compute_key(m_hittables);
+
+    if (!m_bvh_cache_directory.empty())
+        m_bvh = BVHCache::load(m_bvh_cache_directory, cache_key, m_hittables, &m_scene_arena, &m_scratch_arena);
+
+    bool const is_cached = m_bvh != nullptr;
+
+    if (!is_cached)
+    {
+        m_bvh = BVH::build(m_hittables, &m_scene_arena, &m_scratch_arena);
+
+        if (!m_bvh_cache_directory.empty())
+            BVHCache::store(m_bvh_cache_directory, cache_key, *m_bvh);
+    }
+
+    m_media.clear();
+
+    for (auto const& hittable : m_hittables)
+    {
+        if (is_medium(*hittable))
+            m_media.emplace_back(hittable.get());
+    }
+
+    std::chrono::duration<double> const build_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << (is_cached ? "BVH cache load time: " : "BVH build time: ") << build_time.count() << " s (" << m_hittables.size()
+              << " hittables, " << m_bvh->nodes().size() << " nodes)\n";
+
+    std::clog << "Scene arena: " << static_cast<double>(m_scene_arena.used()) / (1024.0 * 1024.0) << " MB used, "
+              << static_cast<double>(m_scene_arena.capacity()) / (1024.0 * 1024.0) << " MB reserved, scratch peak "
+              << static_cast<double>(m_scratch_arena.peak_used()) / (1024.0 * 1024.0) << " MB\n";
+
+    m_scratch_arena.reset();
+}
+
+void Raytracer::train_path_guide()
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    m_path_guide = PathGuide::create(m_path_guide_settings, m_bbox);
+
+    i32 const thread_count = get_resolved_thread_count();
+    i64 path_count = 0;
+
+    for (i32 iteration = 0; iteration < m_path_guide_settings.iteration_count; ++iteration)
+    {
+        // Twice the samples of the previous iteration, each iteration learns from a better guided one.
+        i32 const sample_count = std::max(1, m_path_guide_settings.training_samples) << std::min(iteration, 16);
+
+        u64 iteration_seed = AK::HASH_OFFSET_BASIS;
+        AK::hash_bytes(iteration_seed, &m_seed, sizeof(m_seed));
+        AK::hash_bytes(iteration_seed, &iteration, sizeof(iteration));
+
+        std::atomic<i32> next_scanline = 0;
+
+        auto const train_scanlines = [&] {
+            for (i32 k = next_scanline.fetch_add(1); k < m_image_height; k = next_scanline.fetch_add(1))
+            {
+                AK::seed_random(row_seed(iteration_seed, k));
+
+                for (i32 i = 0; i < m_image_width; ++i)
+                {
+                    for (i32 sample = 0; sample < sample_count; ++sample)
+                    {
+                        AOVSample aov_sample = {};
+                        [[maybe_unused]] glm::vec3 const color = ray_color(get_ray(i, k), m_max_depth, 0, aov_sample, nullptr, true);
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> workers = {};
+        workers.reserve(thread_count - 1);
+
+        for (i32 i = 1; i < thread_count; ++i)
+        {
+            workers.emplace_back(train_scanlines);
+        }
+
+        train_scanlines();
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        m_path_guide->finish_iteration();
+        path_count += static_cast<i64>(sample_count) * m_image_width * m_image_height;
+    }
+
+    std::chrono::duration<double> const training_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Path guide training time: " << training_time.count() << " s (" << m_path_guide_settings.iteration_count
+              << " iterations, " << path_count << " paths, " << m_path_guide->leaf_count() << " cells, "
+              << m_path_guide->directional_node_count() << " directional nodes)\n";
+}
+
+struct NoiseTextureUse
+{
+    std::shared_ptr<NoiseTexture> texture = {};
+
+    // Union of the bounds of every hittable using the texture.
+    AABB bounds = AABB::empty;
+    std::vector<Hittable const*> hittables = {};
+};
+
+static void collect_noise_textures(std::shared_ptr<TextureCPU> const& texture, Hittable const& hittable, std::vector<NoiseTextureUse>& uses)
+{
+    if (auto const checker = std::dynamic_pointer_cast<CheckerTexture>(texture); checker != nullptr)
+    {
+        collect_noise_textures(checker->even(), hittable, uses);
+        collect_noise_textures(checker->odd(), hittable, uses);
+        return;
+    }
+
+    auto const noise = std::dynamic_pointer_cast<NoiseTexture>(texture);
+
+    if (noise == nullptr)
+        return;
+
+    auto use = std::ranges::find(uses, noise, &NoiseTextureUse::texture);
+
+    if (use == uses.end())
+    {
+        uses.emplace_back();
+        use = uses.end() - 1;
+        use->texture = noise;
+    }
+
+    use->bounds = AABB(use->bounds, hittable.bounding_box());
+
+    if (std::ranges::find(use->hittables, &hittable) == use->hittables.end())
+        use->hittables.emplace_back(&hittable);
+}
+
+void Raytracer::bake_textures() const
+{
+    auto const start_time = std::chrono::steady_clock::now();
+
+    // Every noise texture is baked once, directly or through a checker. Checkers themselves are not baked,
+    // interpolating them would blur their edges and they are cheap anyway.
+    std::vector<NoiseTextureUse> uses = {};
+
+    for (auto const& hittable : m_hittables)
+    {
+        if (hittable->material != nullptr)
+            collect_noise_textures(hittable->material->texture, *hittable, uses);
+    }
+
+    if (uses.empty())
+        return;
+
+    // Bakes that are too far off would visibly change the image, those textures stay exact.
+    float constexpr max_mean_error = 0.02f;
+
+    i32 baked_count = 0;
+
+    for (auto const& use : uses)
+    {
+        glm::vec3 point = {};
+        bool const is_surface = use.hittables.size() == 1 && use.hittables[0]->surface_point(0.0f, 0.0f, point);
+
+        i32 const thread_count = get_resolved_thread_count();
+        TextureBakeStats const stats = is_surface ? use.texture->bake_surface(*use.hittables[0], m_texture_bake_resolution, thread_count)
+                                                  : use.texture->bake_volume(use.bounds, m_texture_bake_resolution, thread_count);
+
+        std::clog << "Baked NoiseTexture " << (is_surface ? "atlas" : "volume") << ": " << stats.sample_counts.x << "x"
+                  << stats.sample_counts.y << "x" << stats.sample_counts.z << " samples, "
+                  << static_cast<double>(stats.memory_size) / (1024.0 * 1024.0) << " MB, mean error " << stats.mean_error << ", max error "
+                  << stats.max_error << "\n";
+
+        if (stats.mean_error > max_mean_error)
+        {
+            use.texture->clear_bake();
+            std::clog << "Discarded the bake, the mean error is over " << max_mean_error << "\n";
+            continue;
+        }
+
+        baked_count += 1;
+    }
+
+    std::chrono::duration<double> const bake_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Texture bake time: " << bake_time.count() << " s (" << baked_count << " of " << uses.size() << " textures baked)\n";
+}
+
+void Raytracer::compile_textures() const
+{
+    // A new program every time, materials may have been shared with a previous scene that still uses the old one.
+    auto const program = std::make_shared<TextureProgram>();
+    std::vector<MaterialCPU*> materials = {};
+
+    for (auto const& hittable : m_hittables)
+    {
+        MaterialCPU* material = hittable->material.get();
+
+        if (material == nullptr || material->texture == nullptr)
+            continue;
+
+        material->texture_entry = program->compile(material->texture);
+        materials.emplace_back(material);
+    }
+
+    // Only handed out once complete, the program does not change afterwards.
+    for (MaterialCPU* material : materials)
+    {
+        material->texture_program = program;
+    }
+
+    std::clog << "Texture program: " << program->instruction_count() << " instructions\n";
+}
+
+i32 Raytracer::get_resolved_thread_count() const
+{
+    return m_thread_count > 0 ? m_thread_count : static_cast<i32>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+bool Raytracer::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+{
+    HitRecord temp_record = {};
+    bool hit_anything = false;
+
+    if (m_bvh->hit(ray, Interval(ray_t.min, ray_t.max), temp_record))
+    {
+        hit_anything = true;
+        hit_record = temp_record;
+    }
+
+    return hit_anything;
+}
+
+// Diffuse bounce of a training path.
+struct GuidedVertex
+{
+    u32 leaf = 0;
+    glm::vec3 direction = {};
+    float pdf = 0.0f;
+
+    // Of the path up to and including the bounce.
+    glm::vec3 throughput = {};
+
+    // Light found after the bounce, times the throughput.
+    glm::vec3 radiance = {};
+};
+
+// Bounces after this many diffuse ones still guide, they are just not recorded.
+static i32 constexpr max_guided_vertices = 16;
+
+glm::vec3 Raytracer::ray_color(Ray const& ray, i32 const depth, i32 const photon_pass, AOVSample& sample,
+                               HitRecord const* primary_hit, bool const is_training) const
+{
+    // Iterative form of the recursive path tracer, so the contribution of each bounce can be split into the AOV layers.
+    // Bounce 0 is what the camera sees directly (emission, including the background), bounce 1 is direct lighting
+    // and everything after that is indirect lighting.
+    glm::vec3 color = {0.0f, 0.0f, 0.0f};
+    glm::vec3 throughput = {1.0f, 1.0f, 1.0f};
+    Ray current_ray = ray;
+
+    // Only filled by training paths. Light reaches every vertex recorded so far, the explicit samples of a bounce are
+    // added before the bounce itself is recorded, since they do not arrive along its direction.
+    std::array<GuidedVertex, max_guided_vertices> guided_vertices = {};
+    i32 guided_vertex_count = 0;
+
+    auto const add_contribution = [&](i32 const bounce, glm::vec3 const& contribution) {
+        color += contribution;
+
+        for (i32 i = 0; i < guided_vertex_count; ++i)
+        {
+            guided_vertices[i].radiance += contribution;
+        }
+
+        if (bounce == 0)
+        {
+            sample.emission += contribution;
+        }
+        else if (bounce == 1)
+        {
+            sample.direct += contribution;
+        }
+        else
+        {
+            sample.indirect += contribution;
+        }
+    };
+
+    // Whether the path went through a diffuse bounce followed only by specular ones. Light found from there is
+    // already in the photon map estimate of that diffuse bounce.
+    bool is_after_diffuse = false;
+    bool is_caustic_path = false;
+
+    // Density of the bounce direction if the last hit was diffuse and sampled the environment explicitly, 0 otherwise.
+    float diffuse_pdf = 0.0f;
+
+    // If we've exceeded the ray bounce limit, no more light is gathered.
+    for (i32 bounce = 0; bounce < depth; ++bounce)
+    {
+        HitRecord hit_record = {};
+        bool is_hit = false;
+
+        if (bounce == 0 && primary_hit != nullptr)
+        {
+            hit_record = *primary_hit;
+            is_hit = hit_record.material != nullptr;
+        }
+        else
+        {
+            RAYTRACER_STAT_RAY(bounce);
+            is_hit = hit(current_ray, Interval(0.001f, AK::INFINITY_F), hit_record);
+        }
+
+        // If the ray hits nothing, return the background color.
+        if (!is_hit)
+        {
+            if (m_environment == nullptr)
+            {
+                add_contribution(bounce, throughput * m_background_color);
+                break;
+            }
+
+            // Weighted against the explicit sample of the last diffuse hit with the power heuristic.
+            float weight = 1.0f;
+
+            if (diffuse_pdf > 0.0f)
+            {
+                float const light_pdf = m_environment->pdf(current_ray.direction());
+                weight = diffuse_pdf * diffuse_pdf / (diffuse_pdf * diffuse_pdf + light_pdf * light_pdf);
+            }
+
+            add_contribution(bounce, throughput * weight * m_environment->radiance(current_ray.direction()));
+            break;
+        }
+
+        Ray scattered;
+        glm::vec3 attenuation;
+        glm::vec3 const emitted_color = hit_record.material->emit(hit_record.u, hit_record.v, hit_record.point);
+
+        if (!is_caustic_path || m_photon_map == nullptr)
+            add_contribution(bounce, throughput * emitted_color);
+
+        bool const scatters = hit_record.material->scatter(current_ray, hit_record, attenuation, scattered);
+        bool const is_diffuse = hit_record.material->is_diffuse();
+
+        if (bounce == 0)
+        {
+            sample.depth = hit_record.t * glm::length(current_ray.direction());
+            sample.normal = hit_record.normal;
+
+            // Emitters carry their (clamped) color in the albedo, as denoisers expect.
+            sample.albedo = scatters ? attenuation : glm::clamp(emitted_color, 0.0f, 1.0f);
+        }
+
+        if (!scatters)
+            break;
+
+        if (m_photon_map != nullptr && is_diffuse)
+        {
+            glm::vec3 const caustics = m_photon_map->estimate(photon_pass, hit_record.point, hit_record.normal);
+            add_contribution(bounce + 1, throughput * attenuation * caustics);
+        }
+
+        diffuse_pdf = 0.0f;
+
+        i64 const guide_leaf = m_path_guide != nullptr && is_diffuse ? static_cast<i64>(m_path_guide->leaf_of(hit_record.point)) : -1;
+
+        if (m_environment != nullptr && is_diffuse)
+            add_contribution(bounce + 1, throughput * attenuation * sample_environment(hit_record, current_ray.time(), guide_leaf));
+
+        float guided_pdf = 0.0f;
+
+        if (guide_leaf >= 0)
+        {
+            glm::vec3 direction = glm::normalize(scattered.direction());
+            guided_pdf = m_path_guide->sample(static_cast<u32>(guide_leaf), hit_record.normal, direction);
+
+            float const cosine = glm::dot(direction, hit_record.normal);
+
+            if (guided_pdf <= 0.0f || cosine <= 0.0f)
+                break;
+
+            // Lambertian reflection times the cosine over the density of the mixture, which is 1 for the BSDF alone.
+            attenuation *= cosine / (AK::PI_F * guided_pdf);
+            scattered = Ray(scattered.origin(), direction);
+        }
+
+        if (m_environment != nullptr && is_diffuse)
+        {
+            diffuse_pdf = guide_leaf >= 0 ? guided_pdf
+                                          : glm::max(glm::dot(glm::normalize(scattered.direction()), hit_record.normal), 0.0f) / AK::PI_F;
+        }
+
+        is_caustic_path = !is_diffuse && hit_record.material->is_specular() && (is_after_diffuse || is_caustic_path);
+        is_after_diffuse = is_diffuse;
+
+        throughput *= attenuation;
+
+        if (is_training && guide_leaf >= 0 && guided_vertex_count < max_guided_vertices)
+        {
+            guided_vertices[guided_vertex_count] = {static_cast<u32>(guide_leaf), scattered.direction(), guided_pdf, throughput};
+            guided_vertex_count += 1;
+        }
+
+        // Mirrors and glass keep the cone of the incoming ray. Rough bounces average over a wide lobe anyway,
+        // so their cone is widened and the textures they see are sampled from coarser mip levels.
+        float constexpr rough_cone_spread = 0.1f;
+        float const cone_spread = hit_record.material->is_specular() ? current_ray.cone_spread()
+                                                                     : glm::max(current_ray.cone_spread(), rough_cone_spread);
+
+        current_ray =
+            Ray(scattered.origin(), scattered.direction(), current_ray.cone_width_at(hit_record.t), cone_spread, current_ray.time());
+    }
+
+    for (i32 i = 0; i < guided_vertex_count; ++i)
+    {
+        GuidedVertex const& vertex = guided_vertices[i];
+        glm::vec3 incident = {};
+
+        // Radiance arriving at the vertex along the bounce.
+        for (i32 channel = 0; channel < 3; ++channel)
+        {
+            if (vertex.throughput[channel] > 0.0f)
+                incident[channel] = vertex.radiance[channel] / vertex.throughput[channel];
+        }
+
+        m_path_guide->record(vertex.leaf, vertex.direction, (incident.r + incident.g + incident.b) / 3.0f, vertex.pdf);
+    }
+
+    return color;
+}
+
+glm::vec3 Raytracer::sample_environment(HitRecord const& hit_record, float const time, i64 const guide_leaf) const
+{
+    glm::vec3 direction = {};
+    float const light_pdf = m_environment->sample(direction);
+    float const cosine = glm::dot(direction, hit_record.normal);
+
+    if (light_pdf <= 0.0f || cosine <= 0.0f)
+        return {};
+
+    // Only surfaces block the shadow ray. Media let it through and dim it by the fraction of light they pass.
+    Ray shadow_ray(hit_record.point, direction, 0.0f, 0.0f, time);
+    shadow_ray.set_shadow(true);
+
+    Interval const shadow_t = Interval(0.001f, AK::INFINITY_F);
+    HitRecord shadow_record = {};
+    RAYTRACER_STAT_ADD(shadow_rays, 1);
+
+    if (hit(shadow_ray, shadow_t, shadow_record))
+        return {};
+
+    float transmittance = 1.0f;
+
+    for (auto const* medium : m_media)
+    {
+        transmittance *= medium->transmittance(shadow_ray, shadow_t);
+
+        if (transmittance <= 0.0f)
+            return {};
+    }
+
+    // Lambertian reflection times the cosine is the density of the diffuse bounce, which makes the weight
+    // against the environment found by the bounce simple to get. Guided bounces have a density of their own.
+    float const diffuse_pdf = cosine / AK::PI_F;
+    float const bounce_pdf = guide_leaf >= 0 ? m_path_guide->pdf(static_cast<u32>(guide_leaf), hit_record.normal, direction) : diffuse_pdf;
+    float const weight = light_pdf * light_pdf / (light_pdf * light_pdf + bounce_pdf * bounce_pdf);
+
+    return m_environment->radiance(direction) * (transmittance * diffuse_pdf * weight / light_pdf);
+}
+
+bool Raytracer::is_cancelled() const
+{
+    return m_cancel_flag != nullptr && m_cancel_flag->load(std::memory_order_relaxed);
+}
+
+glm::vec3 Raytracer::sample_square() const
+{
+    // Returns the vector to a random point in the [-0.5, -0.5]-[+0.5, +0.5] unit square.
+    return {AK::random_float_fast() - 0.5f, AK::random_float_fast() - 0.5f, 0.0f};
+}
+
+glm::vec3 Raytracer::sample_disk() const
+{
+    // Returns the vector to a uniformly distributed random point in the unit disk.
+    float const radius = glm::sqrt(AK::random_float_fast());
+    float const phi = 2.0f * AK::PI_F * AK::random_float_fast();
+    return {radius * glm::cos(phi), radius * glm::sin(phi), 0.0f};
+}
+
+u64 Raytracer::compute_scene_hash() const
+{
+    // The scene file covers the geometry, materials, camera and sampling settings. Image size and layers are
+    // checked against the framebuffer separately.
+    YAML::Emitter scene = {};
+    RaytracerSerialization::serialize(scene, *this);
+
+    u64 hash = AK::HASH_OFFSET_BASIS;
+    AK::hash_bytes(hash, scene.c_str(), scene.size());
+    AK::hash_bytes(hash, &m_seed, sizeof(m_seed));
+    AK::hash_bytes(hash, &m_texture_bake_resolution, sizeof(m_texture_bake_resolution));
+    AK::hash_bytes(hash, &m_photon_map_settings, sizeof(m_photon_map_settings));
+    AK::hash_bytes(hash, &m_primary_hit_strata, sizeof(m_primary_hit_strata));
+    AK::hash_bytes(hash, &m_path_guide_settings, sizeof(m_path_guide_settings));
+
+    return hash;
 }
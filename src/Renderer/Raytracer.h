@@ -1,24 +1,71 @@
 #pragma once
 
+#include "AK/Arena.h"
 #include "AK/Badge.h"
 #include "AK/Interval.h"
+#include "Framebuffer.h"
+#include "PathGuide.h"
+#include "PhotonMap.h"
 #include "Ray.h"
+#include "RaytracerCamera.h"
 #include "Renderer/Hittable.h"
 
 #include <glm/vec3.hpp>
 
+#include <atomic>
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
-class BVHNode;
+class BVH;
+class EnvironmentLight;
 class Hittable;
-class Camera;
+
+enum class RenderBudgetMode : u8
+{
+    // Every pixel takes the samples per pixel.
+    Samples,
+
+    // Passes over the image until the time runs out.
+    Time,
+
+    // Passes over the image until the estimated error is below the target.
+    Error,
+};
+
+struct RenderBudget
+{
+    RenderBudgetMode mode = RenderBudgetMode::Samples;
+
+    // Seconds render() may take in Time mode, initialize() does not count. Limits Error mode as well if it is not 0.
+    double seconds = 0.0;
+
+    // Estimated error to stop at in Error mode, see Framebuffer::estimate_error().
+    float target_error = 0.0f;
+
+    // Time and Error mode stop here even if neither the time nor the target is reached, so fireflies or an image
+    // without any variance cannot keep an Error render going forever.
+    u32 max_samples_per_pixel = 65536;
+};
+
+// What the last render() achieved.
+struct RenderReport
+{
+    double samples_per_pixel = 0.0;
+    double seconds = 0.0;
+    float estimated_error = 0.0f;
+
+    // The limit that ended the render. Samples if it took the samples per pixel of the scene or ran into
+    // max_samples_per_pixel of the budget.
+    RenderBudgetMode stopped_by = RenderBudgetMode::Samples;
+};
 
 class Raytracer
 {
 public:
-    static std::shared_ptr<Raytracer> create();
+    // The render server keeps one raytracer per loaded scene, those are not the instance of the engine scene.
+    static std::shared_ptr<Raytracer> create(bool const is_instance = true);
     explicit Raytracer(AK::Badge<Raytracer>);
 
     static std::shared_ptr<Raytracer> get_instance();
@@ -26,41 +73,289 @@ public:
     void register_hittable(std::shared_ptr<Hittable> const& hittable);
     void unregister_hittable(std::shared_ptr<Hittable> const& hittable);
 
-    void initialize(std::shared_ptr<Camera> const& camera);
-    void render(std::shared_ptr<Camera> const& camera);
+    [[nodiscard]] std::vector<std::shared_ptr<Hittable>> const& get_hittables() const;
+
+    // Builds the BVH and the viewport for the current camera and image settings. Has to be called before render().
+    // The BVH and texture bakes are kept until the hittables change, so jobs that only change the camera or
+    // image settings skip them.
+    void initialize();
+
+    // Returns false if the render was cancelled, the image is not saved then.
+    bool render();
+
+    // Renders with a time or error budget take passes of a few samples per pixel over the image and check the budget
+    // after every pass. Workers stop picking up rows of a pass once the time is up, so the render ends at most a row
+    // after it. The first pass always covers the whole image, very short budgets can be overrun by it. Checkpoints
+    // are only written by renders in Samples mode.
+    void set_render_budget(RenderBudget const& budget);
+    [[nodiscard]] RenderBudget const& get_render_budget() const;
+
+    // Of the last render() that was not cancelled.
+    [[nodiscard]] RenderReport const& get_render_report() const;
+
+    // Building blocks of render() for renders split across processes, see DistributedRender.
+    // Rows are independent and seeded by their index, so they can be rendered in any order, by any thread or process.
+    // pixel_samples holds the number of samples taken for every pixel of the image, in framebuffer order. Empty takes
+    // the samples per pixel everywhere.
+    void reset_framebuffer();
+    void render_row(i32 const row, std::span<u32 const> const pixel_samples = {});
+    void save_framebuffer() const;
+
+    // Renders every row on the render threads into the current framebuffer, without resetting or saving it.
+    // Used by RenderSequence to add samples on top of the previous frame.
+    void render_rows(std::span<u32 const> const pixel_samples = {});
+    void set_framebuffer(std::shared_ptr<Framebuffer> const& framebuffer);
+
+    // Updates the BVH after hittables moved, see BVH::refit(). Hittables must not have been added or removed
+    // since initialize(), the next initialize() keeps the refitted BVH.
+    void refit_bvh();
+
+    // Ray through the center of the pixel, without the jitter of the samples.
+    [[nodiscard]] Ray get_pixel_center_ray(i32 const i, i32 const k) const;
+
+    // Light arriving along the ray, for bakes that trace from points in the scene instead of from the camera.
+    // Draws from the random sequence of the calling thread, see AK::seed_random().
+    [[nodiscard]] glm::vec3 trace(Ray const& ray) const;
+
+    // Closest hit in the scene, for passes tracing their own paths like PhotonMap.
+    bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const;
+
+    // Hash of the serialized scene and of every setting that changes the image. Equal hashes render equal rows.
+    [[nodiscard]] u64 compute_scene_hash() const;
 
     void clear();
 
+    void set_camera(RaytracerCamera const& camera);
+    [[nodiscard]] RaytracerCamera const& get_camera() const;
+
     void set_aspect_ratio(float const aspect_ratio);
     void set_image_width(i32 const image_width);
     void set_samples_per_pixel(i32 const samples_per_pixel);
     void set_max_depth(i32 const max_depth);
     void set_background_color(glm::vec3 const& background_color);
 
+    // Lights the scene in place of the background color and is sampled explicitly at diffuse hits. Nullptr goes back
+    // to the background color, clear() resets it.
+    void set_environment(std::shared_ptr<EnvironmentLight> const& environment);
+
+    // 0 uses every hardware thread.
+    void set_thread_count(i32 const thread_count);
+
+    // Beauty is written to the given path, other AOV layers next to it.
+    void set_output_path(std::string const& path);
+
+    // Built BVHs are cached in this directory and reused while the geometry stays the same. Empty disables the cache.
+    void set_bvh_cache_directory(std::string const& directory);
+
+    // Expensive procedural textures are baked into grids with this many cells along their longest axis during initialize().
+    // 0 disables baking and evaluates them exactly on every hit.
+    void set_texture_bake_resolution(i32 const resolution);
+
+    // Camera rays of the samples of a pixel take turns between this many fixed positions within it. Their first hits are
+    // kept from one sample and one render to the next until the camera, the image size or the geometry changes, which
+    // saves a traversal per sample once every position was traced. Antialiasing is limited to that many positions.
+    // Needs a pinhole camera and no motion blur, otherwise it stays off. 0 disables it (default).
+    void set_primary_hit_cache(i32 const strata);
+
+    // Caustics are gathered from a photon map traced during initialize(), see PhotonMap. A photon count of 0 disables it.
+    void set_photon_map_settings(PhotonMapSettings const& settings);
+
+    // Diffuse bounces are guided towards the incoming light learned by training passes over the image during
+    // initialize(), see PathGuide. An iteration count of 0 disables it.
+    void set_path_guide_settings(PathGuideSettings const& settings);
+
+    // Every row of the image draws its random numbers from a sequence derived from this seed and the row index,
+    // so the same seed renders the same image with any number of threads.
+    void set_seed(u64 const seed);
+    [[nodiscard]] u64 get_seed() const;
+
+    // Finished rows are written to the path every interval_seconds during render() and the file is removed once
+    // the image is saved. Empty disables checkpoints.
+    void set_checkpoint(std::string const& path, double const interval_seconds = 60.0);
+
+    // render() continues from the checkpoint if it matches the scene and settings, otherwise it starts over.
+    void set_resume(bool const resume);
+
+    // render() stops handing out rows once the flag is set, it can be set from any thread. Nullptr disables it.
+    void set_cancel_flag(std::atomic<bool> const* cancel_flag);
+
+    // Rows of the current render() that are done, of the current pass for renders with a budget. It can be read from
+    // any thread.
+    [[nodiscard]] i32 get_finished_row_count() const;
+
+    [[nodiscard]] float get_aspect_ratio() const;
+    [[nodiscard]] i32 get_image_width() const;
+    [[nodiscard]] i32 get_image_height() const;
+    [[nodiscard]] i32 get_samples_per_pixel() const;
+    [[nodiscard]] i32 get_max_depth() const;
+    [[nodiscard]] glm::vec3 get_background_color() const;
+    [[nodiscard]] std::shared_ptr<EnvironmentLight> const& get_environment() const;
+
+    // Bitmask of Framebuffer::aov_bit() values. Beauty is always rendered.
+    void set_enabled_aovs(u32 const enabled_aovs);
+    void enable_aov(AOVType const type);
+    void set_output_format(FramebufferFormat const output_format);
+
+    [[nodiscard]] std::shared_ptr<Framebuffer> get_framebuffer() const;
+
+    // Acceleration data of the current job: BVH nodes, instance records and SIMD leaf blocks. Reset by the next
+    // initialize() and by clear().
+    [[nodiscard]] AK::Arena const& get_scene_arena() const;
+
+    // Temporary data of initialize(), reset once it finishes.
+    [[nodiscard]] AK::Arena const& get_scratch_arena() const;
+
 private:
+    // First hit along the camera ray of a stratum of a pixel.
+    struct PrimaryHit
+    {
+        enum class State : u8
+        {
+            Unknown,
+            Hit,
+            Miss,
+
+            // The ray crosses a medium, which scatters it at a different distance every time.
+            Uncached,
+        };
+
+        glm::vec3 point = {};
+        glm::vec3 normal = {};
+        MaterialCPU* material = nullptr;
+        float t = 0.0f;
+        float u = 0.0f;
+        float v = 0.0f;
+        float uv_footprint = 0.0f;
+        bool front_face = false;
+        State state = State::Unknown;
+
+        // Texture value the material scatters with, filled by cache_primary_textures().
+        bool has_texture_color = false;
+        glm::vec3 texture_color = {};
+    };
+
+    // Everything the camera rays of the cached hits depend on besides the geometry.
+    struct PrimaryHitKey
+    {
+        glm::vec3 origin = {};
+        glm::vec3 pixel00_location = {};
+        glm::vec3 pixel_delta_u = {};
+        glm::vec3 pixel_delta_v = {};
+        float cone_spread = 0.0f;
+        i32 image_width = 0;
+        i32 image_height = 0;
+        i32 strata = 0;
+
+        bool operator==(PrimaryHitKey const&) const = default;
+    };
+
+    // Budgeted form of render(), see set_render_budget().
+    bool render_passes();
+
+    // Saves the framebuffer at the end of render() and render_passes(). Statistics builds also print the summary
+    // of the render and write its heatmap next to the image.
+    void save_render(double const render_time) const;
+
+    // Adds sample_count samples to every pixel of the row, numbered from first_sample.
+    void render_pass_row(i32 const row, u64 const pass_seed, u32 const first_sample, u32 const sample_count);
+    void render_sample(i32 const i, i32 const row, u32 const sample);
+
     [[nodiscard]] Ray get_ray(i32 const i, i32 const k) const;
-    bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const;
+    [[nodiscard]] Ray get_stratum_ray(i32 const i, i32 const k, u32 const stratum) const;
+
+    // Fills hit_record with the first hit of the ray of the stratum, tracing it if it is not cached yet. Returns false
+    // if the ray cannot be cached, the caller traces it then.
+    bool get_primary_hit(i32 const pixel, u32 const stratum, Ray const& ray, HitRecord& hit_record);
+    void update_primary_hit_cache();
+
+    // Looks up the textures of the cached hits of the pixel as one batch, so the following samples of the pixel
+    // scatter with the stored values instead of evaluating the textures again.
+    void cache_primary_textures(i32 const pixel);
 
-    [[nodiscard]] glm::vec3 ray_color(Ray const& ray, i32 const depth) const;
+    // The first hit is taken from primary_hit instead of tracing the ray if it is set, a hit without a material is a miss.
+    // Training paths record the light they find into the path guide.
+    [[nodiscard]] glm::vec3 ray_color(Ray const& ray, i32 const depth, i32 const photon_pass, AOVSample& sample,
+                                      HitRecord const* primary_hit = nullptr, bool const is_training = false) const;
+
+    // Light of the environment reflected by a white diffuse surface at the hit, from one explicit sample. The bounce
+    // it is weighted against was guided by the leaf of the path guide, if it is not -1.
+    [[nodiscard]] glm::vec3 sample_environment(HitRecord const& hit_record, float const time, i64 const guide_leaf = -1) const;
 
     [[nodiscard]] glm::vec3 sample_square() const;
+    [[nodiscard]] glm::vec3 sample_disk() const;
+
+    [[nodiscard]] bool is_cancelled() const;
+
+    void build_bvh();
+    void train_path_guide();
+    void bake_textures() const;
+    void compile_textures() const;
+
+    [[nodiscard]] i32 get_resolved_thread_count() const;
 
     inline static std::weak_ptr<Raytracer> m_instance = {};
 
-    inline static std::string output_directory = "./output/";
-    inline static std::string output_file = "image.ppm";
+    std::string m_output_directory = "./output/";
+    std::string m_output_file = "image.ppm";
+
+    std::string m_bvh_cache_directory = "./cache/bvh/";
 
-    std::shared_ptr<Camera> m_camera = {};
-    glm::vec3 m_camera_position_this_frame = {};
+    i32 m_texture_bake_resolution = 0;
+
+    // Resolution of the current texture bakes, 0 if they have to be redone.
+    i32 m_baked_texture_resolution = 0;
+
+    i32 m_primary_hit_strata = 0;
+
+    // Strata of the cache of the current job, 0 if it is off.
+    i32 m_active_primary_hit_strata = 0;
+    PrimaryHitKey m_primary_hit_key = {};
+
+    // Strata of a pixel are next to each other, pixels in framebuffer order. Every row is only touched by the thread
+    // rendering it. Empty until the cache is set up for the current camera and geometry.
+    std::vector<PrimaryHit> m_primary_hits = {};
+
+    // Bounds of the media in the scene, rays crossing them are not cached.
+    std::vector<AABB> m_medium_bounds = {};
+
+    PhotonMapSettings m_photon_map_settings = {};
+
+    // Traced by every initialize(), the lights or glass may have moved since the last one.
+    std::shared_ptr<PhotonMap> m_photon_map = {};
+
+    PathGuideSettings m_path_guide_settings = {};
+
+    // Trained by every initialize(), like the photon map.
+    std::shared_ptr<PathGuide> m_path_guide = {};
+
+    u64 m_seed = 0;
+
+    std::string m_checkpoint_path = {};
+    double m_checkpoint_interval = 60.0;
+    bool m_resume = false;
+
+    RenderBudget m_render_budget = {};
+    RenderReport m_render_report = {};
+
+    std::atomic<bool> const* m_cancel_flag = nullptr;
+    std::atomic<i32> m_finished_row_count = 0;
+
+    RaytracerCamera m_camera = {};
 
     i32 m_samples_per_pixel = 10;
-    float m_pixel_samples_scale = 1.0f;
 
     i32 m_max_depth = 10;
 
     float m_aspect_ratio = 1.0f;
 
     glm::vec3 m_background_color = {};
+    std::shared_ptr<EnvironmentLight> m_environment = {};
+
+    i32 m_thread_count = 0;
+
+    u32 m_enabled_aovs = Framebuffer::aov_bit(AOVType::Beauty);
+    FramebufferFormat m_output_format = FramebufferFormat::PPM;
+    std::shared_ptr<Framebuffer> m_framebuffer = {};
 
     i32 m_image_width = 100;
     i32 m_image_height = 0;
@@ -69,9 +364,24 @@ private:
     glm::vec3 m_pixel_delta_u = {};
     glm::vec3 m_pixel_delta_v = {};
 
-    std::shared_ptr<BVHNode> m_root = {};
+    // Widening of the camera ray cones per world unit. They cover half a pixel on the viewport,
+    // the jittered samples already spread over the whole pixel.
+    float m_pixel_cone_spread = 0.0f;
+
+    // Right and up vectors of the camera, scaled to the radius of the lens.
+    glm::vec3 m_lens_u = {};
+    glm::vec3 m_lens_v = {};
+
+    // Members are destroyed in reverse order, declaring the arenas before the BVH makes them outlive it.
+    AK::Arena m_scene_arena = {};
+    AK::Arena m_scratch_arena = {};
+
+    std::shared_ptr<BVH> m_bvh = {};
 
     std::vector<std::shared_ptr<Hittable>> m_hittables = {};
 
+    // Media among the hittables, collected with the BVH. Shadow rays pass through them and take their transmittance.
+    std::vector<Hittable const*> m_media = {};
+
     AABB m_bbox = {glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f)};
 };
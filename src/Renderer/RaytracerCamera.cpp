@@ -0,0 +1,23 @@
+#include "RaytracerCamera.h"
+
+#include <glm/geometric.hpp>
+#include <glm/gtx/rotate_vector.hpp>
+
+glm::vec3 RaytracerCamera::get_front() const
+{
+    auto direction_forward = glm::vec3(0.0f, 0.0f, -1.0f);
+    direction_forward = glm::rotateX(direction_forward, glm::radians(euler_angles.x));
+    direction_forward = glm::rotateY(direction_forward, glm::radians(euler_angles.y));
+    direction_forward = glm::rotateZ(direction_forward, glm::radians(euler_angles.z));
+    return glm::normalize(direction_forward);
+}
+
+glm::vec3 RaytracerCamera::get_right() const
+{
+    return glm::normalize(glm::cross(get_front(), glm::vec3(0.0f, 1.0f, 0.0f)));
+}
+
+glm::vec3 RaytracerCamera::get_up() const
+{
+    return glm::normalize(glm::cross(get_right(), get_front()));
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/trigonometric.hpp>
+#include <glm/vec3.hpp>
+
+// Camera used by the raytracer. Uses the same conventions as the engine Transform and Camera:
+// euler angles in degrees applied in X, Y, Z order to the (0, 0, -1) forward vector and field of view in radians.
+struct RaytracerCamera
+{
+    glm::vec3 position = {};
+    glm::vec3 euler_angles = {};
+    float fov = glm::radians(45.0f);
+
+    // Thin lens: diameter of the lens and distance of the plane in focus, in world units. An aperture of 0 is a pinhole
+    // with everything in focus. A focus distance of 0 focuses at the default viewport distance of the raytracer.
+    float aperture = 0.0f;
+    float focus_distance = 0.0f;
+
+    [[nodiscard]] glm::vec3 get_front() const;
+    [[nodiscard]] glm::vec3 get_right() const;
+    [[nodiscard]] glm::vec3 get_up() const;
+};
@@ -0,0 +1,382 @@
+#include "RaytracerScenes.h"
+
+#include "AK/AK.h"
+#include "ConstantDensityMedium.h"
+#include "HeterogeneousMedium.h"
+#include "MaterialCPU.h"
+#include "QuadRaytraced.h"
+#include "Raytracer.h"
+#include "RotateYHittable.h"
+#include "SphereRaytraced.h"
+#include "TextureCPU.h"
+#include "TranslateHittable.h"
+
+#include <glm/gtc/random.hpp>
+
+#include <functional>
+#include <utility>
+
+static std::shared_ptr<MaterialCPU> lambertian(glm::vec3 const& color)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->color = glm::vec4(color, 1.0f);
+    return material;
+}
+
+static std::shared_ptr<MaterialCPU> textured(std::shared_ptr<TextureCPU> const& texture)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->texture = texture;
+    return material;
+}
+
+static std::shared_ptr<MaterialCPU> metal(glm::vec3 const& color, float const fuzz)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->color = glm::vec4(color, 1.0f);
+    material->metal = true;
+    material->fuzz = fuzz;
+    return material;
+}
+
+static std::shared_ptr<MaterialCPU> dielectric(float const refraction_index)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->dielectric = true;
+    material->refraction_index = refraction_index;
+    return material;
+}
+
+static std::shared_ptr<MaterialCPU> emissive(glm::vec3 const& color)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->color = {};
+    material->emissive = true;
+    material->texture = std::make_shared<SolidColor>(color);
+    return material;
+}
+
+static std::shared_ptr<MaterialCPU> isotropic(glm::vec3 const& color)
+{
+    auto material = std::make_shared<MaterialCPU>();
+    material->isotropic = true;
+    material->texture = std::make_shared<SolidColor>(color);
+    return material;
+}
+
+static void set_settings(Raytracer& raytracer, i32 const image_width, float const aspect_ratio, i32 const samples_per_pixel,
+                         i32 const max_depth, glm::vec3 const& background_color)
+{
+    raytracer.set_image_width(image_width);
+    raytracer.set_aspect_ratio(aspect_ratio);
+    raytracer.set_samples_per_pixel(samples_per_pixel);
+    raytracer.set_max_depth(max_depth);
+    raytracer.set_background_color(background_color);
+}
+
+static void add_cornell_walls(Raytracer& raytracer, std::shared_ptr<MaterialCPU> const& light_material, glm::vec3 const& light_q,
+                              glm::vec3 const& light_u, glm::vec3 const& light_v)
+{
+    auto const red = lambertian({0.65f, 0.05f, 0.05f});
+    auto const white = lambertian({0.73f, 0.73f, 0.73f});
+    auto const green = lambertian({0.12f, 0.45f, 0.15f});
+
+    raytracer.register_hittable(QuadRaytraced::create({555.0f, 0.0f, 0.0f}, {0.0f, 555.0f, 0.0f}, {0.0f, 0.0f, 555.0f}, green));
+    raytracer.register_hittable(QuadRaytraced::create({0.0f, 0.0f, 0.0f}, {0.0f, 555.0f, 0.0f}, {0.0f, 0.0f, 555.0f}, red));
+    raytracer.register_hittable(QuadRaytraced::create(light_q, light_u, light_v, light_material));
+    raytracer.register_hittable(QuadRaytraced::create({0.0f, 0.0f, 0.0f}, {555.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 555.0f}, white));
+    raytracer.register_hittable(QuadRaytraced::create({555.0f, 555.0f, 555.0f}, {-555.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -555.0f}, white));
+    raytracer.register_hittable(QuadRaytraced::create({0.0f, 0.0f, 555.0f}, {555.0f, 0.0f, 0.0f}, {0.0f, 555.0f, 0.0f}, white));
+}
+
+static std::vector<std::shared_ptr<Hittable>> transformed_box(glm::vec3 const& size, float const angle, glm::vec3 const& offset,
+                                                              std::shared_ptr<MaterialCPU> const& material)
+{
+    std::vector<std::shared_ptr<Hittable>> sides = {};
+
+    for (auto const& side : QuadRaytraced::box({0.0f, 0.0f, 0.0f}, size, material))
+    {
+        auto const rotated = std::make_shared<RotateYHittable>(side, angle);
+        sides.emplace_back(std::make_shared<TranslateHittable>(rotated, offset));
+    }
+
+    return sides;
+}
+
+static std::vector<std::pair<std::string, std::function<void(Raytracer&)>>> const& scene_table()
+{
+    static std::vector<std::pair<std::string, std::function<void(Raytracer&)>>> const scenes = {
+        {"bouncing_spheres", RaytracerScenes::bouncing_spheres},
+        {"checkered_spheres", RaytracerScenes::checkered_spheres},
+        {"earth", RaytracerScenes::earth},
+        {"perlin_spheres", RaytracerScenes::perlin_spheres},
+        {"quads", RaytracerScenes::quads},
+        {"simple_light", RaytracerScenes::simple_light},
+        {"cornell_box", RaytracerScenes::cornell_box},
+        {"cornell_smoke", RaytracerScenes::cornell_smoke},
+        {"cornell_fog", RaytracerScenes::cornell_fog},
+        {"final_scene", RaytracerScenes::final_scene},
+    };
+
+    return scenes;
+}
+
+bool RaytracerScenes::build(std::string const& name, Raytracer& raytracer)
+{
+    for (auto const& [scene_name, scene] : scene_table())
+    {
+        if (scene_name == name)
+        {
+            scene(raytracer);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::vector<std::string> RaytracerScenes::names()
+{
+    std::vector<std::string> result = {};
+
+    for (auto const& [scene_name, scene] : scene_table())
+    {
+        result.emplace_back(scene_name);
+    }
+
+    return result;
+}
+
+void RaytracerScenes::bouncing_spheres(Raytracer& raytracer)
+{
+    raytracer.set_camera({{13.0f, 2.0f, 3.0f}, {0.0f, 270.0f, 0.0f}, glm::radians(20.0f)});
+    set_settings(raytracer, 1200, 16.0f / 9.0f, 100, 50, {0.7f, 0.8f, 1.0f});
+
+    auto const checker = std::make_shared<CheckerTexture>(0.32f, glm::vec3(0.2f, 0.3f, 0.1f), glm::vec3(0.9f, 0.9f, 0.9f));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, -1000.0f, -0.0f}, 1000.0f, textured(checker)));
+
+    for (i32 a = -11; a < 11; a++)
+    {
+        for (i32 b = -11; b < 11; b++)
+        {
+            float choose_mat = AK::random_float_fast();
+            glm::vec3 center = glm::vec3(a + 0.9f * AK::random_float_fast(), 0.2f, b + 0.9f * AK::random_float_fast());
+
+            if (glm::length(center - glm::vec3(4.0f, 0.2f, 0.0f)) > 0.9f)
+            {
+                std::shared_ptr<MaterialCPU> sphere_material = {};
+
+                if (choose_mat < 0.8f)
+                {
+                    glm::vec3 rand1 = glm::linearRand(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+                    glm::vec3 rand2 = glm::linearRand(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 1.0f));
+                    sphere_material = lambertian(rand1 * rand2);
+                }
+                else if (choose_mat < 0.95f)
+                {
+                    glm::vec3 rand1 = glm::linearRand(glm::vec3(0.5f, 0.5f, 0.5f), glm::vec3(1.0f, 1.0f, 1.0f));
+                    sphere_material = metal(rand1, AK::random_float_fast(0.0f, 0.5f));
+                }
+                else
+                {
+                    sphere_material = dielectric(1.5f);
+                }
+
+                raytracer.register_hittable(SphereRaytraced::create(center, 0.2f, sphere_material));
+            }
+        }
+    }
+
+    auto const material2 = dielectric(1.5f);
+    material2->color = {0.8f, 0.8f, 0.8f, 1.0f};
+
+    raytracer.register_hittable(SphereRaytraced::create({4.0f, 1.0f, 0.0f}, 1.0f, metal({0.7f, 0.6f, 0.5f}, 0.0f)));
+    raytracer.register_hittable(SphereRaytraced::create({-4.0f, 1.0f, 0.0f}, 1.0f, lambertian({0.4f, 0.2f, 0.1f})));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 1.0f, 0.0f}, 1.0f, material2));
+}
+
+void RaytracerScenes::checkered_spheres(Raytracer& raytracer)
+{
+    raytracer.set_camera({{13.0f, 2.0f, 3.0f}, {0.0f, 260.0f, 5.0f}, glm::radians(20.0f)});
+    set_settings(raytracer, 400, 16.0f / 9.0f, 100, 50, {0.7f, 0.8f, 1.0f});
+
+    auto const checker = std::make_shared<CheckerTexture>(0.32f, glm::vec3(0.2f, 0.3f, 0.1f), glm::vec3(0.9f, 0.9f, 0.9f));
+    auto const material = textured(checker);
+
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, -10.0f, 0.0f}, 10.0f, material));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 10.0f, 0.0f}, 10.0f, material));
+}
+
+void RaytracerScenes::earth(Raytracer& raytracer)
+{
+    raytracer.set_camera({{0.0f, 0.0f, 12.0f}, {0.0f, -180.0f, 0.0f}, glm::radians(20.0f)});
+    set_settings(raytracer, 400, 16.0f / 9.0f, 100, 50, {0.7f, 0.8f, 1.0f});
+
+    auto const earth_surface = textured(std::make_shared<ImageTexture>("./res/textures/images/flowers.jpg"));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 0.0f, 0.0f}, 2.0f, earth_surface));
+}
+
+void RaytracerScenes::perlin_spheres(Raytracer& raytracer)
+{
+    raytracer.set_camera({{13.0f, 2.0f, 3.0f}, {0.0f, 260.0f, 5.0f}, glm::radians(20.0f)});
+    set_settings(raytracer, 400, 16.0f / 9.0f, 100, 50, {0.7f, 0.8f, 1.0f});
+
+    auto const material = textured(std::make_shared<NoiseTexture>(4.0f, 0));
+
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, -1000.0f, 0.0f}, 1000.0f, material));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 2.0f, 0.0f}, 2.0f, material));
+}
+
+void RaytracerScenes::quads(Raytracer& raytracer)
+{
+    raytracer.set_camera({{0.0f, 0.0f, 9.0f}, {0.0f, 180.0f, 0.0f}, glm::radians(80.0f)});
+    set_settings(raytracer, 400, 1.0f, 100, 50, {0.7f, 0.8f, 1.0f});
+
+    raytracer.register_hittable(
+        QuadRaytraced::create({-3.0f, -2.0f, 5.0f}, {0.0f, 0.0f, -4.0f}, {0.0f, 4.0f, 0.0f}, lambertian({1.0f, 0.2f, 0.2f})));
+    raytracer.register_hittable(
+        QuadRaytraced::create({-2.0f, -2.0f, 0.0f}, {4.0f, 0.0f, 0.0f}, {0.0f, 4.0f, 0.0f}, lambertian({0.2f, 1.0f, 0.2f})));
+    raytracer.register_hittable(
+        QuadRaytraced::create({3.0f, -2.0f, 1.0f}, {0.0f, 0.0f, 4.0f}, {0.0f, 4.0f, 0.0f}, lambertian({0.2f, 0.2f, 1.0f})));
+    raytracer.register_hittable(
+        QuadRaytraced::create({-2.0f, 3.0f, 1.0f}, {4.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 4.0f}, lambertian({1.0f, 0.5f, 0.0f})));
+    raytracer.register_hittable(
+        QuadRaytraced::create({-2.0f, -3.0f, 5.0f}, {4.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -4.0f}, lambertian({0.2f, 0.8f, 0.8f})));
+}
+
+void RaytracerScenes::simple_light(Raytracer& raytracer)
+{
+    raytracer.set_camera({{26.0f, 3.0f, 6.0f}, {0.0f, 260.0f, 5.0f}, glm::radians(20.0f)});
+    set_settings(raytracer, 400, 16.0f / 9.0f, 100, 50, {0.0f, 0.0f, 0.0f});
+
+    auto const material = textured(std::make_shared<NoiseTexture>(4.0f, 0));
+
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, -1000.0f, 0.0f}, 1000.0f, material));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 2.0f, 0.0f}, 2.0f, material));
+
+    auto const light_material = emissive({4.0f, 4.0f, 4.0f});
+
+    raytracer.register_hittable(QuadRaytraced::create({3.0f, 1.0f, -2.0f}, {2.0f, 0.0f, 0.0f}, {0.0f, 2.0f, 0.0f}, light_material));
+    raytracer.register_hittable(SphereRaytraced::create({-10.0f, 6.0f, 5.0f}, 2.0f, light_material));
+}
+
+void RaytracerScenes::cornell_box(Raytracer& raytracer)
+{
+    raytracer.set_camera({{278.0f, 278.0f, -800.0f}, {0.0f, 0.0f, 0.0f}, glm::radians(40.0f)});
+    set_settings(raytracer, 600, 1.0f, 200, 50, {0.0f, 0.0f, 0.0f});
+
+    add_cornell_walls(raytracer, emissive({15.0f, 15.0f, 15.0f}), {343.0f, 554.0f, 332.0f}, {-130.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -105.0f});
+
+    auto const white = lambertian({0.73f, 0.73f, 0.73f});
+
+    for (auto const& side : transformed_box({165.0f, 330.0f, 165.0f}, 15.0f, {265.0f, 0.0f, 295.0f}, white))
+    {
+        raytracer.register_hittable(side);
+    }
+
+    for (auto const& side : transformed_box({165.0f, 165.0f, 165.0f}, -18.0f, {130.0f, 0.0f, 65.0f}, white))
+    {
+        raytracer.register_hittable(side);
+    }
+}
+
+void RaytracerScenes::cornell_smoke(Raytracer& raytracer)
+{
+    raytracer.set_camera({{278.0f, 278.0f, -800.0f}, {0.0f, 0.0f, 0.0f}, glm::radians(40.0f)});
+    set_settings(raytracer, 600, 1.0f, 200, 50, {0.0f, 0.0f, 0.0f});
+
+    add_cornell_walls(raytracer, emissive({7.0f, 7.0f, 7.0f}), {113.0f, 554.0f, 127.0f}, {330.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 305.0f});
+
+    auto const white = lambertian({0.73f, 0.73f, 0.73f});
+
+    auto const box1 = transformed_box({165.0f, 330.0f, 165.0f}, 15.0f, {265.0f, 0.0f, 295.0f}, white);
+    raytracer.register_hittable(std::make_shared<ConstantDensityMedium>(box1, 0.01f, isotropic({0.0f, 0.0f, 0.0f})));
+
+    auto const box2 = transformed_box({165.0f, 165.0f, 165.0f}, -18.0f, {130.0f, 0.0f, 65.0f}, white);
+    raytracer.register_hittable(std::make_shared<ConstantDensityMedium>(box2, 0.01f, isotropic({1.0f, 1.0f, 1.0f})));
+}
+
+// Not from the books: cornell_smoke with noise driven fog instead of uniform smoke.
+void RaytracerScenes::cornell_fog(Raytracer& raytracer)
+{
+    raytracer.set_camera({{278.0f, 278.0f, -800.0f}, {0.0f, 0.0f, 0.0f}, glm::radians(40.0f)});
+    set_settings(raytracer, 600, 1.0f, 200, 50, {0.0f, 0.0f, 0.0f});
+
+    add_cornell_walls(raytracer, emissive({7.0f, 7.0f, 7.0f}), {113.0f, 554.0f, 127.0f}, {330.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 305.0f});
+
+    auto const sphere = MediumBoundary::sphere({370.0f, 150.0f, 330.0f}, 150.0f);
+    raytracer.register_hittable(std::make_shared<HeterogeneousMedium>(sphere, 0.03f, 0.02f, 0, 64, isotropic({0.73f, 0.73f, 0.73f})));
+
+    auto const box = MediumBoundary::box({0.0f, 0.0f, 0.0f}, {555.0f, 100.0f, 555.0f});
+    raytracer.register_hittable(std::make_shared<HeterogeneousMedium>(box, 0.01f, 0.01f, 1, 64, isotropic({1.0f, 1.0f, 1.0f})));
+}
+
+void RaytracerScenes::final_scene(Raytracer& raytracer)
+{
+    raytracer.set_camera({{478.0f, 278.0f, -600.0f}, {0.0f, -17.0f, 0.0f}, glm::radians(40.0f)});
+    set_settings(raytracer, 800, 1.0f, 20, 40, {0.0f, 0.0f, 0.0f});
+
+    // Ground boxes
+    auto const ground_material = lambertian({0.48f, 0.83f, 0.53f});
+
+    i32 constexpr boxes_per_side = 20;
+    for (i32 i = 0; i < boxes_per_side; i++)
+    {
+        for (i32 j = 0; j < boxes_per_side; j++)
+        {
+            auto w = 100.0f;
+            auto x0 = -1000.0f + i * w;
+            auto z0 = -1000.0f + j * w;
+            auto y0 = 0.0f;
+            auto x1 = x0 + w;
+            auto y1 = glm::linearRand(1.0f, 101.0f);
+            auto z1 = z0 + w;
+
+            for (auto const& side : QuadRaytraced::box({x0, y0, z0}, {x1, y1, z1}, ground_material))
+            {
+                raytracer.register_hittable(side);
+            }
+        }
+    }
+
+    // Light
+    raytracer.register_hittable(
+        QuadRaytraced::create({123.0f, 554.0f, 147.0f}, {300.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 265.0f}, emissive({7.0f, 7.0f, 7.0f})));
+
+    // Static, glass and metal spheres
+    raytracer.register_hittable(SphereRaytraced::create({400.0f, 400.0f, 200.0f}, 50.0f, lambertian({0.7f, 0.3f, 0.1f})));
+    raytracer.register_hittable(SphereRaytraced::create({260.0f, 150.0f, 45.0f}, 50.0f, dielectric(1.5f)));
+    raytracer.register_hittable(SphereRaytraced::create({0.0f, 150.0f, 145.0f}, 50.0f, metal({0.8f, 0.8f, 0.9f}, 1.0f)));
+
+    // Boundary spheres with constant medium. The first boundary is a visible glass sphere filled with the medium,
+    // the second one only bounds the mist around the whole scene.
+    auto const boundary_material = dielectric(1.5f);
+
+    auto const boundary1 = SphereRaytraced::create({360.0f, 150.0f, 145.0f}, 70.0f, boundary_material);
+    raytracer.register_hittable(boundary1);
+    raytracer.register_hittable(std::make_shared<ConstantDensityMedium>(std::vector<std::shared_ptr<Hittable>> {boundary1}, 0.2f,
+                                                                        isotropic({0.2f, 0.4f, 0.9f})));
+
+    auto const boundary2 = SphereRaytraced::create({0.0f, 0.0f, 0.0f}, 5000.0f, boundary_material);
+    raytracer.register_hittable(std::make_shared<ConstantDensityMedium>(std::vector<std::shared_ptr<Hittable>> {boundary2}, 0.0001f,
+                                                                        isotropic({1.0f, 1.0f, 1.0f})));
+
+    // Earth sphere with image texture
+    auto const earth_material = textured(std::make_shared<ImageTexture>("./res/textures/images/flowers.jpg"));
+    raytracer.register_hittable(SphereRaytraced::create({400.0f, 200.0f, 400.0f}, 100.0f, earth_material));
+
+    // Noise texture sphere
+    auto const noise_material = textured(std::make_shared<NoiseTexture>(0.2f, 0));
+    raytracer.register_hittable(SphereRaytraced::create({220.0f, 280.0f, 300.0f}, 80.0f, noise_material));
+
+    // Small white spheres cluster, rotated and translated
+    auto const white_material = lambertian({0.73f, 0.73f, 0.73f});
+
+    i32 const ns = 1000;
+    for (i32 j = 0; j < ns; j++)
+    {
+        auto const center = glm::linearRand(glm::vec3 {0.0f}, glm::vec3 {165.0f});
+        auto const rotated = std::make_shared<RotateYHittable>(SphereRaytraced::create(center, 10.0f, white_material), 15.0f);
+        raytracer.register_hittable(std::make_shared<TranslateHittable>(rotated, glm::vec3 {-100.0f, 270.0f, 395.0f}));
+    }
+}
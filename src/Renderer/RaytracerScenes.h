@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class Raytracer;
+
+// Scenes from the "Ray Tracing in One Weekend" books, built directly into a raytracer.
+// Each scene sets the camera and default render settings and registers its hittables.
+class RaytracerScenes
+{
+public:
+    // Returns false if there is no scene with the given name.
+    static bool build(std::string const& name, Raytracer& raytracer);
+
+    [[nodiscard]] static std::vector<std::string> names();
+
+    static void bouncing_spheres(Raytracer& raytracer);
+    static void checkered_spheres(Raytracer& raytracer);
+    static void earth(Raytracer& raytracer);
+    static void perlin_spheres(Raytracer& raytracer);
+    static void quads(Raytracer& raytracer);
+    static void simple_light(Raytracer& raytracer);
+    static void cornell_box(Raytracer& raytracer);
+    static void cornell_smoke(Raytracer& raytracer);
+    static void cornell_fog(Raytracer& raytracer);
+    static void final_scene(Raytracer& raytracer);
+};
@@ -0,0 +1,666 @@
+#include "RaytracerSerialization.h"
+
+#include "ConstantDensityMedium.h"
+#include "EnvironmentLight.h"
+#include "HeterogeneousMedium.h"
+#include "Image.h"
+#include "MaterialCPU.h"
+#include "QuadRaytraced.h"
+#include "Raytracer.h"
+#include "RotateYHittable.h"
+#include "SphereRaytraced.h"
+#include "TextureCPU.h"
+#include "TranslateHittable.h"
+
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <yaml-cpp/yaml.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// Shared textures and materials, indexed in the order they are written.
+struct SerializationTables
+{
+    std::vector<std::shared_ptr<TextureCPU>> textures = {};
+    std::vector<std::shared_ptr<MaterialCPU>> materials = {};
+
+    std::unordered_map<TextureCPU const*, i32> texture_indices = {};
+    std::unordered_map<MaterialCPU const*, i32> material_indices = {};
+};
+
+static void write_vec3(YAML::Emitter& out, glm::vec3 const& value)
+{
+    out << YAML::Flow << YAML::BeginSeq << value.x << value.y << value.z << YAML::EndSeq;
+}
+
+static void write_vec4(YAML::Emitter& out, glm::vec4 const& value)
+{
+    out << YAML::Flow << YAML::BeginSeq << value.x << value.y << value.z << value.w << YAML::EndSeq;
+}
+
+static glm::vec3 read_vec3(YAML::Node const& node)
+{
+    return {node[0].as<float>(), node[1].as<float>(), node[2].as<float>()};
+}
+
+static glm::vec4 read_vec4(YAML::Node const& node)
+{
+    return {node[0].as<float>(), node[1].as<float>(), node[2].as<float>(), node[3].as<float>()};
+}
+
+// Children are added before their parents, so every index refers to an earlier entry when reading the lists back.
+static void collect_texture(std::shared_ptr<TextureCPU> const& texture, SerializationTables& tables)
+{
+    if (texture == nullptr || tables.texture_indices.contains(texture.get()))
+        return;
+
+    if (auto const checker = std::dynamic_pointer_cast<CheckerTexture>(texture); checker != nullptr)
+    {
+        collect_texture(checker->even(), tables);
+        collect_texture(checker->odd(), tables);
+    }
+
+    tables.texture_indices.emplace(texture.get(), static_cast<i32>(tables.textures.size()));
+    tables.textures.emplace_back(texture);
+}
+
+static void collect_material(std::shared_ptr<MaterialCPU> const& material, SerializationTables& tables)
+{
+    if (material == nullptr || tables.material_indices.contains(material.get()))
+        return;
+
+    collect_texture(material->texture, tables);
+
+    tables.material_indices.emplace(material.get(), static_cast<i32>(tables.materials.size()));
+    tables.materials.emplace_back(material);
+}
+
+static void collect_hittable(std::shared_ptr<Hittable> const& hittable, SerializationTables& tables)
+{
+    if (auto const medium = std::dynamic_pointer_cast<ConstantDensityMedium>(hittable); medium != nullptr)
+    {
+        for (auto const& boundary : medium->boundary())
+        {
+            collect_hittable(boundary, tables);
+        }
+    }
+    else if (auto const rotate = std::dynamic_pointer_cast<RotateYHittable>(hittable); rotate != nullptr)
+    {
+        collect_hittable(rotate->hittable(), tables);
+        return;
+    }
+    else if (auto const translate = std::dynamic_pointer_cast<TranslateHittable>(hittable); translate != nullptr)
+    {
+        collect_hittable(translate->hittable(), tables);
+        return;
+    }
+
+    collect_material(hittable->material, tables);
+}
+
+static void serialize_texture(YAML::Emitter& out, std::shared_ptr<TextureCPU> const& texture, SerializationTables const& tables)
+{
+    out << YAML::BeginMap;
+
+    if (auto const solid_color = std::dynamic_pointer_cast<SolidColor>(texture); solid_color != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "SolidColor";
+        out << YAML::Key << "color" << YAML::Value;
+        write_vec3(out, solid_color->color());
+    }
+    else if (auto const checker = std::dynamic_pointer_cast<CheckerTexture>(texture); checker != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "CheckerTexture";
+        out << YAML::Key << "scale" << YAML::Value << checker->scale();
+        out << YAML::Key << "even" << YAML::Value << tables.texture_indices.at(checker->even().get());
+        out << YAML::Key << "odd" << YAML::Value << tables.texture_indices.at(checker->odd().get());
+    }
+    else if (auto const image = std::dynamic_pointer_cast<ImageTexture>(texture); image != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "ImageTexture";
+        out << YAML::Key << "path" << YAML::Value << image->image()->path();
+    }
+    else if (auto const noise = std::dynamic_pointer_cast<NoiseTexture>(texture); noise != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "NoiseTexture";
+        out << YAML::Key << "scale" << YAML::Value << noise->scale();
+        out << YAML::Key << "seed" << YAML::Value << noise->seed();
+    }
+    else
+    {
+        std::cout << "Texture type is not supported by the raytracer serialization, writing it as white.\n";
+        out << YAML::Key << "Type" << YAML::Value << "SolidColor";
+        out << YAML::Key << "color" << YAML::Value;
+        write_vec3(out, glm::vec3(1.0f, 1.0f, 1.0f));
+    }
+
+    out << YAML::EndMap;
+}
+
+static void serialize_material(YAML::Emitter& out, MaterialCPU const& material, SerializationTables const& tables)
+{
+    out << YAML::BeginMap;
+    out << YAML::Key << "color" << YAML::Value;
+    write_vec4(out, material.color);
+
+    if (material.texture != nullptr)
+        out << YAML::Key << "texture" << YAML::Value << tables.texture_indices.at(material.texture.get());
+
+    out << YAML::Key << "metal" << YAML::Value << material.metal;
+    out << YAML::Key << "dielectric" << YAML::Value << material.dielectric;
+    out << YAML::Key << "emissive" << YAML::Value << material.emissive;
+    out << YAML::Key << "isotropic" << YAML::Value << material.isotropic;
+    out << YAML::Key << "fuzz" << YAML::Value << material.fuzz;
+    out << YAML::Key << "refraction_index" << YAML::Value << material.refraction_index;
+    out << YAML::EndMap;
+}
+
+static void serialize_hittable(YAML::Emitter& out, std::shared_ptr<Hittable> const& hittable, SerializationTables const& tables)
+{
+    out << YAML::BeginMap;
+
+    if (auto const sphere = std::dynamic_pointer_cast<SphereRaytraced>(hittable); sphere != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "SphereRaytraced";
+        out << YAML::Key << "center" << YAML::Value;
+        write_vec3(out, sphere->center());
+        out << YAML::Key << "radius" << YAML::Value << sphere->radius();
+        out << YAML::Key << "material" << YAML::Value << tables.material_indices.at(sphere->material.get());
+    }
+    else if (auto const quad = std::dynamic_pointer_cast<QuadRaytraced>(hittable); quad != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "QuadRaytraced";
+        out << YAML::Key << "q" << YAML::Value;
+        write_vec3(out, quad->q());
+        out << YAML::Key << "u" << YAML::Value;
+        write_vec3(out, quad->u());
+        out << YAML::Key << "v" << YAML::Value;
+        write_vec3(out, quad->v());
+        out << YAML::Key << "material" << YAML::Value << tables.material_indices.at(quad->material.get());
+    }
+    else if (auto const medium = std::dynamic_pointer_cast<ConstantDensityMedium>(hittable); medium != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "ConstantDensityMedium";
+        out << YAML::Key << "density" << YAML::Value << medium->density();
+        out << YAML::Key << "material" << YAML::Value << tables.material_indices.at(medium->material.get());
+        out << YAML::Key << "boundary" << YAML::Value << YAML::BeginSeq;
+
+        for (auto const& boundary : medium->boundary())
+        {
+            serialize_hittable(out, boundary, tables);
+        }
+
+        out << YAML::EndSeq;
+    }
+    else if (auto const medium = std::dynamic_pointer_cast<HeterogeneousMedium>(hittable); medium != nullptr)
+    {
+        MediumBoundary const& boundary = medium->boundary();
+
+        out << YAML::Key << "Type" << YAML::Value << "HeterogeneousMedium";
+        out << YAML::Key << "max_density" << YAML::Value << medium->max_density();
+        out << YAML::Key << "noise_scale" << YAML::Value << medium->noise_scale();
+        out << YAML::Key << "seed" << YAML::Value << medium->seed();
+        out << YAML::Key << "resolution" << YAML::Value << medium->resolution();
+        out << YAML::Key << "material" << YAML::Value << tables.material_indices.at(medium->material.get());
+        out << YAML::Key << "boundary" << YAML::Value << YAML::BeginMap;
+
+        if (boundary.shape == MediumBoundary::Shape::Sphere)
+        {
+            out << YAML::Key << "Shape" << YAML::Value << "Sphere";
+            out << YAML::Key << "center" << YAML::Value;
+            write_vec3(out, boundary.center);
+            out << YAML::Key << "radius" << YAML::Value << boundary.radius;
+        }
+        else
+        {
+            out << YAML::Key << "Shape" << YAML::Value << "Box";
+            out << YAML::Key << "min" << YAML::Value;
+            write_vec3(out, boundary.min);
+            out << YAML::Key << "max" << YAML::Value;
+            write_vec3(out, boundary.max);
+        }
+
+        out << YAML::EndMap;
+    }
+    else if (auto const rotate = std::dynamic_pointer_cast<RotateYHittable>(hittable); rotate != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "RotateYHittable";
+        out << YAML::Key << "angle" << YAML::Value << rotate->angle();
+
+        // Only moving instances carry their motion, static scenes read the same as before.
+        if (rotate->motion() != 0.0f)
+            out << YAML::Key << "motion" << YAML::Value << rotate->motion();
+
+        out << YAML::Key << "hittable" << YAML::Value;
+        serialize_hittable(out, rotate->hittable(), tables);
+    }
+    else if (auto const translate = std::dynamic_pointer_cast<TranslateHittable>(hittable); translate != nullptr)
+    {
+        out << YAML::Key << "Type" << YAML::Value << "TranslateHittable";
+        out << YAML::Key << "offset" << YAML::Value;
+        write_vec3(out, translate->offset());
+
+        if (translate->motion() != glm::vec3(0.0f))
+        {
+            out << YAML::Key << "motion" << YAML::Value;
+            write_vec3(out, translate->motion());
+        }
+
+        out << YAML::Key << "hittable" << YAML::Value;
+        serialize_hittable(out, translate->hittable(), tables);
+    }
+
+    out << YAML::EndMap;
+}
+
+static std::shared_ptr<TextureCPU> find_texture(YAML::Node const& node, std::vector<std::shared_ptr<TextureCPU>> const& textures)
+{
+    auto const index = node.as<i32>();
+
+    if (index < 0 || index >= static_cast<i32>(textures.size()))
+    {
+        std::cout << "Invalid texture index in raytracer scene: " << index << "\n";
+        return nullptr;
+    }
+
+    return textures[index];
+}
+
+static std::shared_ptr<MaterialCPU> find_material(YAML::Node const& node, std::vector<std::shared_ptr<MaterialCPU>> const& materials)
+{
+    auto const index = node.as<i32>();
+
+    if (index < 0 || index >= static_cast<i32>(materials.size()))
+    {
+        std::cout << "Invalid material index in raytracer scene: " << index << "\n";
+        return nullptr;
+    }
+
+    return materials[index];
+}
+
+static std::shared_ptr<TextureCPU> deserialize_texture(YAML::Node const& node, std::vector<std::shared_ptr<TextureCPU>> const& textures)
+{
+    auto const type = node["Type"].as<std::string>();
+
+    if (type == "SolidColor")
+        return std::make_shared<SolidColor>(read_vec3(node["color"]));
+
+    if (type == "CheckerTexture")
+    {
+        auto const even = find_texture(node["even"], textures);
+        auto const odd = find_texture(node["odd"], textures);
+
+        if (even == nullptr || odd == nullptr)
+            return nullptr;
+
+        return std::make_shared<CheckerTexture>(node["scale"].as<float>(), even, odd);
+    }
+
+    if (type == "ImageTexture")
+        return std::make_shared<ImageTexture>(node["path"].as<std::string>());
+
+    // Scenes written before the seed was stored used 0 for every noise.
+    if (type == "NoiseTexture")
+        return std::make_shared<NoiseTexture>(node["scale"].as<float>(), node["seed"] ? node["seed"].as<u32>() : 0);
+
+    std::cout << "Unknown texture type in raytracer scene: " << type << "\n";
+    return nullptr;
+}
+
+static std::shared_ptr<MaterialCPU> deserialize_material(YAML::Node const& node, std::vector<std::shared_ptr<TextureCPU>> const& textures)
+{
+    auto material = std::make_shared<MaterialCPU>();
+
+    if (auto const color = node["color"])
+        material->color = read_vec4(color);
+
+    if (auto const texture = node["texture"])
+    {
+        material->texture = find_texture(texture, textures);
+
+        if (material->texture == nullptr)
+            return nullptr;
+    }
+
+    if (auto const metal = node["metal"])
+        material->metal = metal.as<bool>();
+
+    if (auto const dielectric = node["dielectric"])
+        material->dielectric = dielectric.as<bool>();
+
+    if (auto const emissive = node["emissive"])
+        material->emissive = emissive.as<bool>();
+
+    if (auto const isotropic = node["isotropic"])
+        material->isotropic = isotropic.as<bool>();
+
+    if (auto const fuzz = node["fuzz"])
+        material->fuzz = fuzz.as<float>();
+
+    if (auto const refraction_index = node["refraction_index"])
+        material->refraction_index = refraction_index.as<float>();
+
+    return material;
+}
+
+static std::shared_ptr<Hittable> deserialize_hittable(YAML::Node const& node, std::vector<std::shared_ptr<MaterialCPU>> const& materials)
+{
+    auto const type = node["Type"].as<std::string>();
+
+    if (type == "SphereRaytraced" || type == "QuadRaytraced")
+    {
+        auto const material = find_material(node["material"], materials);
+
+        if (material == nullptr)
+            return nullptr;
+
+        if (type == "SphereRaytraced")
+            return SphereRaytraced::create(read_vec3(node["center"]), node["radius"].as<float>(), material);
+
+        return QuadRaytraced::create(read_vec3(node["q"]), read_vec3(node["u"]), read_vec3(node["v"]), material);
+    }
+
+    if (type == "ConstantDensityMedium")
+    {
+        auto const material = find_material(node["material"], materials);
+
+        if (material == nullptr)
+            return nullptr;
+
+        std::vector<std::shared_ptr<Hittable>> boundary = {};
+
+        for (auto const& boundary_node : node["boundary"])
+        {
+            auto const boundary_hittable = deserialize_hittable(boundary_node, materials);
+
+            if (boundary_hittable == nullptr)
+                return nullptr;
+
+            boundary.emplace_back(boundary_hittable);
+        }
+
+        return std::make_shared<ConstantDensityMedium>(boundary, node["density"].as<float>(), material);
+    }
+
+    if (type == "HeterogeneousMedium")
+    {
+        auto const material = find_material(node["material"], materials);
+
+        if (material == nullptr)
+            return nullptr;
+
+        auto const boundary_node = node["boundary"];
+        auto const shape = boundary_node["Shape"].as<std::string>();
+        MediumBoundary boundary = {};
+
+        if (shape == "Sphere")
+        {
+            boundary = MediumBoundary::sphere(read_vec3(boundary_node["center"]), boundary_node["radius"].as<float>());
+        }
+        else if (shape == "Box")
+        {
+            boundary = MediumBoundary::box(read_vec3(boundary_node["min"]), read_vec3(boundary_node["max"]));
+        }
+        else
+        {
+            std::cout << "Unknown medium boundary shape in raytracer scene: " << shape << "\n";
+            return nullptr;
+        }
+
+        u32 const seed = node["seed"] ? node["seed"].as<u32>() : 0;
+
+        return std::make_shared<HeterogeneousMedium>(boundary, node["max_density"].as<float>(), node["noise_scale"].as<float>(), seed,
+                                                     node["resolution"].as<i32>(), material);
+    }
+
+    if (type == "RotateYHittable" || type == "TranslateHittable")
+    {
+        auto const child = deserialize_hittable(node["hittable"], materials);
+
+        if (child == nullptr)
+            return nullptr;
+
+        if (type == "RotateYHittable")
+        {
+            auto const rotate = std::make_shared<RotateYHittable>(child, node["angle"].as<float>());
+
+            if (auto const motion = node["motion"])
+                rotate->set_motion(motion.as<float>());
+
+            return rotate;
+        }
+
+        auto const translate = std::make_shared<TranslateHittable>(child, read_vec3(node["offset"]));
+
+        if (auto const motion = node["motion"])
+            translate->set_motion(read_vec3(motion));
+
+        return translate;
+    }
+
+    std::cout << "Unknown hittable type in raytracer scene: " << type << "\n";
+    return nullptr;
+}
+
+void RaytracerSerialization::serialize(YAML::Emitter& out, Raytracer const& raytracer)
+{
+    SerializationTables tables = {};
+
+    for (auto const& hittable : raytracer.get_hittables())
+    {
+        collect_hittable(hittable, tables);
+    }
+
+    out << YAML::BeginMap;
+
+    out << YAML::Key << "Settings" << YAML::Value << YAML::BeginMap;
+    out << YAML::Key << "image_width" << YAML::Value << raytracer.get_image_width();
+    out << YAML::Key << "aspect_ratio" << YAML::Value << raytracer.get_aspect_ratio();
+    out << YAML::Key << "samples_per_pixel" << YAML::Value << raytracer.get_samples_per_pixel();
+    out << YAML::Key << "max_depth" << YAML::Value << raytracer.get_max_depth();
+    out << YAML::Key << "background_color" << YAML::Value;
+    write_vec3(out, raytracer.get_background_color());
+
+    if (auto const& environment = raytracer.get_environment(); environment != nullptr)
+    {
+        out << YAML::Key << "environment" << YAML::Value << YAML::BeginMap;
+        out << YAML::Key << "path" << YAML::Value << environment->image()->path();
+        out << YAML::Key << "intensity" << YAML::Value << environment->intensity();
+        out << YAML::Key << "rotation" << YAML::Value << environment->rotation();
+        out << YAML::EndMap;
+    }
+
+    out << YAML::EndMap;
+
+    RaytracerCamera const& camera = raytracer.get_camera();
+    out << YAML::Key << "Camera" << YAML::Value << YAML::BeginMap;
+    out << YAML::Key << "position" << YAML::Value;
+    write_vec3(out, camera.position);
+    out << YAML::Key << "euler_angles" << YAML::Value;
+    write_vec3(out, camera.euler_angles);
+    out << YAML::Key << "fov" << YAML::Value << camera.fov;
+    out << YAML::Key << "aperture" << YAML::Value << camera.aperture;
+    out << YAML::Key << "focus_distance" << YAML::Value << camera.focus_distance;
+    out << YAML::EndMap;
+
+    out << YAML::Key << "Textures" << YAML::Value << YAML::BeginSeq;
+
+    for (auto const& texture : tables.textures)
+    {
+        serialize_texture(out, texture, tables);
+    }
+
+    out << YAML::EndSeq;
+
+    out << YAML::Key << "Materials" << YAML::Value << YAML::BeginSeq;
+
+    for (auto const& material : tables.materials)
+    {
+        serialize_material(out, *material, tables);
+    }
+
+    out << YAML::EndSeq;
+
+    out << YAML::Key << "Hittables" << YAML::Value << YAML::BeginSeq;
+
+    for (auto const& hittable : raytracer.get_hittables())
+    {
+        serialize_hittable(out, hittable, tables);
+    }
+
+    out << YAML::EndSeq;
+
+    out << YAML::EndMap;
+}
+
+bool RaytracerSerialization::deserialize(YAML::Node const& node, Raytracer& raytracer)
+{
+    raytracer.clear();
+
+    if (auto const settings = node["Settings"])
+    {
+        if (auto const image_width = settings["image_width"])
+            raytracer.set_image_width(image_width.as<i32>());
+
+        if (auto const aspect_ratio = settings["aspect_ratio"])
+            raytracer.set_aspect_ratio(aspect_ratio.as<float>());
+
+        if (auto const samples_per_pixel = settings["samples_per_pixel"])
+            raytracer.set_samples_per_pixel(samples_per_pixel.as<i32>());
+
+        if (auto const max_depth = settings["max_depth"])
+            raytracer.set_max_depth(max_depth.as<i32>());
+
+        if (auto const background_color = settings["background_color"])
+            raytracer.set_background_color(read_vec3(background_color));
+
+        // Falls back to the background color if the image is missing, like image textures fall back to cyan.
+        if (auto const environment = settings["environment"])
+        {
+            float const intensity = environment["intensity"] ? environment["intensity"].as<float>() : 1.0f;
+            float const rotation = environment["rotation"] ? environment["rotation"].as<float>() : 0.0f;
+            raytracer.set_environment(EnvironmentLight::create(environment["path"].as<std::string>(), intensity, rotation));
+        }
+    }
+
+    if (auto const camera_node = node["Camera"])
+    {
+        RaytracerCamera camera = {};
+
+        if (auto const position = camera_node["position"])
+            camera.position = read_vec3(position);
+
+        if (auto const euler_angles = camera_node["euler_angles"])
+            camera.euler_angles = read_vec3(euler_angles);
+
+        if (auto const fov = camera_node["fov"])
+            camera.fov = fov.as<float>();
+
+        if (auto const aperture = camera_node["aperture"])
+            camera.aperture = aperture.as<float>();
+
+        if (auto const focus_distance = camera_node["focus_distance"])
+            camera.focus_distance = focus_distance.as<float>();
+
+        raytracer.set_camera(camera);
+    }
+
+    std::vector<std::shared_ptr<TextureCPU>> textures = {};
+
+    for (auto const& texture_node : node["Textures"])
+    {
+        auto const texture = deserialize_texture(texture_node, textures);
+
+        if (texture == nullptr)
+            return false;
+
+        textures.emplace_back(texture);
+    }
+
+    std::vector<std::shared_ptr<MaterialCPU>> materials = {};
+
+    for (auto const& material_node : node["Materials"])
+    {
+        auto const material = deserialize_material(material_node, textures);
+
+        if (material == nullptr)
+            return false;
+
+        materials.emplace_back(material);
+    }
+
+    for (auto const& hittable_node : node["Hittables"])
+    {
+        auto const hittable = deserialize_hittable(hittable_node, materials);
+
+        if (hittable == nullptr)
+            return false;
+
+        raytracer.register_hittable(hittable);
+    }
+
+    return true;
+}
+
+bool RaytracerSerialization::load(std::string const& path, Raytracer& raytracer)
+{
+    // yaml-cpp reports malformed files and missing or mistyped values with exceptions.
+    try
+    {
+        YAML::Node const data = YAML::LoadFile(path);
+
+        if (!data["Raytracer"])
+        {
+            std::cout << "Scene file has no Raytracer section: " << path << "\n";
+            return false;
+        }
+
+        return deserialize(data["Raytracer"], raytracer);
+    }
+    catch (YAML::Exception const& exception)
+    {
+        std::cout << "Could not load a raytracer scene: " << path << ": " << exception.what() << "\n";
+        return false;
+    }
+}
+
+bool RaytracerSerialization::save(std::string const& path, Raytracer const& raytracer, std::string const& scene_name)
+{
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    out << YAML::Key << "Scene" << YAML::Value << scene_name;
+    out << YAML::Key << "Raytracer" << YAML::Value;
+    serialize(out, raytracer);
+    out << YAML::EndMap;
+
+    std::filesystem::path const directory = std::filesystem::path(path).parent_path();
+
+    if (!directory.empty() && !std::filesystem::exists(directory))
+        std::filesystem::create_directories(directory);
+
+    std::ofstream scene_file(path);
+
+    if (!scene_file.is_open())
+    {
+        std::cout << "Could not create a scene file: " << path << "\n";
+        return false;
+    }
+
+    scene_file << out.c_str();
+    scene_file.close();
+
+    return true;
+}
+
+bool RaytracerSerialization::is_scene_file(std::string const& name)
+{
+    std::string const extension = std::filesystem::path(name).extension().string();
+
+    return extension == ".txt" || extension == ".yaml" || extension == ".yml";
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+namespace YAML
+{
+class Emitter;
+class Node;
+}
+
+class Raytracer;
+
+// Reads and writes the "Raytracer" section of a scene file: render settings, camera, textures, materials and hittables.
+// Textures and materials are stored once in their own lists and referenced by index, so shared ones stay shared.
+// Hittables are written inline, one shared between several parents (e.g. a medium boundary) is written once per parent.
+// Does not touch entities or components, scene files can be rendered without starting the engine.
+class RaytracerSerialization
+{
+public:
+    static void serialize(YAML::Emitter& out, Raytracer const& raytracer);
+
+    // Replaces the hittables, camera and settings of the raytracer with the ones from the node.
+    static bool deserialize(YAML::Node const& node, Raytracer& raytracer);
+
+    // Reads only the "Raytracer" section of the scene file, the entities in it are skipped.
+    static bool load(std::string const& path, Raytracer& raytracer);
+
+    // Writes a scene file that contains only the "Raytracer" section.
+    static bool save(std::string const& path, Raytracer const& raytracer, std::string const& scene_name);
+
+    // Scene files are recognized by their extension, everything else is treated as a built-in scene name.
+    [[nodiscard]] static bool is_scene_file(std::string const& name);
+};
@@ -0,0 +1,215 @@
+#include "RaytracerStatistics.h"
+
+#include "Framebuffer.h"
+
+#include <glm/common.hpp>
+#include <glm/vec3.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+u64 RaytracerCounters::total_primitive_tests() const
+{
+    u64 result = 0;
+
+    for (u64 const tests : primitive_tests)
+    {
+        result += tests;
+    }
+
+    return result;
+}
+
+u64 RaytracerCounters::total_rays() const
+{
+    u64 result = shadow_rays;
+
+    for (u64 const rays : rays_by_bounce)
+    {
+        result += rays;
+    }
+
+    return result;
+}
+
+void RaytracerCounters::merge(RaytracerCounters const& other)
+{
+    bvh_nodes_visited += other.bvh_nodes_visited;
+    aabb_tests += other.aabb_tests;
+    shadow_rays += other.shadow_rays;
+
+    for (size_t i = 0; i < primitive_tests.size(); ++i)
+    {
+        primitive_tests[i] += other.primitive_tests[i];
+    }
+
+    for (size_t i = 0; i < rays_by_bounce.size(); ++i)
+    {
+        rays_by_bounce[i] += other.rays_by_bounce[i];
+    }
+}
+
+RaytracerCounters& RaytracerStatistics::thread_counters()
+{
+    // Allocated once per thread and owned by the registry, so the counters survive the thread for gather().
+    thread_local RaytracerCounters* counters = nullptr;
+
+    if (counters == nullptr)
+    {
+        std::lock_guard lock(m_mutex);
+        counters = m_thread_counters.emplace_back(std::make_unique<RaytracerCounters>()).get();
+    }
+
+    return *counters;
+}
+
+RaytracerCounters RaytracerStatistics::gather()
+{
+    std::lock_guard lock(m_mutex);
+
+    RaytracerCounters result = {};
+
+    for (auto const& counters : m_thread_counters)
+    {
+        result.merge(*counters);
+    }
+
+    return result;
+}
+
+void RaytracerStatistics::reset()
+{
+    std::lock_guard lock(m_mutex);
+
+    for (auto const& counters : m_thread_counters)
+    {
+        *counters = {};
+    }
+}
+
+void RaytracerStatistics::begin_heatmap(i32 const width, i32 const height)
+{
+    m_heatmap_width = width;
+    m_heatmap_height = height;
+    m_heatmap.assign(static_cast<size_t>(width) * static_cast<size_t>(height), 0.0f);
+}
+
+void RaytracerStatistics::add_heatmap_cost(i32 const index, float const cost)
+{
+    m_heatmap[index] += cost;
+}
+
+void RaytracerStatistics::print_summary(double const render_seconds)
+{
+    RaytracerCounters const counters = gather();
+
+    u64 const camera_rays = counters.rays_by_bounce[0];
+    u64 const total_rays = counters.total_rays();
+    double const rays_divisor = total_rays > 0 ? static_cast<double>(total_rays) : 1.0;
+
+    std::clog << "Raytracer statistics\n";
+    std::clog << "  Render time:          " << render_seconds << " s\n";
+    std::clog << "  Rays:                 " << total_rays << " (" << camera_rays << " camera, " << counters.shadow_rays << " shadow)\n";
+
+    if (render_seconds > 0.0)
+        std::clog << "  Rays per second:      " << static_cast<double>(total_rays) / render_seconds << '\n';
+
+    std::clog << "  BVH nodes visited:    " << counters.bvh_nodes_visited << " ("
+              << static_cast<double>(counters.bvh_nodes_visited) / rays_divisor << " per ray)\n";
+    std::clog << "  AABB tests:           " << counters.aabb_tests << " (" << static_cast<double>(counters.aabb_tests) / rays_divisor
+              << " per ray)\n";
+    std::clog << "  Primitive tests:      " << counters.total_primitive_tests() << " ("
+              << static_cast<double>(counters.total_primitive_tests()) / rays_divisor << " per ray)\n";
+
+    for (size_t i = 0; i < counters.primitive_tests.size(); ++i)
+    {
+        if (counters.primitive_tests[i] == 0)
+            continue;
+
+        std::clog << "    " << primitive_name(static_cast<PrimitiveType>(i)) << ": " << counters.primitive_tests[i] << '\n';
+    }
+
+    std::clog << "  Rays by bounce:\n";
+
+    for (size_t i = 0; i < counters.rays_by_bounce.size(); ++i)
+    {
+        if (counters.rays_by_bounce[i] == 0)
+            continue;
+
+        bool const is_last = i == counters.rays_by_bounce.size() - 1;
+        std::clog << "    " << i << (is_last ? "+" : "") << ": " << counters.rays_by_bounce[i] << '\n';
+    }
+}
+
+void RaytracerStatistics::write_heatmap(std::string const& path, Framebuffer const& framebuffer)
+{
+    if (m_heatmap.empty())
+        return;
+
+    // Average cost per sample, normalized by the most expensive pixel.
+    std::vector<float> cost(m_heatmap.size(), 0.0f);
+    float max_cost = 0.0001f;
+
+    for (size_t i = 0; i < m_heatmap.size(); ++i)
+    {
+        u32 const samples = framebuffer.sample_count(static_cast<i32>(i));
+
+        if (samples == 0)
+            continue;
+
+        cost[i] = m_heatmap[i] / static_cast<float>(samples);
+        max_cost = std::max(max_cost, cost[i]);
+    }
+
+    // Blue (cheap) -> cyan -> green -> yellow -> red (expensive).
+    std::array<glm::vec3, 5> constexpr gradient = {
+        glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+        glm::vec3(1.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f),
+    };
+
+    std::string buffer = {};
+    buffer.reserve(cost.size() * 12);
+
+    for (float const value : cost)
+    {
+        float const position = glm::clamp(value / max_cost, 0.0f, 1.0f) * static_cast<float>(gradient.size() - 1);
+        auto const segment = std::min(static_cast<size_t>(position), gradient.size() - 2);
+        glm::vec3 const color = glm::mix(gradient[segment], gradient[segment + 1], position - static_cast<float>(segment));
+
+        buffer += std::to_string(static_cast<i32>(color.r * 255.0f)) + ' ' + std::to_string(static_cast<i32>(color.g * 255.0f)) + ' '
+                + std::to_string(static_cast<i32>(color.b * 255.0f)) + '\n';
+    }
+
+    std::ofstream output(path);
+
+    output << "P3\n" << m_heatmap_width << ' ' << m_heatmap_height << "\n255\n";
+    output << buffer;
+
+    output.close();
+
+    std::clog << "  Heatmap:              " << path << " (max " << max_cost << " tests per sample)\n";
+}
+
+std::string RaytracerStatistics::primitive_name(PrimitiveType const type)
+{
+    switch (type)
+    {
+    case PrimitiveType::Sphere:
+        return "Sphere";
+    case PrimitiveType::Quad:
+        return "Quad";
+    case PrimitiveType::Triangle:
+        return "Triangle";
+    case PrimitiveType::ConstantDensityMedium:
+        return "ConstantDensityMedium";
+    case PrimitiveType::HeterogeneousMedium:
+        return "HeterogeneousMedium";
+    case PrimitiveType::RotateY:
+        return "RotateY";
+    case PrimitiveType::Translate:
+        return "Translate";
+    default:
+        return "Unknown";
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "AK/Types.h"
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Framebuffer;
+
+// Traversal statistics are compiled out unless RAYTRACER_STATISTICS is defined to true (see the CMake option of the same name).
+// When disabled every RAYTRACER_STAT_* macro expands to nothing, so the hot paths are not affected at all.
+#ifndef RAYTRACER_STATISTICS
+#define RAYTRACER_STATISTICS false
+#endif
+
+enum class PrimitiveType : u8
+{
+    Sphere = 0,
+    Quad,
+    Triangle,
+    ConstantDensityMedium,
+    HeterogeneousMedium,
+    RotateY,
+    Translate,
+    Count,
+};
+
+struct RaytracerCounters
+{
+    static i32 constexpr max_tracked_bounces = 64;
+
+    u64 bvh_nodes_visited = 0;
+    u64 aabb_tests = 0;
+    u64 shadow_rays = 0;
+    std::array<u64, static_cast<size_t>(PrimitiveType::Count)> primitive_tests = {};
+
+    // The last element collects every bounce past max_tracked_bounces.
+    std::array<u64, max_tracked_bounces> rays_by_bounce = {};
+
+    [[nodiscard]] u64 total_primitive_tests() const;
+    [[nodiscard]] u64 total_rays() const;
+
+    void merge(RaytracerCounters const& other);
+};
+
+class RaytracerStatistics
+{
+public:
+    // Counters of the calling thread. Each thread gets its own instance, so incrementing needs no synchronization.
+    static RaytracerCounters& thread_counters();
+
+    // Sums the counters of every thread that has touched them. Not safe to call while rendering.
+    [[nodiscard]] static RaytracerCounters gather();
+    static void reset();
+
+    static void begin_heatmap(i32 const width, i32 const height);
+    static void add_heatmap_cost(i32 const index, float const cost);
+
+    static void print_summary(double const render_seconds);
+
+    // Writes the per-pixel cost (BVH nodes visited and primitives tested per sample) as a blue-to-red heatmap.
+    static void write_heatmap(std::string const& path, Framebuffer const& framebuffer);
+
+    [[nodiscard]] static std::string primitive_name(PrimitiveType const type);
+
+private:
+    inline static std::mutex m_mutex = {};
+    inline static std::vector<std::unique_ptr<RaytracerCounters>> m_thread_counters = {};
+
+    inline static i32 m_heatmap_width = 0;
+    inline static i32 m_heatmap_height = 0;
+    inline static std::vector<float> m_heatmap = {};
+};
+
+#if RAYTRACER_STATISTICS
+#define RAYTRACER_STAT_ADD(counter, value) (RaytracerStatistics::thread_counters().counter += (value))
+#define RAYTRACER_STAT_PRIMITIVE_TEST(type) (RaytracerStatistics::thread_counters().primitive_tests[static_cast<size_t>(type)] += 1)
+#define RAYTRACER_STAT_RAY(bounce)                                                                               \
+    (RaytracerStatistics::thread_counters()                                                                      \
+         .rays_by_bounce[(bounce) < RaytracerCounters::max_tracked_bounces ? (bounce)                            \
+                                                                           : RaytracerCounters::max_tracked_bounces - 1] += 1)
+#else
+#define RAYTRACER_STAT_ADD(counter, value)
+#define RAYTRACER_STAT_PRIMITIVE_TEST(type)
+#define RAYTRACER_STAT_RAY(bounce)
+#endif
@@ -0,0 +1,124 @@
+#include "RenderCheckpoint.h"
+
+#include "AK/AK.h"
+#include "Framebuffer.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+struct RenderCheckpointHeader
+{
+    u32 magic = 0;
+    u32 version = 0;
+    u64 scene_hash = 0;
+    i32 width = 0;
+    i32 height = 0;
+    u32 enabled_aovs = 0;
+    u32 row_count = 0;
+};
+
+bool RenderCheckpoint::write(std::string const& path, u64 const scene_hash, Framebuffer const& framebuffer,
+                             std::vector<i32> const& finished_rows)
+{
+    std::error_code error = {};
+    std::filesystem::path const parent = std::filesystem::path(path).parent_path();
+
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+
+    RenderCheckpointHeader header = {};
+    header.magic = magic;
+    header.version = version;
+    header.scene_hash = scene_hash;
+    header.width = framebuffer.width();
+    header.height = framebuffer.height();
+    header.enabled_aovs = framebuffer.enabled_aovs();
+    header.row_count = static_cast<u32>(finished_rows.size());
+
+    // Written under a temporary name and renamed, so a crash while writing leaves the last checkpoint intact. The name is
+    // random, two renders given the same checkpoint path do not write into the same file.
+    std::string const temporary_path = path + "." + AK::generate_hex(8) + ".tmp";
+
+    std::ofstream output(temporary_path, std::ios::binary);
+
+    if (!output.is_open())
+    {
+        std::clog << "Could not write a render checkpoint: " << path << "\n";
+        return false;
+    }
+
+    output.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    output.write(reinterpret_cast<char const*>(finished_rows.data()), static_cast<std::streamsize>(finished_rows.size() * sizeof(i32)));
+
+    for (i32 const row : finished_rows)
+    {
+        framebuffer.write_row(output, row);
+    }
+
+    // Every byte has to be written out before the rename replaces the previous checkpoint.
+    output.flush();
+    output.close();
+
+    if (!output)
+    {
+        std::clog << "Could not write a render checkpoint: " << path << "\n";
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    std::filesystem::rename(temporary_path, path, error);
+
+    if (error)
+    {
+        std::clog << "Could not write a render checkpoint: " << path << "\n";
+        std::filesystem::remove(temporary_path, error);
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<i32> RenderCheckpoint::read(std::string const& path, u64 const scene_hash, Framebuffer& framebuffer)
+{
+    framebuffer.clear();
+
+    std::ifstream input(path, std::ios::binary);
+
+    if (!input.is_open())
+        return {};
+
+    RenderCheckpointHeader header = {};
+    input.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    bool const is_valid = input && header.magic == magic && header.version == version && header.scene_hash == scene_hash
+                       && header.width == framebuffer.width() && header.height == framebuffer.height()
+                       && header.enabled_aovs == framebuffer.enabled_aovs() && header.row_count <= static_cast<u32>(header.height);
+
+    if (!is_valid)
+    {
+        std::clog << "Ignoring a render checkpoint of a different scene or different settings: " << path << "\n";
+        return {};
+    }
+
+    std::vector<i32> finished_rows(header.row_count);
+    input.read(reinterpret_cast<char*>(finished_rows.data()), static_cast<std::streamsize>(finished_rows.size() * sizeof(i32)));
+
+    for (i32 const row : finished_rows)
+    {
+        if (!input || row < 0 || row >= header.height || !framebuffer.read_row(input, row))
+        {
+            std::clog << "Ignoring a damaged render checkpoint: " << path << "\n";
+            framebuffer.clear();
+            return {};
+        }
+    }
+
+    return finished_rows;
+}
+
+void RenderCheckpoint::remove(std::string const& path)
+{
+    std::error_code error = {};
+    std::filesystem::remove(path, error);
+}
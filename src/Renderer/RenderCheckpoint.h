@@ -0,0 +1,32 @@
+#pragma once
+
+#include "AK/Types.h"
+
+#include <string>
+#include <vector>
+
+class Framebuffer;
+
+// Progress of a render on disk, so an interrupted render continues where it stopped instead of starting over.
+// Rows are the unit of progress: every row is rendered with its own random seed, so a resumed render produces
+// the same image as an uninterrupted one, with any number of threads.
+//
+// The file is a header, the indices of the finished rows and the raw framebuffer data of those rows. The header
+// holds a hash of everything the image depends on, a checkpoint of another scene or other settings is never resumed.
+class RenderCheckpoint
+{
+public:
+    // Written under a temporary name and renamed over the previous checkpoint, so an interruption while writing
+    // leaves the previous one intact.
+    static bool write(std::string const& path, u64 const scene_hash, Framebuffer const& framebuffer, std::vector<i32> const& finished_rows);
+
+    // Fills the finished rows of the framebuffer and returns their indices. Returns no rows and leaves the framebuffer
+    // cleared if there is no checkpoint or it does not match the scene hash and framebuffer layout.
+    [[nodiscard]] static std::vector<i32> read(std::string const& path, u64 const scene_hash, Framebuffer& framebuffer);
+
+    static void remove(std::string const& path);
+
+private:
+    static u32 constexpr version = 2;
+    static u32 constexpr magic = 0x504B4352; // "RCKP"
+};
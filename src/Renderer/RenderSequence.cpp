@@ -0,0 +1,254 @@
+#include "RenderSequence.h"
+
+#include "AK/AABB.h"
+#include "AK/Math.h"
+#include "Framebuffer.h"
+#include "Raytracer.h"
+#include "RotateYHittable.h"
+#include "TranslateHittable.h"
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+static RaytracerCamera interpolate(RaytracerCamera const& a, RaytracerCamera const& b, float const t)
+{
+    return {glm::mix(a.position, b.position, t), glm::mix(a.euler_angles, b.euler_angles, t), glm::mix(a.fov, b.fov, t),
+            glm::mix(a.aperture, b.aperture, t), glm::mix(a.focus_distance, b.focus_distance, t)};
+}
+
+static InstancePose interpolate(InstancePose const& a, InstancePose const& b, float const t)
+{
+    return {glm::mix(a.offset, b.offset, t), glm::mix(a.angle, b.angle, t)};
+}
+
+template<typename T>
+static T sample_track(std::vector<Keyframe<T>> const& keyframes, float const time)
+{
+    auto const next = std::ranges::upper_bound(keyframes, time, {}, &Keyframe<T>::time);
+
+    if (next == keyframes.begin())
+        return keyframes.front().value;
+
+    if (next == keyframes.end())
+        return keyframes.back().value;
+
+    auto const previous = next - 1;
+    float const t = (time - previous->time) / (next->time - previous->time);
+
+    return interpolate(previous->value, next->value, t);
+}
+
+static bool is_same_camera(RaytracerCamera const& a, RaytracerCamera const& b)
+{
+    return a.position == b.position && a.euler_angles == b.euler_angles && a.fov == b.fov && a.aperture == b.aperture
+        && a.focus_distance == b.focus_distance;
+}
+
+// The instance moves from the open to the close pose while the shutter is open.
+static void apply_pose(TranslateHittable& instance, InstancePose const& open, InstancePose const& close)
+{
+    // Rotated first, the translation picks up the new bounds of the rotation.
+    if (auto const rotated = std::dynamic_pointer_cast<RotateYHittable>(instance.hittable()); rotated != nullptr)
+    {
+        rotated->set_angle(open.angle);
+        rotated->set_motion(close.angle - open.angle);
+    }
+
+    instance.set_offset(open.offset);
+    instance.set_motion(close.offset - open.offset);
+}
+
+// Slightly larger than the instance, so pixels only partly covered by it still count as covered even though
+// their center ray misses it.
+static AABB padded_bounds(AABB const& bounds)
+{
+    float constexpr padding = 0.02f;
+
+    return {bounds.x.expand(bounds.x.size() * padding), bounds.y.expand(bounds.y.size() * padding),
+            bounds.z.expand(bounds.z.size() * padding)};
+}
+
+std::shared_ptr<RenderSequence> RenderSequence::create(std::shared_ptr<Raytracer> const& raytracer)
+{
+    return std::make_shared<RenderSequence>(AK::Badge<RenderSequence> {}, raytracer);
+}
+
+RenderSequence::RenderSequence(AK::Badge<RenderSequence>, std::shared_ptr<Raytracer> const& raytracer) : m_raytracer(raytracer)
+{
+}
+
+void RenderSequence::set_camera_track(std::vector<Keyframe<RaytracerCamera>> const& keyframes)
+{
+    m_camera_track = keyframes;
+}
+
+void RenderSequence::add_instance_track(std::shared_ptr<TranslateHittable> const& instance,
+                                        std::vector<Keyframe<InstancePose>> const& keyframes)
+{
+    if (keyframes.empty())
+        return;
+
+    m_instance_tracks.emplace_back(instance, keyframes);
+}
+
+void RenderSequence::set_frame_rate(float const frames_per_second)
+{
+    m_frame_rate = frames_per_second;
+}
+
+void RenderSequence::set_temporal_accumulation(bool const temporal_accumulation)
+{
+    m_temporal_accumulation = temporal_accumulation;
+}
+
+void RenderSequence::set_shutter(float const shutter)
+{
+    m_shutter = shutter;
+}
+
+bool RenderSequence::render(i32 const frame_count, std::string const& output_path)
+{
+    if (frame_count <= 0 || m_frame_rate <= 0.0f)
+    {
+        std::cout << "A sequence needs at least one frame and a positive frame rate.\n";
+        return false;
+    }
+
+    Raytracer& raytracer = *m_raytracer;
+
+    std::filesystem::path const path = output_path;
+    std::string const directory = path.has_parent_path() ? path.parent_path().string() : ".";
+    std::string const extension = path.has_extension() ? path.extension().string() : ".ppm";
+    FramebufferFormat const format = extension == ".pfm" ? FramebufferFormat::PFM : FramebufferFormat::PPM;
+
+    u64 const base_seed = raytracer.get_seed();
+    u32 const samples_per_pixel = static_cast<u32>(raytracer.get_samples_per_pixel());
+    u32 const kept_pixel_samples = std::max(1u, samples_per_pixel / 4);
+    u32 const max_history_samples = max_history_frames * samples_per_pixel;
+    float const shutter_time = m_shutter / m_frame_rate;
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    RaytracerCamera previous_camera = {};
+    std::vector<AABB> previous_bounds = {};
+    std::shared_ptr<Framebuffer> previous_framebuffer = {};
+
+    std::vector<AABB> bounds = {};
+    std::vector<u32> pixel_samples = {};
+
+    // Writes the previous frame while the current one renders.
+    std::thread save_thread = {};
+
+    for (i32 frame = 0; frame < frame_count; ++frame)
+    {
+        auto const frame_start_time = std::chrono::steady_clock::now();
+        float const time = static_cast<float>(frame) / m_frame_rate;
+
+        if (!m_camera_track.empty())
+            raytracer.set_camera(sample_track(m_camera_track, time));
+
+        bounds.clear();
+
+        for (auto const& track : m_instance_tracks)
+        {
+            apply_pose(*track.instance, sample_track(track.keyframes, time), sample_track(track.keyframes, time + shutter_time));
+            bounds.emplace_back(padded_bounds(track.instance->bounding_box()));
+        }
+
+        // Also the first frame, the BVH may have been built before the instances got their first pose.
+        if (!m_instance_tracks.empty())
+            raytracer.refit_bvh();
+
+        raytracer.initialize();
+
+        // Every frame gets new random sequences, reused pixels would otherwise only repeat the samples they already have.
+        raytracer.set_seed(base_seed + static_cast<u64>(frame));
+
+        bool const is_reusing = m_temporal_accumulation && previous_framebuffer != nullptr
+                             && is_same_camera(raytracer.get_camera(), previous_camera);
+
+        i32 const width = raytracer.get_image_width();
+        i32 const height = raytracer.get_image_height();
+        i32 kept_pixel_count = 0;
+
+        pixel_samples.clear();
+
+        if (is_reusing)
+        {
+            // The previous frame may still be saving, it is copied rather than changed.
+            auto const framebuffer = previous_framebuffer->clone();
+            raytracer.set_framebuffer(framebuffer);
+
+            pixel_samples.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+
+            for (i32 k = 0; k < height; ++k)
+            {
+                for (i32 i = 0; i < width; ++i)
+                {
+                    i32 const index = k * width + i;
+                    Ray const ray = raytracer.get_pixel_center_ray(i, k);
+                    Interval const ray_t = Interval(0.001f, AK::INFINITY_F);
+
+                    auto const is_covered = [&](AABB const& bbox) { return bbox.hit(ray, ray_t); };
+                    bool const is_dynamic = std::ranges::any_of(bounds, is_covered) || std::ranges::any_of(previous_bounds, is_covered);
+
+                    if (is_dynamic)
+                    {
+                        framebuffer->clear_pixel(index);
+                        pixel_samples[index] = samples_per_pixel;
+                        continue;
+                    }
+
+                    framebuffer->limit_sample_count(index, max_history_samples - kept_pixel_samples);
+                    pixel_samples[index] = kept_pixel_samples;
+                    kept_pixel_count += 1;
+                }
+            }
+        }
+        else
+        {
+            raytracer.reset_framebuffer();
+        }
+
+        raytracer.render_rows(pixel_samples);
+
+        if (save_thread.joinable())
+            save_thread.join();
+
+        std::ostringstream file_name = {};
+        file_name << path.stem().string() << '_' << std::setw(4) << std::setfill('0') << frame << extension;
+
+        save_thread = std::thread([framebuffer = raytracer.get_framebuffer(), directory, file_name = file_name.str(), format] {
+            framebuffer->save(directory, file_name, format);
+        });
+
+        previous_camera = raytracer.get_camera();
+        previous_bounds = bounds;
+        previous_framebuffer = raytracer.get_framebuffer();
+
+        std::chrono::duration<double> const frame_time = std::chrono::steady_clock::now() - frame_start_time;
+        std::clog << "Frame " << (frame + 1) << "/" << frame_count << ": " << frame_time.count() << " s";
+
+        if (is_reusing)
+            std::clog << " (" << 100 * kept_pixel_count / (width * height) << "% of the pixels kept)";
+
+        std::clog << '\n';
+    }
+
+    if (save_thread.joinable())
+        save_thread.join();
+
+    raytracer.set_seed(base_seed);
+
+    std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time;
+    std::clog << "Sequence time: " << render_time.count() << " s (" << frame_count << " frames)\n";
+
+    return true;
+}
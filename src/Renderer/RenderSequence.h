@@ -0,0 +1,84 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "AK/Types.h"
+#include "RaytracerCamera.h"
+
+#include <glm/vec3.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class Raytracer;
+class TranslateHittable;
+
+template<typename T>
+struct Keyframe
+{
+    // Seconds from the start of the sequence.
+    float time = 0.0f;
+    T value = {};
+};
+
+// Placement of an instance: the offset of a TranslateHittable and the angle of the RotateYHittable it wraps, if it wraps one.
+struct InstancePose
+{
+    glm::vec3 offset = {};
+    float angle = 0.0f;
+};
+
+// Renders an animation into numbered images next to the output path (image_0000.ppm, image_0001.ppm, ...).
+// Tracks are sampled at the time of every frame, values between two keyframes are interpolated linearly.
+//
+// The scene is set up once. Later frames refit the BVH to the moved instances instead of rebuilding it, so hittables
+// cannot be added or removed during the sequence. Saving a frame overlaps tracing the next one.
+//
+// With temporal accumulation, pixels not covered by an animated instance in this or the previous frame keep the samples
+// of the previous frame and only get a quarter of the samples per pixel on top. A moving camera starts every pixel over.
+// Shadows and reflections of moving instances on the kept pixels lag behind by up to max_history_frames.
+//
+// With an open shutter, instances are motion blurred along their tracks within a single render of every frame.
+// The blur follows a straight line (or a turn) from the pose when the shutter opens to the pose when it closes.
+// The camera is not blurred.
+class RenderSequence
+{
+public:
+    static std::shared_ptr<RenderSequence> create(std::shared_ptr<Raytracer> const& raytracer);
+
+    explicit RenderSequence(AK::Badge<RenderSequence>, std::shared_ptr<Raytracer> const& raytracer);
+
+    // Keyframes have to be sorted by time. Without a track the camera of the raytracer is used for every frame.
+    void set_camera_track(std::vector<Keyframe<RaytracerCamera>> const& keyframes);
+
+    // The instance has to be registered with the raytracer directly, not through another hittable.
+    void add_instance_track(std::shared_ptr<TranslateHittable> const& instance, std::vector<Keyframe<InstancePose>> const& keyframes);
+
+    void set_frame_rate(float const frames_per_second);
+    void set_temporal_accumulation(bool const temporal_accumulation);
+
+    // Part of the frame interval the shutter stays open for, 0.5 is a 180 degree shutter. 0 disables motion blur (default).
+    void set_shutter(float const shutter);
+
+    // Frame i is rendered at i / frame rate seconds. Initializes the raytracer itself.
+    bool render(i32 const frame_count, std::string const& output_path);
+
+    // Kept pixels hold at most this many frames worth of samples.
+    static u32 constexpr max_history_frames = 2;
+
+private:
+    struct InstanceTrack
+    {
+        std::shared_ptr<TranslateHittable> instance = {};
+        std::vector<Keyframe<InstancePose>> keyframes = {};
+    };
+
+    std::shared_ptr<Raytracer> m_raytracer = {};
+
+    std::vector<Keyframe<RaytracerCamera>> m_camera_track = {};
+    std::vector<InstanceTrack> m_instance_tracks = {};
+
+    float m_frame_rate = 24.0f;
+    bool m_temporal_accumulation = false;
+    float m_shutter = 0.0f;
+};
@@ -0,0 +1,677 @@
+#include "RenderServer.h"
+
+#include "Raytracer.h"
+#include "RaytracerScenes.h"
+#include "RaytracerSerialization.h"
+
+#include <glm/trigonometric.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static std::optional<i32> parse_int(std::string_view const value)
+{
+    i32 result = 0;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if (error != std::errc() || end != value.data() + value.size())
+        return std::nullopt;
+
+    return result;
+}
+
+static std::optional<float> parse_float(std::string_view const value)
+{
+    float result = 0.0f;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if (error != std::errc() || end != value.data() + value.size())
+        return std::nullopt;
+
+    return result;
+}
+
+static std::string_view budget_mode_name(RenderBudgetMode const mode)
+{
+    switch (mode)
+    {
+    case RenderBudgetMode::Samples:
+        return "samples";
+    case RenderBudgetMode::Time:
+        return "time";
+    case RenderBudgetMode::Error:
+        return "error";
+    }
+
+    return "samples";
+}
+
+static std::optional<glm::vec3> parse_vec3(std::string_view const value)
+{
+    glm::vec3 result = {};
+    size_t start = 0;
+
+    for (i32 i = 0; i < 3; ++i)
+    {
+        size_t const end = i < 2 ? value.find(',', start) : value.size();
+
+        if (end == std::string_view::npos)
+            return std::nullopt;
+
+        auto const component = parse_float(value.substr(start, end - start));
+
+        if (!component.has_value())
+            return std::nullopt;
+
+        result[i] = *component;
+        start = end + 1;
+    }
+
+    return result;
+}
+
+std::shared_ptr<RenderServer> RenderServer::create(i32 const thread_count)
+{
+    return std::make_shared<RenderServer>(AK::Badge<RenderServer> {}, thread_count);
+}
+
+RenderServer::RenderServer(AK::Badge<RenderServer>, i32 const thread_count) : m_thread_count(thread_count)
+{
+}
+
+std::string RenderServer::handle_request(std::string const& request)
+{
+    std::istringstream stream(request);
+    std::vector<std::string> arguments = {};
+
+    for (std::string argument; stream >> argument;)
+    {
+        arguments.emplace_back(argument);
+    }
+
+    if (arguments.empty())
+        return "error empty request";
+
+    std::string const& command = arguments[0];
+
+    if (command == "submit")
+        return submit(arguments);
+
+    std::lock_guard const lock(m_mutex);
+
+    if (command == "shutdown")
+    {
+        m_is_stopping = true;
+
+        for (auto& [id, record] : m_jobs)
+        {
+            record.is_cancelled = true;
+        }
+
+        m_job_available.notify_all();
+        return "ok";
+    }
+
+    if ((command != "status" && command != "cancel") || arguments.size() != 2)
+        return "error unknown request '" + request + "'";
+
+    auto const id = parse_int(arguments[1]);
+    auto const it = id.has_value() ? m_jobs.find(static_cast<u32>(*id)) : m_jobs.end();
+
+    if (it == m_jobs.end())
+        return "error no job " + arguments[1];
+
+    JobRecord& record = it->second;
+
+    if (command == "cancel")
+    {
+        // A running job stops at its next row, a queued one never starts.
+        record.is_cancelled = true;
+
+        if (record.state == RenderJobState::Queued)
+        {
+            record.state = RenderJobState::Cancelled;
+            m_queue.erase({record.job.priority, it->first});
+            retire_job(it->first);
+        }
+
+        return "ok";
+    }
+
+    std::ostringstream response;
+    response << "ok ";
+
+    switch (record.state)
+    {
+    case RenderJobState::Queued:
+        response << "queued";
+        break;
+    case RenderJobState::Running:
+        if (record.raytracer != nullptr)
+            response << "running " << record.raytracer->get_finished_row_count() << "/" << record.raytracer->get_image_height();
+        else
+            response << "running 0/0";
+        break;
+    case RenderJobState::Done:
+        response << "done " << record.setup_time << " " << record.render_time << " " << record.samples_per_pixel << " "
+                 << record.estimated_error << " " << budget_mode_name(record.stopped_by);
+        break;
+    case RenderJobState::Cancelled:
+        response << "cancelled";
+        break;
+    case RenderJobState::Failed:
+        response << "failed " << record.error;
+        break;
+    }
+
+    return response.str();
+}
+
+std::string RenderServer::submit(std::vector<std::string> const& arguments)
+{
+    if (arguments.size() < 2)
+        return "error no scene given";
+
+    RenderJob job = {};
+    job.scene = arguments[1];
+
+    for (size_t i = 2; i < arguments.size(); ++i)
+    {
+        std::string_view const argument = arguments[i];
+        size_t const separator = argument.find('=');
+
+        if (separator == std::string_view::npos)
+            return "error expected key=value, got '" + arguments[i] + "'";
+
+        std::string_view const key = argument.substr(0, separator);
+        std::string_view const value = argument.substr(separator + 1);
+
+        if (key == "output")
+        {
+            job.output = value;
+            continue;
+        }
+
+        if (key == "position" || key == "rotation")
+        {
+            auto const vector = parse_vec3(value);
+
+            if (!vector.has_value())
+                return "error invalid vector '" + std::string(value) + "'";
+
+            (key == "position" ? job.position : job.euler_angles) = *vector;
+            continue;
+        }
+
+        if (key == "fov")
+        {
+            auto const fov = parse_float(value);
+
+            if (!fov.has_value() || *fov <= 0.0f)
+                return "error invalid fov '" + std::string(value) + "'";
+
+            job.fov = glm::radians(*fov);
+            continue;
+        }
+
+        if (key == "time" || key == "error")
+        {
+            auto const budget = parse_float(value);
+
+            if (!budget.has_value() || *budget < 0.0f)
+                return "error invalid " + std::string(key) + " '" + std::string(value) + "'";
+
+            if (key == "time")
+                job.time_budget = *budget;
+            else
+                job.target_error = *budget;
+
+            continue;
+        }
+
+        if (key == "aperture" || key == "focus")
+        {
+            auto const distance = parse_float(value);
+
+            if (!distance.has_value() || *distance < 0.0f)
+                return "error invalid " + std::string(key) + " '" + std::string(value) + "'";
+
+            (key == "aperture" ? job.aperture : job.focus_distance) = *distance;
+            continue;
+        }
+
+        auto const number = parse_int(value);
+
+        if (!number.has_value() || (*number < 0 && key != "priority"))
+            return "error invalid value '" + std::string(value) + "' for " + std::string(key);
+
+        if (key == "priority")
+            job.priority = *number;
+        else if (key == "width")
+            job.width = *number;
+        else if (key == "height")
+            job.height = *number;
+        else if (key == "spp")
+            job.samples_per_pixel = *number;
+        else if (key == "depth")
+            job.max_depth = *number;
+        else if (key == "seed")
+            job.seed = static_cast<u64>(*number);
+        else if (key == "bake")
+            job.bake_resolution = *number;
+        else if (key == "hit_cache")
+            job.hit_cache_strata = *number;
+        else if (key == "max_spp")
+            job.max_samples_per_pixel = *number;
+        else
+            return "error unknown setting " + std::string(key);
+    }
+
+    std::lock_guard const lock(m_mutex);
+
+    u32 const id = m_next_job_id;
+    m_next_job_id += 1;
+
+    m_jobs[id].job = job;
+    m_queue.insert({job.priority, id});
+    m_job_available.notify_one();
+
+    return "ok " + std::to_string(id);
+}
+
+RenderServer::JobRecord* RenderServer::next_queued_job()
+{
+    if (m_queue.empty())
+        return nullptr;
+
+    return &m_jobs.at(m_queue.begin()->id);
+}
+
+void RenderServer::retire_job(u32 const id)
+{
+    m_finished_jobs.emplace_back(id);
+
+    while (m_finished_jobs.size() > max_finished_jobs)
+    {
+        m_jobs.erase(m_finished_jobs.front());
+        m_finished_jobs.pop_front();
+    }
+}
+
+void RenderServer::process_jobs()
+{
+    while (true)
+    {
+        JobRecord* record = nullptr;
+        u32 id = 0;
+
+        {
+            std::unique_lock lock(m_mutex);
+            m_job_available.wait(lock, [this] { return m_is_stopping || !m_queue.empty(); });
+
+            if (m_is_stopping)
+                return;
+
+            id = m_queue.begin()->id;
+            record = next_queued_job();
+            record->state = RenderJobState::Running;
+            m_queue.erase(m_queue.begin());
+        }
+
+        // Only the job thread retires running jobs, so the record stays valid while it renders.
+        render_job(*record);
+
+        std::lock_guard const lock(m_mutex);
+        retire_job(id);
+    }
+}
+
+void RenderServer::render_job(JobRecord& record)
+{
+    RenderJob const& job = record.job;
+    auto const start_time = std::chrono::steady_clock::now();
+
+    std::string error = {};
+    CachedScene* scene = acquire_scene(job.scene, error);
+
+    if (scene == nullptr)
+    {
+        std::lock_guard const lock(m_mutex);
+        record.state = RenderJobState::Failed;
+        record.error = error;
+        return;
+    }
+
+    Raytracer& raytracer = *scene->raytracer;
+
+    raytracer.set_camera(scene->camera);
+    raytracer.set_image_width(scene->image_width);
+    raytracer.set_aspect_ratio(scene->aspect_ratio);
+    raytracer.set_samples_per_pixel(scene->samples_per_pixel);
+    raytracer.set_max_depth(scene->max_depth);
+
+    RaytracerCamera camera = scene->camera;
+    camera.position = job.position.value_or(camera.position);
+    camera.euler_angles = job.euler_angles.value_or(camera.euler_angles);
+    camera.fov = job.fov.value_or(camera.fov);
+    camera.aperture = job.aperture.value_or(camera.aperture);
+    camera.focus_distance = job.focus_distance.value_or(camera.focus_distance);
+    raytracer.set_camera(camera);
+
+    if (job.width.has_value())
+        raytracer.set_image_width(*job.width);
+
+    if (job.height.has_value() && *job.height > 0)
+        raytracer.set_aspect_ratio(static_cast<float>(raytracer.get_image_width()) / static_cast<float>(*job.height));
+
+    if (job.samples_per_pixel.has_value())
+        raytracer.set_samples_per_pixel(*job.samples_per_pixel);
+
+    if (job.max_depth.has_value())
+        raytracer.set_max_depth(*job.max_depth);
+
+    raytracer.set_seed(job.seed);
+    raytracer.set_texture_bake_resolution(job.bake_resolution);
+    raytracer.set_primary_hit_cache(job.hit_cache_strata);
+
+    RenderBudget budget = {};
+    budget.seconds = job.time_budget;
+    budget.target_error = job.target_error;
+
+    if (job.target_error > 0.0f)
+    {
+        budget.mode = RenderBudgetMode::Error;
+    }
+    else if (job.time_budget > 0.0)
+    {
+        budget.mode = RenderBudgetMode::Time;
+    }
+
+    if (job.max_samples_per_pixel.has_value())
+        budget.max_samples_per_pixel = static_cast<u32>(*job.max_samples_per_pixel);
+
+    raytracer.set_render_budget(budget);
+    raytracer.set_output_path(job.output);
+    raytracer.set_cancel_flag(&record.is_cancelled);
+
+    raytracer.initialize();
+
+    std::chrono::duration<double> const setup_time = std::chrono::steady_clock::now() - start_time;
+
+    {
+        std::lock_guard const lock(m_mutex);
+        record.raytracer = scene->raytracer;
+    }
+
+    bool const is_finished = raytracer.render();
+    raytracer.set_cancel_flag(nullptr);
+
+    std::chrono::duration<double> const render_time = std::chrono::steady_clock::now() - start_time - setup_time;
+
+    std::lock_guard const lock(m_mutex);
+    record.raytracer = nullptr;
+
+    if (is_finished)
+    {
+        record.state = RenderJobState::Done;
+    }
+    else if (record.is_cancelled)
+    {
+        record.state = RenderJobState::Cancelled;
+    }
+    else
+    {
+        record.state = RenderJobState::Failed;
+        record.error = "render stopped before the image was done";
+    }
+
+    record.setup_time = setup_time.count();
+    record.render_time = render_time.count();
+    record.samples_per_pixel = raytracer.get_render_report().samples_per_pixel;
+    record.estimated_error = raytracer.get_render_report().estimated_error;
+    record.stopped_by = raytracer.get_render_report().stopped_by;
+}
+
+RenderServer::CachedScene* RenderServer::acquire_scene(std::string const& scene, std::string& error)
+{
+    bool const is_file = RaytracerSerialization::is_scene_file(scene);
+    std::string key = scene;
+
+    // An edited scene file is loaded again.
+    if (is_file)
+    {
+        std::error_code file_error = {};
+        auto const write_time = std::filesystem::last_write_time(scene, file_error);
+
+        if (file_error)
+        {
+            error = "no scene file " + scene;
+            return nullptr;
+        }
+
+        key += "@" + std::to_string(write_time.time_since_epoch().count());
+    }
+
+    m_scene_use_counter += 1;
+
+    for (auto& cached : m_scenes)
+    {
+        if (cached.key == key)
+        {
+            cached.last_used = m_scene_use_counter;
+            return &cached;
+        }
+    }
+
+    auto const raytracer = Raytracer::create(false);
+    raytracer->set_thread_count(m_thread_count);
+
+    bool const is_loaded = is_file ? RaytracerSerialization::load(scene, *raytracer) : RaytracerScenes::build(scene, *raytracer);
+
+    if (!is_loaded)
+    {
+        error = "could not load scene " + scene;
+        return nullptr;
+    }
+
+    if (m_scenes.size() >= max_cached_scenes)
+    {
+        auto const oldest = std::ranges::min_element(m_scenes, {}, &CachedScene::last_used);
+        m_scenes.erase(oldest);
+    }
+
+    CachedScene cached = {};
+    cached.key = key;
+    cached.raytracer = raytracer;
+    cached.camera = raytracer->get_camera();
+    cached.image_width = raytracer->get_image_width();
+    cached.aspect_ratio = raytracer->get_aspect_ratio();
+    cached.samples_per_pixel = raytracer->get_samples_per_pixel();
+    cached.max_depth = raytracer->get_max_depth();
+    cached.last_used = m_scene_use_counter;
+
+    m_scenes.emplace_back(cached);
+
+    return &m_scenes.back();
+}
+
+#ifdef _WIN32
+
+bool RenderServer::run(std::string const&)
+{
+    std::cout << "The render server needs Unix sockets, it is not supported on this platform.\n";
+    return false;
+}
+
+#else
+
+static bool send_line(i32 const fd, std::string const& line)
+{
+    std::string const message = line + "\n";
+    size_t sent = 0;
+
+    while (sent < message.size())
+    {
+        ssize_t const result = send(fd, message.data() + sent, message.size() - sent, 0);
+
+        if (result < 0 && errno == EINTR)
+            continue;
+
+        if (result <= 0)
+            return false;
+
+        sent += static_cast<size_t>(result);
+    }
+
+    return true;
+}
+
+bool RenderServer::run(std::string const& socket_path)
+{
+    // Answering a client that already disconnected has to fail with an error, not end the server.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "Socket path is too long: " << socket_path << "\n";
+        return false;
+    }
+
+    std::ranges::copy(socket_path, address.sun_path);
+
+    // A socket file left behind by a server that did not shut down cleanly would make bind() fail. Anything else at the
+    // path is not ours to remove.
+    struct stat status = {};
+
+    if (lstat(socket_path.c_str(), &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            std::cout << "Not a socket, refusing to replace it: " << socket_path << "\n";
+            return false;
+        }
+
+        unlink(socket_path.c_str());
+    }
+
+    i32 const listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        std::cout << "Could not listen on " << socket_path << "\n";
+
+        if (listener >= 0)
+            close(listener);
+
+        return false;
+    }
+
+    std::clog << "Render server listening on " << socket_path << "\n";
+
+    std::thread job_thread(&RenderServer::process_jobs, this);
+
+    struct Client
+    {
+        i32 fd = -1;
+        std::string buffer = {};
+    };
+
+    std::vector<Client> clients = {};
+    bool is_running = true;
+
+    while (is_running)
+    {
+        std::vector<pollfd> poll_fds = {{listener, POLLIN, 0}};
+
+        for (auto const& client : clients)
+        {
+            poll_fds.emplace_back(pollfd {client.fd, POLLIN, 0});
+        }
+
+        if (poll(poll_fds.data(), poll_fds.size(), -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        for (size_t i = 1; i < poll_fds.size(); ++i)
+        {
+            if (poll_fds[i].revents == 0)
+                continue;
+
+            Client& client = clients[i - 1];
+            char data[4096] = {};
+            ssize_t const size = recv(client.fd, data, sizeof(data), 0);
+
+            if (size <= 0)
+            {
+                close(client.fd);
+                client.fd = -1;
+                continue;
+            }
+
+            client.buffer.append(data, static_cast<size_t>(size));
+
+            for (size_t end = client.buffer.find('\n'); end != std::string::npos; end = client.buffer.find('\n'))
+            {
+                std::string request = client.buffer.substr(0, end);
+                client.buffer.erase(0, end + 1);
+
+                if (!request.empty() && request.back() == '\r')
+                    request.pop_back();
+
+                [[maybe_unused]] bool const is_sent = send_line(client.fd, handle_request(request));
+            }
+
+            std::lock_guard const lock(m_mutex);
+            is_running = !m_is_stopping;
+        }
+
+        std::erase_if(clients, [](Client const& client) { return client.fd < 0; });
+
+        if ((poll_fds[0].revents & POLLIN) != 0)
+        {
+            i32 const fd = accept(listener, nullptr, nullptr);
+
+            if (fd >= 0)
+                clients.emplace_back(fd);
+        }
+    }
+
+    job_thread.join();
+
+    for (auto const& client : clients)
+    {
+        close(client.fd);
+    }
+
+    close(listener);
+    unlink(socket_path.c_str());
+
+    std::clog << "Render server stopped.\n";
+
+    return true;
+}
+
+#endif
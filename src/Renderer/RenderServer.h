@@ -0,0 +1,163 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "AK/Types.h"
+#include "RaytracerCamera.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+class Raytracer;
+enum class RenderBudgetMode : u8;
+
+enum class RenderJobState : u8
+{
+    Queued,
+    Running,
+    Done,
+    Cancelled,
+    Failed,
+};
+
+// Everything a client can set for a job. Unset values keep the defaults of the scene.
+struct RenderJob
+{
+    std::string scene = {};
+    i32 priority = 0;
+    std::string output = "./output/image.ppm";
+    std::optional<i32> width = {};
+    std::optional<i32> height = {};
+    std::optional<i32> samples_per_pixel = {};
+    std::optional<i32> max_depth = {};
+    std::optional<glm::vec3> position = {};
+    std::optional<glm::vec3> euler_angles = {};
+    std::optional<float> fov = {};
+    std::optional<float> aperture = {};
+    std::optional<float> focus_distance = {};
+    u64 seed = 0;
+    i32 bake_resolution = 0;
+    i32 hit_cache_strata = 0;
+
+    // Seconds and estimated error of a budgeted render, see Raytracer::set_render_budget(). Both 0 render the samples
+    // per pixel.
+    double time_budget = 0.0;
+    float target_error = 0.0f;
+    std::optional<i32> max_samples_per_pixel = {};
+};
+
+// Long running render process that takes jobs over a Unix socket. Loaded scenes stay in memory with their textures,
+// BVH and texture bakes, so jobs on a scene that was rendered before only pay for the render itself.
+//
+// One job renders at a time on every render thread, the next one is the queued job with the highest priority,
+// the oldest first among equal priorities. Requests are single text lines and get a single line back:
+//
+//   submit <scene> [priority=<n>] [width=<n>] [height=<n>] [spp=<n>] [depth=<n>] [seed=<n>] [bake=<n>] [output=<path>]
+//          [position=<x,y,z>] [rotation=<x,y,z>] [fov=<degrees>] [aperture=<size>] [focus=<distance>] [hit_cache=<n>]
+//          [time=<seconds>] [error=<estimated error>] [max_spp=<n>]                                        -> ok <job id>
+//   status <job id>   -> ok queued | ok running <finished rows>/<rows>
+//                      | ok done <setup s> <render s> <spp> <estimated error> <samples|time|error, what stopped the render>
+//                      | ok cancelled | ok failed <error>
+//   cancel <job id>   -> ok
+//   shutdown          -> ok, the running job is cancelled
+//
+// Malformed requests get "error <message>". Only the last max_finished_jobs finished, cancelled or failed jobs keep
+// their status, older ones are forgotten and get "error no job <job id>".
+class RenderServer
+{
+public:
+    static std::shared_ptr<RenderServer> create(i32 const thread_count);
+
+    explicit RenderServer(AK::Badge<RenderServer>, i32 const thread_count);
+
+    // Serves requests until a shutdown request. Returns false if the socket could not be opened.
+    bool run(std::string const& socket_path);
+
+    // Scenes kept in memory, the least recently used one is dropped first.
+    static size_t constexpr max_cached_scenes = 4;
+
+    // Jobs that ended and can still be asked for their status, the one that ended first is dropped first.
+    static size_t constexpr max_finished_jobs = 1024;
+
+private:
+    struct JobRecord
+    {
+        RenderJob job = {};
+        RenderJobState state = RenderJobState::Queued;
+        std::string error = {};
+
+        std::atomic<bool> is_cancelled = false;
+        std::shared_ptr<Raytracer> raytracer = {};
+
+        double setup_time = 0.0;
+        double render_time = 0.0;
+        double samples_per_pixel = 0.0;
+        float estimated_error = 0.0f;
+        RenderBudgetMode stopped_by = {};
+    };
+
+    struct QueuedJob
+    {
+        i32 priority = 0;
+        u32 id = 0;
+
+        // Higher priorities first, the oldest first among equal priorities.
+        bool operator<(QueuedJob const& other) const
+        {
+            return priority != other.priority ? priority > other.priority : id < other.id;
+        }
+    };
+
+    struct CachedScene
+    {
+        std::string key = {};
+        std::shared_ptr<Raytracer> raytracer = {};
+
+        // Settings of the scene itself, restored before every job.
+        RaytracerCamera camera = {};
+        i32 image_width = 0;
+        float aspect_ratio = 1.0f;
+        i32 samples_per_pixel = 0;
+        i32 max_depth = 0;
+
+        u64 last_used = 0;
+    };
+
+    [[nodiscard]] std::string handle_request(std::string const& request);
+    [[nodiscard]] std::string submit(std::vector<std::string> const& arguments);
+
+    // Have to be called with m_mutex locked.
+    [[nodiscard]] JobRecord* next_queued_job();
+    void retire_job(u32 const id);
+
+    void process_jobs();
+    void render_job(JobRecord& record);
+
+    [[nodiscard]] CachedScene* acquire_scene(std::string const& scene, std::string& error);
+
+    i32 m_thread_count = 0;
+
+    std::mutex m_mutex = {};
+    std::condition_variable m_job_available = {};
+    std::map<u32, JobRecord> m_jobs = {};
+
+    // Queued jobs, the first one renders next.
+    std::set<QueuedJob> m_queue = {};
+
+    // Ended jobs in the order they ended, at most max_finished_jobs.
+    std::deque<u32> m_finished_jobs = {};
+
+    u32 m_next_job_id = 1;
+    bool m_is_stopping = false;
+
+    // Only touched by the job thread.
+    std::vector<CachedScene> m_scenes = {};
+    u64 m_scene_use_counter = 0;
+};
@@ -1,20 +1,51 @@
 #include "RotateYHittable.h"
 
 #include "AK/Math.h"
-#include "Raytracer.h"
+#include "RaytracerStatistics.h"
 
 RotateYHittable::RotateYHittable(std::shared_ptr<Hittable> const& hittable, float const angle)
     : Hittable(hittable->material), m_hittable(hittable)
 {
+    set_angle(angle);
+}
+
+void RotateYHittable::set_angle(float const angle)
+{
+    m_angle = angle;
+
     float const radians = glm::radians(angle);
     m_sin_theta = glm::sin(radians);
     m_cos_theta = glm::cos(radians);
 
-    m_bbox = hittable->bounding_box();
+    update_bounds();
+}
+
+void RotateYHittable::set_motion(float const motion)
+{
+    m_motion = motion;
+
+    update_bounds();
+}
+
+void RotateYHittable::update_bounds()
+{
+    m_bbox = m_hittable->bounding_box();
 
     glm::vec3 min(AK::INFINITY_F, AK::INFINITY_F, AK::INFINITY_F);
     glm::vec3 max(-AK::INFINITY_F, -AK::INFINITY_F, -AK::INFINITY_F);
 
+    auto const include = [&](glm::vec3 const& tester) {
+        for (i32 c = 0; c < 3; ++c)
+        {
+            min[c] = std::fmin(min[c], tester[c]);
+            max[c] = std::fmax(max[c], tester[c]);
+        }
+    };
+
+    float const end_radians = glm::radians(m_angle + m_motion);
+    float const end_sin_theta = glm::sin(end_radians);
+    float const end_cos_theta = glm::cos(end_radians);
+
     for (i32 i = 0; i < 2; ++i)
     {
         for (i32 k = 0; k < 2; ++k)
@@ -25,15 +56,23 @@ RotateYHittable::RotateYHittable(std::shared_ptr<Hittable> const& hittable, floa
                 float const y = static_cast<float>(k) * m_bbox.y.max + static_cast<float>(1 - k) * m_bbox.y.min;
                 float const z = static_cast<float>(m) * m_bbox.z.max + static_cast<float>(1 - m) * m_bbox.z.min;
 
-                float const new_x = m_cos_theta * x + m_sin_theta * z;
-                float const new_z = -m_sin_theta * x + m_cos_theta * z;
+                include(to_world({x, y, z}, m_sin_theta, m_cos_theta));
 
-                glm::vec3 tester(new_x, y, new_z);
+                if (m_motion == 0.0f)
+                    continue;
 
-                for (i32 c = 0; c < 3; ++c)
+                include(to_world({x, y, z}, end_sin_theta, end_cos_theta));
+
+                // The corner moves along an arc around the Y axis, which reaches further out than its ends where it
+                // crosses the X or Z axis. Turning by theta moves the polar angle of the corner back by theta.
+                float const radius = glm::sqrt(x * x + z * z);
+                float const polar_angle = glm::degrees(std::atan2(z, x)) - m_angle;
+                float const lowest = polar_angle - std::max(m_motion, 0.0f);
+                float const highest = polar_angle - std::min(m_motion, 0.0f);
+
+                for (float axis = std::ceil(lowest / 90.0f) * 90.0f; axis <= highest; axis += 90.0f)
                 {
-                    min[c] = std::fmin(min[c], tester[c]);
-                    max[c] = std::fmax(max[c], tester[c]);
+                    include({radius * glm::cos(glm::radians(axis)), y, radius * glm::sin(glm::radians(axis))});
                 }
             }
         }
@@ -42,47 +81,86 @@ RotateYHittable::RotateYHittable(std::shared_ptr<Hittable> const& hittable, floa
     m_bbox = AABB(min, max);
 }
 
-void RotateYHittable::initialize()
+bool RotateYHittable::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+{
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::RotateY);
+
+    float sin_theta = 0.0f;
+    float cos_theta = 0.0f;
+    rotation_at(ray.time(), sin_theta, cos_theta);
+
+    // Determine whether an intersection exists in object space (and if so, where).
+    if (!m_hittable->hit(to_object(ray, sin_theta, cos_theta), ray_t, hit_record))
+        return false;
+
+    // Change the intersection point and the normal from object space to world space.
+    hit_record.point = to_world(hit_record.point, sin_theta, cos_theta);
+    hit_record.normal = to_world(hit_record.normal, sin_theta, cos_theta);
+
+    return true;
+}
+
+float RotateYHittable::transmittance(Ray const& ray, Interval const ray_t) const
 {
-    Hittable::initialize();
+    float sin_theta = 0.0f;
+    float cos_theta = 0.0f;
+    rotation_at(ray.time(), sin_theta, cos_theta);
 
-    Raytracer::get_instance()->unregister_hittable(m_hittable.lock());
+    return m_hittable->transmittance(to_object(ray, sin_theta, cos_theta), ray_t);
 }
 
-void RotateYHittable::draw() const
+void RotateYHittable::rotation_at(float const time, float& sin_theta, float& cos_theta) const
 {
+    sin_theta = m_sin_theta;
+    cos_theta = m_cos_theta;
+
+    if (m_motion != 0.0f)
+    {
+        float const radians = glm::radians(m_angle + m_motion * time);
+        sin_theta = glm::sin(radians);
+        cos_theta = glm::cos(radians);
+    }
 }
 
-bool RotateYHittable::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+Ray RotateYHittable::to_object(Ray const& ray, float const sin_theta, float const cos_theta)
 {
     // Change the ray from world space to object space.
     glm::vec3 origin = ray.origin();
     glm::vec3 direction = ray.direction();
 
-    origin.x = m_cos_theta * ray.origin().x - m_sin_theta * ray.origin().z;
-    origin.z = m_sin_theta * ray.origin().x + m_cos_theta * ray.origin().z;
+    origin.x = cos_theta * ray.origin().x - sin_theta * ray.origin().z;
+    origin.z = sin_theta * ray.origin().x + cos_theta * ray.origin().z;
 
-    direction.x = m_cos_theta * ray.direction().x - m_sin_theta * ray.direction().z;
-    direction.z = m_sin_theta * ray.direction().x + m_cos_theta * ray.direction().z;
+    direction.x = cos_theta * ray.direction().x - sin_theta * ray.direction().z;
+    direction.z = sin_theta * ray.direction().x + cos_theta * ray.direction().z;
 
-    Ray const rotated_ray(origin, direction);
+    Ray rotated_ray(origin, direction, ray.cone_width(), ray.cone_spread(), ray.time());
+    rotated_ray.set_shadow(ray.is_shadow());
 
-    // Determine whether an intersection exists in object space (and if so, where).
-    if (m_hittable.expired() || !m_hittable.lock()->hit(rotated_ray, ray_t, hit_record))
-        return false;
+    return rotated_ray;
+}
 
-    // Change the intersection point from object space to world space.
-    glm::vec3 point = hit_record.point;
-    point.x = m_cos_theta * hit_record.point.x + m_sin_theta * hit_record.point.z;
-    point.z = -m_sin_theta * hit_record.point.x + m_cos_theta * hit_record.point.z;
+std::shared_ptr<Hittable> RotateYHittable::hittable() const
+{
+    return m_hittable;
+}
 
-    // Change the normal from object space to world space.
-    glm::vec3 normal = hit_record.normal;
-    normal.x = m_cos_theta * hit_record.normal.x + m_sin_theta * hit_record.normal.z;
-    normal.z = -m_sin_theta * hit_record.normal.x + m_cos_theta * hit_record.normal.z;
+float RotateYHittable::angle() const
+{
+    return m_angle;
+}
 
-    hit_record.point = point;
-    hit_record.normal = normal;
+float RotateYHittable::motion() const
+{
+    return m_motion;
+}
 
-    return true;
+glm::vec3 RotateYHittable::to_world(glm::vec3 const& vector) const
+{
+    return to_world(vector, m_sin_theta, m_cos_theta);
+}
+
+glm::vec3 RotateYHittable::to_world(glm::vec3 const& vector, float const sin_theta, float const cos_theta)
+{
+    return {cos_theta * vector.x + sin_theta * vector.z, vector.y, -sin_theta * vector.x + cos_theta * vector.z};
 }
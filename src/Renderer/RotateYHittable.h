@@ -7,14 +7,32 @@ class RotateYHittable final : public Hittable
 public:
     RotateYHittable(std::shared_ptr<Hittable> const& hittable, float const angle);
 
-    virtual void initialize() override;
+    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual float transmittance(Ray const& ray, Interval const ray_t) const override;
 
-    virtual void draw() const override;
+    [[nodiscard]] std::shared_ptr<Hittable> hittable() const;
+    [[nodiscard]] float angle() const;
 
-    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    // For animation. Hittables wrapping this one keep their old bounds until they are updated as well.
+    void set_angle(float const angle);
+
+    // Degrees turned while the shutter is open, for motion blur. The bounds cover the whole turn, which is not
+    // a straight line, so the BVH does not get tighter bounds for turning hittables.
+    [[nodiscard]] float motion() const;
+    void set_motion(float const motion);
+
+    // Rotates a point or direction from the space of the wrapped hittable to world space, at the angle when the shutter opens.
+    [[nodiscard]] glm::vec3 to_world(glm::vec3 const& vector) const;
 
 private:
-    std::weak_ptr<Hittable> m_hittable;
+    void rotation_at(float const time, float& sin_theta, float& cos_theta) const;
+    [[nodiscard]] static Ray to_object(Ray const& ray, float const sin_theta, float const cos_theta);
+    [[nodiscard]] static glm::vec3 to_world(glm::vec3 const& vector, float const sin_theta, float const cos_theta);
+    void update_bounds();
+
+    std::shared_ptr<Hittable> m_hittable = {};
+    float m_angle = 0.0f;
+    float m_motion = 0.0f;
     float m_sin_theta = 0.0f;
     float m_cos_theta = 0.0f;
 };
@@ -1,42 +1,28 @@
 #include "SphereRaytraced.h"
 
-#include "Entity.h"
+#include "RaytracerStatistics.h"
 
+#include <glm/gtc/constants.hpp>
 #include <glm/gtx/norm.hpp>
 
-std::shared_ptr<SphereRaytraced> SphereRaytraced::create(float const radius, std::shared_ptr<Material> const& material)
+std::shared_ptr<SphereRaytraced> SphereRaytraced::create(glm::vec3 const& center, float const radius,
+                                                         std::shared_ptr<MaterialCPU> const& material)
 {
-    return std::make_shared<SphereRaytraced>(AK::Badge<SphereRaytraced> {}, radius, material);
+    return std::make_shared<SphereRaytraced>(AK::Badge<SphereRaytraced> {}, center, radius, material);
 }
 
-SphereRaytraced::SphereRaytraced(AK::Badge<SphereRaytraced>, float const radius, std::shared_ptr<Material> const& material)
-    : Hittable(material), m_radius(radius)
+SphereRaytraced::SphereRaytraced(AK::Badge<SphereRaytraced>, glm::vec3 const& center, float const radius,
+                                 std::shared_ptr<MaterialCPU> const& material)
+    : Hittable(material), m_center(center), m_radius(radius)
 {
-}
-
-void SphereRaytraced::initialize()
-{
-    Hittable::initialize();
-
-    m_center = entity->transform->get_position();
-
     glm::vec3 const radius_vec = {m_radius, m_radius, m_radius};
     m_bbox = AABB(m_center - radius_vec, m_center + radius_vec);
 }
 
-void SphereRaytraced::update()
-{
-    // FIXME: This is actually not called because can_tick is set to false. When we'll set it to true eventually,
-    // AABB will need to be updated as well.
-    m_center = entity->transform->get_position();
-}
-
-void SphereRaytraced::draw() const
-{
-}
-
 bool SphereRaytraced::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
 {
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::Sphere);
+
     glm::vec3 const origin_center = m_center - ray.origin();
     glm::vec3 const direction = ray.direction();
     float const a = glm::length2(direction);
@@ -71,6 +57,10 @@ bool SphereRaytraced::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_r
     get_sphere_uv(outward_normal, hit_record.u, hit_record.v);
     hit_record.set_face_normal(ray, outward_normal);
 
+    // U runs around the sphere and shrinks towards the poles, V runs from pole to pole. Geometric mean of the two.
+    float const sin_theta = glm::sqrt(glm::max(1.0f - outward_normal.y * outward_normal.y, 0.0001f));
+    hit_record.set_uv_footprint(ray, glm::pi<float>() * m_radius * glm::sqrt(2.0f * sin_theta));
+
     return true;
 }
 
@@ -89,3 +79,25 @@ void SphereRaytraced::get_sphere_uv(glm::vec3 const& point, float& u, float& v)
     u = phi / (2.0f * glm::pi<float>());
     v = theta / glm::pi<float>();
 }
+
+bool SphereRaytraced::surface_point(float const u, float const v, glm::vec3& point) const
+{
+    // Inverse of get_sphere_uv().
+    float const theta = v * glm::pi<float>();
+    float const phi = u * 2.0f * glm::pi<float>() - glm::pi<float>();
+
+    glm::vec3 const unit_point = {std::cos(phi) * std::sin(theta), -std::cos(theta), -std::sin(phi) * std::sin(theta)};
+    point = m_center + m_radius * unit_point;
+
+    return true;
+}
+
+glm::vec3 SphereRaytraced::center() const
+{
+    return m_center;
+}
+
+float SphereRaytraced::radius() const
+{
+    return m_radius;
+}
@@ -1,22 +1,25 @@
 #pragma once
 
+#include "AK/Badge.h"
 #include "AK/Interval.h"
 #include "Hittable.h"
 
 class SphereRaytraced final : public Hittable
 {
 public:
-    static std::shared_ptr<SphereRaytraced> create(float const radius, std::shared_ptr<Material> const& material);
-    SphereRaytraced(AK::Badge<SphereRaytraced>, float const radius, std::shared_ptr<Material> const& material);
-
-    virtual void initialize() override;
-    virtual void update() override;
-    virtual void draw() const override;
+    static std::shared_ptr<SphereRaytraced> create(glm::vec3 const& center, float const radius,
+                                                   std::shared_ptr<MaterialCPU> const& material);
+    SphereRaytraced(AK::Badge<SphereRaytraced>, glm::vec3 const& center, float const radius,
+                    std::shared_ptr<MaterialCPU> const& material);
 
     virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual bool surface_point(float const u, float const v, glm::vec3& point) const override;
 
     static void get_sphere_uv(glm::vec3 const& point, float& u, float& v);
 
+    [[nodiscard]] glm::vec3 center() const;
+    [[nodiscard]] float radius() const;
+
 private:
     glm::vec3 m_center = {};
     float m_radius = 0.0f;
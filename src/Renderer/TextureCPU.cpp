@@ -1,7 +1,11 @@
 #include "TextureCPU.h"
 
 #include "AK/Types.h"
-#include "ResourceManager.h"
+#include "BakedGrid.h"
+#include "Hittable.h"
+#include "Image.h"
+
+#include <glm/gtc/random.hpp>
 
 #include <cmath>
 
@@ -18,6 +22,11 @@ glm::vec3 SolidColor::value(float u, float v, glm::vec3 const& point) const
     return m_color;
 }
 
+glm::vec3 SolidColor::color() const
+{
+    return m_color;
+}
+
 CheckerTexture::CheckerTexture(float const scale, std::shared_ptr<TextureCPU> const& even, std::shared_ptr<TextureCPU> const& odd)
     : m_inv_scale(1.0f / scale), m_even(even), m_odd(odd)
 {
@@ -39,7 +48,22 @@ glm::vec3 CheckerTexture::value(float u, float v, glm::vec3 const& point) const
     return is_even ? m_even->value(u, v, point) : m_odd->value(u, v, point);
 }
 
-ImageTexture::ImageTexture(std::string const& path) : m_image(ResourceManager::get_instance().load_image(path))
+float CheckerTexture::scale() const
+{
+    return 1.0f / m_inv_scale;
+}
+
+std::shared_ptr<TextureCPU> CheckerTexture::even() const
+{
+    return m_even;
+}
+
+std::shared_ptr<TextureCPU> CheckerTexture::odd() const
+{
+    return m_odd;
+}
+
+ImageTexture::ImageTexture(std::string const& path) : m_image(Image::create(path))
 {
 }
 
@@ -48,35 +72,118 @@ ImageTexture::ImageTexture(std::shared_ptr<Image> const& image) : m_image(image)
 }
 
 glm::vec3 ImageTexture::value(float u, float v, glm::vec3 const& point) const
+{
+    return filtered_value(u, v, 0.0f);
+}
+
+glm::vec3 ImageTexture::filtered_value(float const u, float const v, float const uv_footprint) const
 {
     // If we have no texture data, then return solid cyan as a debugging aid.
     if (m_image->height() <= 0)
         return {0.0f, 1.0f, 1.0f};
 
-    // Clamp input texture coordinates to [0,1] x [1,0]
-    u = glm::clamp(u, 0.0f, 1.0f);
-
     // NOTE: Original RTiOW code llipped V image coordinate, we are not doing that, for whatever reason the imaged is flipped somewhere else.
-    v = glm::clamp(v, 0.0f, 1.0f);
+    return m_image->sample(u, v, uv_footprint);
+}
+
+std::shared_ptr<Image> ImageTexture::image() const
+{
+    return m_image;
+}
+
+NoiseTexture::NoiseTexture(float const scale, u32 const seed) : m_noise(seed), m_scale(scale), m_seed(seed)
+{
+}
 
-    i32 i = static_cast<i32>(u * m_image->width());
-    i32 k = static_cast<i32>(v * m_image->height());
+glm::vec3 NoiseTexture::value(float u, float v, glm::vec3 const& point) const
+{
+    if (m_baked_turbulence != nullptr)
+    {
+        float const turbulence = m_is_surface_bake ? m_baked_turbulence->sample_uv(u, v) : m_baked_turbulence->sample(point);
+        return color(turbulence, point);
+    }
 
-    u8 const* pixel = m_image->pixel_data(i, k);
+    return color(m_noise.turbulence(point, turbulence_depth), point);
+}
 
-    float constexpr color_scale = 1.0f / 255.0f;
+float NoiseTexture::scale() const
+{
+    return m_scale;
+}
 
-    return {color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]};
+u32 NoiseTexture::seed() const
+{
+    return m_seed;
 }
 
-NoiseTexture::NoiseTexture(float const scale) : m_scale(scale)
+TextureBakeStats NoiseTexture::bake_volume(AABB const& bounds, i32 const resolution, i32 const thread_count)
 {
+    auto const turbulence = [this](glm::vec3 const& point) { return m_noise.turbulence(point, turbulence_depth); };
+
+    // Drop the previous bake first, so the grid is built from the exact texture.
+    clear_bake();
+    m_baked_turbulence = BakedGrid::create_volume(bounds, resolution, thread_count, turbulence);
+
+    return measure_bake_error([&bounds](float& u, float& v, glm::vec3& point) {
+        u = 0.0f;
+        v = 0.0f;
+        point = glm::linearRand(glm::vec3(bounds.x.min, bounds.y.min, bounds.z.min), glm::vec3(bounds.x.max, bounds.y.max, bounds.z.max));
+    });
 }
 
-glm::vec3 NoiseTexture::value(float u, float v, glm::vec3 const& point) const
+TextureBakeStats NoiseTexture::bake_surface(Hittable const& surface, i32 const resolution, i32 const thread_count)
+{
+    auto const turbulence = [this, &surface](glm::vec2 const& uv) {
+        glm::vec3 point = {};
+        [[maybe_unused]] bool const is_on_surface = surface.surface_point(uv.x, uv.y, point);
+        return m_noise.turbulence(point, turbulence_depth);
+    };
+
+    clear_bake();
+    m_baked_turbulence = BakedGrid::create_atlas(resolution, thread_count, turbulence);
+    m_is_surface_bake = true;
+
+    return measure_bake_error([&surface](float& u, float& v, glm::vec3& point) {
+        u = glm::linearRand(0.0f, 1.0f);
+        v = glm::linearRand(0.0f, 1.0f);
+        [[maybe_unused]] bool const is_on_surface = surface.surface_point(u, v, point);
+    });
+}
+
+void NoiseTexture::clear_bake()
+{
+    m_baked_turbulence = nullptr;
+    m_is_surface_bake = false;
+}
+
+glm::vec3 NoiseTexture::color(float const turbulence, glm::vec3 const& point) const
 {
     // The output of the sin function can return negative values.
     // These negative values will be passed to our linear_to_gamma() color function, which expects only positive inputs.
     // Map the [-1,+1] range of sin values to [0,1].
-    return glm::vec3(0.5f, 0.5f, 0.5f) * (1.0f + glm::sin(m_scale * point.z + 10.0f * m_noise.turbulence(point, 7.0f)));
+    return glm::vec3(0.5f, 0.5f, 0.5f) * (1.0f + glm::sin(m_scale * point.z + 10.0f * turbulence));
+}
+
+TextureBakeStats NoiseTexture::measure_bake_error(std::function<void(float&, float&, glm::vec3&)> const& random_point) const
+{
+    TextureBakeStats stats = {};
+    stats.sample_counts = m_baked_turbulence->sample_counts();
+    stats.memory_size = m_baked_turbulence->memory_size();
+
+    i32 constexpr error_sample_count = 4096;
+
+    for (i32 i = 0; i < error_sample_count; ++i)
+    {
+        float u = 0.0f;
+        float v = 0.0f;
+        glm::vec3 point = {};
+        random_point(u, v, point);
+
+        float const error = glm::abs(value(u, v, point).x - color(m_noise.turbulence(point, turbulence_depth), point).x);
+
+        stats.mean_error += error / static_cast<float>(error_sample_count);
+        stats.max_error = glm::max(stats.max_error, error);
+    }
+
+    return stats;
 }
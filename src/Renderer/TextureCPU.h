@@ -1,14 +1,28 @@
 #pragma once
 
+#include "AK/AABB.h"
 #include "PerlinNoise.h"
 
+#include <functional>
 #include <memory>
 #include <string>
 
 #include <glm/vec3.hpp>
 
+class BakedGrid;
+class Hittable;
 class Image;
 
+struct TextureBakeStats
+{
+    glm::ivec3 sample_counts = {};
+    size_t memory_size = 0;
+
+    // Difference from the exact texture value at random points inside the baked bounds or on the baked surface.
+    float mean_error = 0.0f;
+    float max_error = 0.0f;
+};
+
 class TextureCPU
 {
 public:
@@ -26,6 +40,8 @@ public:
 
     [[nodiscard]] virtual glm::vec3 value(float u, float v, glm::vec3 const& point) const override;
 
+    [[nodiscard]] glm::vec3 color() const;
+
 private:
     glm::vec3 m_color;
 };
@@ -39,6 +55,10 @@ public:
 
     [[nodiscard]] virtual glm::vec3 value(float u, float v, glm::vec3 const& point) const override;
 
+    [[nodiscard]] float scale() const;
+    [[nodiscard]] std::shared_ptr<TextureCPU> even() const;
+    [[nodiscard]] std::shared_ptr<TextureCPU> odd() const;
+
 private:
     float m_inv_scale;
     std::shared_ptr<TextureCPU> m_even;
@@ -53,6 +73,11 @@ public:
 
     [[nodiscard]] virtual glm::vec3 value(float u, float v, glm::vec3 const& point) const override;
 
+    // Lookup filtered over the given footprint in UV units, picks the mip level.
+    [[nodiscard]] glm::vec3 filtered_value(float const u, float const v, float const uv_footprint) const;
+
+    [[nodiscard]] std::shared_ptr<Image> image() const;
+
 private:
     std::shared_ptr<Image> m_image;
 };
@@ -62,11 +87,34 @@ class NoiseTexture final : public TextureCPU
 public:
     NoiseTexture() = default;
 
-    explicit NoiseTexture(float const scale);
+    // Every instance draws its own noise from the seed, textures sharing a seed look the same.
+    NoiseTexture(float const scale, u32 const seed);
 
     [[nodiscard]] virtual glm::vec3 value(float u, float v, glm::vec3 const& point) const override;
 
+    [[nodiscard]] float scale() const;
+    [[nodiscard]] u32 seed() const;
+
+    // Samples the turbulence on a grid over the bounds the texture is used in, value() then does a trilinear lookup
+    // instead of evaluating every octave. The sine stripes are still evaluated exactly, they are cheap and sharp.
+    TextureBakeStats bake_volume(AABB const& bounds, i32 const resolution, i32 const thread_count);
+
+    // Samples the turbulence over the UV square of the only surface using the texture, value() then does a bilinear
+    // lookup at the hit UV. Spends every sample on the surface instead of the empty space around it.
+    TextureBakeStats bake_surface(Hittable const& surface, i32 const resolution, i32 const thread_count);
+
+    void clear_bake();
+
 private:
+    [[nodiscard]] glm::vec3 color(float const turbulence, glm::vec3 const& point) const;
+    [[nodiscard]] TextureBakeStats measure_bake_error(std::function<void(float&, float&, glm::vec3&)> const& random_point) const;
+
+    static i32 constexpr turbulence_depth = 7;
+
     PerlinNoise m_noise;
     float m_scale = 1.0f;
+    u32 m_seed = 0;
+
+    std::shared_ptr<BakedGrid> m_baked_turbulence = {};
+    bool m_is_surface_bake = false;
 };
@@ -0,0 +1,131 @@
+#include "TextureProgram.h"
+
+#include "TextureCPU.h"
+
+#include <algorithm>
+#include <cmath>
+
+u32 TextureProgram::compile(std::shared_ptr<TextureCPU> const& texture)
+{
+    if (auto const entry = m_entries.find(texture.get()); entry != m_entries.end())
+        return entry->second;
+
+    auto const index = static_cast<u32>(m_instructions.size());
+    m_instructions.emplace_back();
+    m_entries.emplace(texture.get(), index);
+    m_textures.emplace_back(texture);
+
+    TextureInstruction instruction = {};
+    instruction.texture = texture.get();
+
+    if (auto const solid_color = std::dynamic_pointer_cast<SolidColor>(texture); solid_color != nullptr)
+    {
+        instruction.opcode = TextureOpcode::SolidColor;
+        instruction.color = solid_color->color();
+    }
+    else if (auto const checker = std::dynamic_pointer_cast<CheckerTexture>(texture); checker != nullptr)
+    {
+        instruction.opcode = TextureOpcode::Checker;
+        instruction.inverse_scale = 1.0f / checker->scale();
+        instruction.operands = {compile(checker->even()), compile(checker->odd())};
+    }
+    else if (std::dynamic_pointer_cast<ImageTexture>(texture) != nullptr)
+    {
+        instruction.opcode = TextureOpcode::Image;
+    }
+    else if (std::dynamic_pointer_cast<NoiseTexture>(texture) != nullptr)
+    {
+        instruction.opcode = TextureOpcode::Noise;
+    }
+    else
+    {
+        instruction.opcode = TextureOpcode::Virtual;
+    }
+
+    // Compiling the operands may have grown the array, so the instruction is only written at the end.
+    m_instructions[index] = instruction;
+
+    return index;
+}
+
+glm::vec3 TextureProgram::evaluate(u32 const entry, float const u, float const v, glm::vec3 const& point, float const uv_footprint) const
+{
+    return evaluate_leaf(m_instructions[resolve(entry, point)], u, v, point, uv_footprint);
+}
+
+void TextureProgram::evaluate(std::span<TextureLookup const> const lookups, std::span<glm::vec3> const results) const
+{
+    // Lookups are handled in chunks, so the resolved leaves stay on the stack.
+    size_t constexpr chunk_size = 64;
+    std::array<u32, chunk_size> leaves = {};
+
+    for (size_t first = 0; first < lookups.size(); first += chunk_size)
+    {
+        size_t const count = std::min(chunk_size, lookups.size() - first);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            leaves[i] = resolve(lookups[first + i].entry, lookups[first + i].point);
+        }
+
+        for (TextureOpcode const opcode : {TextureOpcode::SolidColor, TextureOpcode::Image, TextureOpcode::Noise, TextureOpcode::Virtual})
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                TextureInstruction const& instruction = m_instructions[leaves[i]];
+
+                if (instruction.opcode != opcode)
+                    continue;
+
+                TextureLookup const& lookup = lookups[first + i];
+                results[first + i] = evaluate_leaf(instruction, lookup.u, lookup.v, lookup.point, lookup.uv_footprint);
+            }
+        }
+    }
+}
+
+size_t TextureProgram::instruction_count() const
+{
+    return m_instructions.size();
+}
+
+u32 TextureProgram::resolve(u32 const entry, glm::vec3 const& point) const
+{
+    u32 index = entry;
+
+    while (m_instructions[index].opcode == TextureOpcode::Checker)
+    {
+        TextureInstruction const& instruction = m_instructions[index];
+
+        i32 const x_int = static_cast<i32>(std::floor(instruction.inverse_scale * point.x));
+        i32 const y_int = static_cast<i32>(std::floor(instruction.inverse_scale * point.y));
+        i32 const z_int = static_cast<i32>(std::floor(instruction.inverse_scale * point.z));
+
+        index = instruction.operands[(x_int + y_int + z_int) % 2 == 0 ? 0 : 1];
+    }
+
+    return index;
+}
+
+glm::vec3 TextureProgram::evaluate_leaf(TextureInstruction const& instruction, float const u, float const v, glm::vec3 const& point,
+                                        float const uv_footprint)
+{
+    switch (instruction.opcode)
+    {
+    case TextureOpcode::SolidColor:
+        return instruction.color;
+
+    // The concrete texture classes are final, so these calls are direct.
+    case TextureOpcode::Image:
+        return static_cast<ImageTexture const*>(instruction.texture)->filtered_value(u, v, uv_footprint);
+
+    case TextureOpcode::Noise:
+        return static_cast<NoiseTexture const*>(instruction.texture)->value(u, v, point);
+
+    case TextureOpcode::Checker:
+    case TextureOpcode::Virtual:
+        break;
+    }
+
+    return instruction.texture->value(u, v, point);
+}
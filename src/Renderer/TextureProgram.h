@@ -0,0 +1,82 @@
+#pragma once
+
+#include "AK/Types.h"
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class TextureCPU;
+
+enum class TextureOpcode : u8
+{
+    SolidColor,
+    Checker,
+    Image,
+    Noise,
+
+    // Texture type the compiler does not know, evaluated through its virtual value().
+    Virtual,
+};
+
+struct TextureInstruction
+{
+    TextureOpcode opcode = TextureOpcode::SolidColor;
+
+    // SolidColor: the color.
+    glm::vec3 color = {};
+
+    // Checker: inverse cell size and the instructions of the even and odd cells.
+    float inverse_scale = 1.0f;
+    std::array<u32, 2> operands = {};
+
+    // Image, Noise and Virtual: the texture that does the lookup.
+    TextureCPU const* texture = nullptr;
+};
+
+// One lookup of a batch, see TextureProgram::evaluate().
+struct TextureLookup
+{
+    u32 entry = 0;
+    float u = 0.0f;
+    float v = 0.0f;
+    glm::vec3 point = {};
+    float uv_footprint = 0.0f;
+};
+
+// Texture networks flattened into a single instruction array. Checkers only ever evaluate one of their cells,
+// so evaluation is a loop that follows operands until it reaches a leaf, without recursion or virtual calls.
+// Compiled by the raytracer in initialize(), materials keep the entry of their texture.
+class TextureProgram
+{
+public:
+    // Appends the texture and everything it references, returns the instruction to start the evaluation at.
+    // Textures that were already compiled are shared.
+    u32 compile(std::shared_ptr<TextureCPU> const& texture);
+
+    // Image textures are filtered over uv_footprint, see HitRecord::uv_footprint.
+    [[nodiscard]] glm::vec3 evaluate(u32 const entry, float const u, float const v, glm::vec3 const& point, float const uv_footprint) const;
+
+    // Evaluates a batch of lookups into the results, which need the same size. The checkers of every lookup are
+    // resolved first, then the leaves are evaluated grouped by their opcode, each kind in a loop of its own.
+    void evaluate(std::span<TextureLookup const> const lookups, std::span<glm::vec3> const results) const;
+
+    [[nodiscard]] size_t instruction_count() const;
+
+private:
+    // Follows the checkers of the lookup to the leaf instruction it ends in.
+    [[nodiscard]] u32 resolve(u32 const entry, glm::vec3 const& point) const;
+
+    [[nodiscard]] static glm::vec3 evaluate_leaf(TextureInstruction const& instruction, float const u, float const v,
+                                                 glm::vec3 const& point, float const uv_footprint);
+
+    std::vector<TextureInstruction> m_instructions = {};
+
+    // Keeps the textures referenced by the instructions alive.
+    std::vector<std::shared_ptr<TextureCPU>> m_textures = {};
+    std::unordered_map<TextureCPU const*, u32> m_entries = {};
+};
@@ -1,36 +1,79 @@
 #include "TranslateHittable.h"
 
-#include "Raytracer.h"
+#include "RaytracerStatistics.h"
 
 TranslateHittable::TranslateHittable(std::shared_ptr<Hittable> const& hittable, glm::vec3 const& offset)
-    : Hittable(hittable->material), m_offset(offset), m_hittable(hittable)
+    : Hittable(hittable->material), m_hittable(hittable)
 {
+    set_offset(offset);
 }
 
-void TranslateHittable::initialize()
+void TranslateHittable::set_offset(glm::vec3 const& offset)
 {
-    Hittable::initialize();
+    m_offset = offset;
+    update_bounds();
+}
 
-    m_bbox = m_hittable.lock()->bounding_box() + m_offset;
+void TranslateHittable::set_motion(glm::vec3 const& motion)
+{
+    m_motion = motion;
+    update_bounds();
+}
 
-    Raytracer::get_instance()->unregister_hittable(m_hittable.lock());
+void TranslateHittable::update_bounds()
+{
+    m_bbox = AABB(m_hittable->bounding_box() + m_offset, m_hittable->bounding_box() + (m_offset + m_motion));
 }
 
-void TranslateHittable::draw() const
+AABB TranslateHittable::bounding_box_at(float const time) const
 {
+    return m_hittable->bounding_box_at(time) + offset_at(time);
 }
 
 bool TranslateHittable::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
 {
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::Translate);
+
+    glm::vec3 const offset = offset_at(ray.time());
+
     // Move the ray backwards by the offset
-    Ray const offset_ray(ray.origin() - m_offset, ray.direction());
+    Ray offset_ray(ray.origin() - offset, ray.direction(), ray.cone_width(), ray.cone_spread(), ray.time());
+    offset_ray.set_shadow(ray.is_shadow());
 
     // Determine whether an intersection exists along the offset ray (and if so, where)
-    if (m_hittable.expired() || !m_hittable.lock()->hit(offset_ray, ray_t, hit_record))
+    if (!m_hittable->hit(offset_ray, ray_t, hit_record))
         return false;
 
     // Move the intersection point forwards by the offset
-    hit_record.point += m_offset;
+    hit_record.point += offset;
 
     return true;
 }
+
+float TranslateHittable::transmittance(Ray const& ray, Interval const ray_t) const
+{
+    Ray offset_ray(ray.origin() - offset_at(ray.time()), ray.direction(), ray.cone_width(), ray.cone_spread(), ray.time());
+    offset_ray.set_shadow(ray.is_shadow());
+
+    return m_hittable->transmittance(offset_ray, ray_t);
+}
+
+std::shared_ptr<Hittable> TranslateHittable::hittable() const
+{
+    return m_hittable;
+}
+
+glm::vec3 TranslateHittable::offset() const
+{
+    return m_offset;
+}
+
+glm::vec3 TranslateHittable::motion() const
+{
+    return m_motion;
+}
+
+glm::vec3 TranslateHittable::offset_at(float const time) const
+{
+    return m_offset + m_motion * time;
+}
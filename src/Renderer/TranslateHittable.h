@@ -7,13 +7,26 @@ class TranslateHittable final : public Hittable
 public:
     TranslateHittable(std::shared_ptr<Hittable> const& hittable, glm::vec3 const& offset);
 
-    virtual void initialize() override;
+    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual float transmittance(Ray const& ray, Interval const ray_t) const override;
+    [[nodiscard]] virtual AABB bounding_box_at(float const time) const override;
 
-    virtual void draw() const override;
+    [[nodiscard]] std::shared_ptr<Hittable> hittable() const;
+    [[nodiscard]] glm::vec3 offset() const;
 
-    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    // For animation. Also picks up new bounds of the wrapped hittable, e.g. after RotateYHittable::set_angle().
+    void set_offset(glm::vec3 const& offset);
+
+    // Distance moved while the shutter is open, for motion blur. The hittable is at offset() when it opens
+    // and at offset() + motion() when it closes.
+    [[nodiscard]] glm::vec3 motion() const;
+    void set_motion(glm::vec3 const& motion);
 
 private:
+    [[nodiscard]] glm::vec3 offset_at(float const time) const;
+    void update_bounds();
+
     glm::vec3 m_offset = {};
-    std::weak_ptr<Hittable> m_hittable = {};
+    glm::vec3 m_motion = {};
+    std::shared_ptr<Hittable> m_hittable = {};
 };
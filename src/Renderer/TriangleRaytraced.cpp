@@ -0,0 +1,72 @@
+#include "TriangleRaytraced.h"
+
+#include "RaytracerStatistics.h"
+
+#include <cmath>
+
+std::shared_ptr<TriangleRaytraced> TriangleRaytraced::create(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c,
+                                                             std::shared_ptr<MaterialCPU> const& material)
+{
+    return std::make_shared<TriangleRaytraced>(AK::Badge<TriangleRaytraced> {}, a, b, c, material);
+}
+
+TriangleRaytraced::TriangleRaytraced(AK::Badge<TriangleRaytraced>, glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c,
+                                     std::shared_ptr<MaterialCPU> const& material)
+    : Hittable(material), m_a(a), m_ab(b - a), m_ac(c - a)
+{
+    glm::vec3 const n = glm::cross(m_ab, m_ac);
+    float const length = glm::length(n);
+
+    // Degenerate triangles never hit, any normal does.
+    m_normal = length > 0.0f ? n / length : glm::vec3(0.0f, 1.0f, 0.0f);
+
+    m_bbox = AABB(AABB(a, b), AABB(a, c));
+}
+
+bool TriangleRaytraced::hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const
+{
+    RAYTRACER_STAT_PRIMITIVE_TEST(PrimitiveType::Triangle);
+
+    // Moeller-Trumbore.
+    glm::vec3 const p = glm::cross(ray.direction(), m_ac);
+    float const determinant = glm::dot(m_ab, p);
+
+    // No hit if the ray is parallel to the triangle.
+    if (std::fabs(determinant) < 1e-12f)
+        return false;
+
+    float const inverse_determinant = 1.0f / determinant;
+    glm::vec3 const to_origin = ray.origin() - m_a;
+
+    float const u = glm::dot(to_origin, p) * inverse_determinant;
+
+    if (u < 0.0f || u > 1.0f)
+        return false;
+
+    glm::vec3 const q = glm::cross(to_origin, m_ab);
+    float const v = glm::dot(ray.direction(), q) * inverse_determinant;
+
+    if (v < 0.0f || u + v > 1.0f)
+        return false;
+
+    float const t = glm::dot(m_ac, q) * inverse_determinant;
+
+    if (!ray_t.contains(t))
+        return false;
+
+    hit_record.t = t;
+    hit_record.point = ray.at(t);
+    hit_record.u = u;
+    hit_record.v = v;
+    hit_record.material = material;
+    hit_record.set_face_normal(ray, m_normal);
+    hit_record.set_uv_footprint(ray, glm::sqrt(glm::length(glm::cross(m_ab, m_ac))));
+
+    return true;
+}
+
+bool TriangleRaytraced::surface_point(float const u, float const v, glm::vec3& point) const
+{
+    point = m_a + u * m_ab + v * m_ac;
+    return true;
+}
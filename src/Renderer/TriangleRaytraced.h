@@ -0,0 +1,25 @@
+#pragma once
+
+#include "AK/Badge.h"
+#include "Hittable.h"
+
+// Single triangle, e.g. of a mesh baked by the AmbientOcclusionBaker. u and v of a hit are the barycentric
+// coordinates of b and c.
+class TriangleRaytraced final : public Hittable
+{
+public:
+    static std::shared_ptr<TriangleRaytraced> create(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c,
+                                                     std::shared_ptr<MaterialCPU> const& material);
+
+    TriangleRaytraced(AK::Badge<TriangleRaytraced>, glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c,
+                      std::shared_ptr<MaterialCPU> const& material);
+
+    virtual bool hit(Ray const& ray, Interval const ray_t, HitRecord& hit_record) const override;
+    [[nodiscard]] virtual bool surface_point(float const u, float const v, glm::vec3& point) const override;
+
+private:
+    glm::vec3 m_a = {};
+    glm::vec3 m_ab = {};
+    glm::vec3 m_ac = {};
+    glm::vec3 m_normal = {};
+};
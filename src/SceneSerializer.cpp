@@ -31,12 +31,8 @@
 #include "Particle.h"
 #include "ParticleSystem.h"
 #include "PointLight.h"
-#include "Renderer/ConstantDensityMedium.h"
-#include "Renderer/Hittable.h"
-#include "Renderer/QuadRaytraced.h"
-#include "Renderer/RotateYHittable.h"
-#include "Renderer/SphereRaytraced.h"
-#include "Renderer/TranslateHittable.h"
+#include "Renderer/Raytracer.h"
+#include "Renderer/RaytracerSerialization.h"
 #include "ScreenText.h"
 #include "ShaderFactory.h"
 #include "Sound.h"
@@ -162,48 +158,7 @@ void SceneSerializer::auto_serialize_component(YAML::Emitter& out, std::shared_p
     {
         out << YAML::BeginMap;
         // # Put new Drawable kid here
-        if (auto const hittable = std::dynamic_pointer_cast<class Hittable>(component); hittable != nullptr)
-        {
-            // # Put new Hittable kid here
-            if (auto const translatehittable = std::dynamic_pointer_cast<class TranslateHittable>(component); translatehittable != nullptr)
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "TranslateHittableComponent";
-                out << YAML::Key << "guid" << YAML::Value << translatehittable->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << translatehittable->custom_name;
-            }
-            else if (auto const sphereraytraced = std::dynamic_pointer_cast<class SphereRaytraced>(component); sphereraytraced != nullptr)
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "SphereRaytracedComponent";
-                out << YAML::Key << "guid" << YAML::Value << sphereraytraced->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << sphereraytraced->custom_name;
-            }
-            else if (auto const rotateyhittable = std::dynamic_pointer_cast<class RotateYHittable>(component); rotateyhittable != nullptr)
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "RotateYHittableComponent";
-                out << YAML::Key << "guid" << YAML::Value << rotateyhittable->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << rotateyhittable->custom_name;
-            }
-            else if (auto const quadraytraced = std::dynamic_pointer_cast<class QuadRaytraced>(component); quadraytraced != nullptr)
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "QuadRaytracedComponent";
-                out << YAML::Key << "guid" << YAML::Value << quadraytraced->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << quadraytraced->custom_name;
-            }
-            else if (auto const constantdensitymedium = std::dynamic_pointer_cast<class ConstantDensityMedium>(component);
-                     constantdensitymedium != nullptr)
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "ConstantDensityMediumComponent";
-                out << YAML::Key << "guid" << YAML::Value << constantdensitymedium->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << constantdensitymedium->custom_name;
-            }
-            else
-            {
-                out << YAML::Key << "ComponentName" << YAML::Value << "HittableComponent";
-                out << YAML::Key << "guid" << YAML::Value << hittable->guid;
-                out << YAML::Key << "custom_name" << YAML::Value << hittable->custom_name;
-            }
-        }
-        else if (auto const screentext = std::dynamic_pointer_cast<class ScreenText>(component); screentext != nullptr)
+        if (auto const screentext = std::dynamic_pointer_cast<class ScreenText>(component); screentext != nullptr)
         {
             out << YAML::Key << "ComponentName" << YAML::Value << "ScreenTextComponent";
             out << YAML::Key << "guid" << YAML::Value << screentext->guid;
@@ -1710,6 +1665,14 @@ void SceneSerializer::serialize(std::string const& file_path) const
     }
 
     out << YAML::EndSeq;
+
+    // Raytraced hittables are not components, they are stored in their own section next to the entities.
+    if (auto const raytracer = Raytracer::get_instance(); raytracer != nullptr && !raytracer->get_hittables().empty())
+    {
+        out << YAML::Key << "Raytracer" << YAML::Value;
+        RaytracerSerialization::serialize(out, *raytracer);
+    }
+
     out << YAML::EndMap;
 
     std::ofstream scene_file(file_path);
@@ -1803,6 +1766,12 @@ bool SceneSerializer::deserialize(std::string const& file_path)
         }
     }
 
+    if (auto const raytracer_node = data["Raytracer"])
+    {
+        if (auto const raytracer = Raytracer::get_instance(); raytracer != nullptr)
+            return RaytracerSerialization::deserialize(raytracer_node, *raytracer);
+    }
+
     return true;
 }
 